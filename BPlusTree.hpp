@@ -0,0 +1,938 @@
+/**
+  @file BPlusTree.hpp
+
+  @brief File di dichiarazioni/definizioni della classe BPlusTree templata
+*/
+
+#ifndef BPLUSTREE_HPP
+#define BPLUSTREE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <ostream>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "BinarySearchTree.hpp"
+
+/**
+  @brief Indica se un funtore di confronto coincide con l'operatore <
+
+  Se vale true per il funtore Compare di un BPlusTree con chiavi int, la
+  ricerca all'interno dei nodi usa istruzioni SIMD (SSE2 e, se abilitato in
+  compilazione, AVX2) al posto dei confronti scalari.
+  Vale true per std::less; può essere specializzata per altri funtori.
+*/
+template <typename Compare>
+struct natural_order : std::false_type {};
+
+/**
+  @brief std::less coincide con l'operatore <
+*/
+template <typename T>
+struct natural_order<std::less<T> > : std::true_type {};
+
+/**
+  @brief classe BPlusTree
+
+  Albero B+ con nodi ad alto fan-out, alternativa a BinarySearchTree con la
+  stessa interfaccia (insert, remove, contains, size, const_iterator).
+  Ogni nodo contiene fino a NodeKeys chiavi ordinate in un array contiguo:
+  una ricerca visita O(log_NodeKeys n) nodi invece di O(log2 n) e, per chiavi
+  int con natural_order<Compare>, la posizione nel nodo è calcolata con un
+  confronto vettoriale e una movemask invece di un salto per chiave.
+  I valori sono memorizzati solo nelle foglie, collegate tra loro per
+  l'iterazione in ordine.
+
+  T deve essere default-costruibile e assegnabile per copia.
+  Equal viene usato per la verifica finale di contains, come in
+  BinarySearchTree; con compare_equivalence l'uguaglianza è derivata da Compare.
+
+  @tparam NodeKeys numero massimo di chiavi per nodo, pari e almeno 4
+*/
+template <typename T, typename Compare, typename Equal, int NodeKeys = 32>
+class BPlusTree {
+
+    static_assert(NodeKeys >= 4 && NodeKeys % 2 == 0, "NodeKeys deve essere pari e almeno 4");
+
+private:
+    static const int minKeys = NodeKeys / 2; ///< Numero minimo di chiavi di un nodo diverso dalla radice
+    static const int maxDepth = 32;          ///< Limite superiore dell'altezza (ogni nodo interno ha almeno 3 figli)
+
+    /**
+      @brief Parte comune di foglie e nodi interni
+    */
+    struct Node {
+        bool leaf; ///< true se il nodo è una foglia
+        int n;     ///< Numero di chiavi memorizzate
+        T keys[NodeKeys + 1]; ///< Chiavi ordinate (uno slot in più per lo split)
+
+        /**
+         * @brief Costruttore
+         *
+         * @param leaf true per creare una foglia.
+         */
+        explicit Node(bool leaf) : leaf(leaf), n(0) {}
+    };
+
+    /**
+      @brief Foglia: contiene i valori ed è collegata alle foglie vicine
+    */
+    struct Leaf : Node {
+        Leaf *prev; ///< Foglia precedente
+        Leaf *next; ///< Foglia successiva
+
+        /**
+         * @brief Costruttore di default
+         */
+        Leaf() : Node(true), prev(nullptr), next(nullptr) {}
+    };
+
+    /**
+      @brief Nodo interno: n chiavi separatrici e n + 1 figli
+
+      Il figlio i contiene i valori v con keys[i - 1] <= v < keys[i].
+    */
+    struct Inner : Node {
+        Node *children[NodeKeys + 2]; ///< Figli (uno slot in più per lo split)
+
+        /**
+         * @brief Costruttore di default
+         */
+        Inner() : Node(false) {}
+    };
+
+    /**
+      @brief Risultato della divisione di un nodo durante l'inserimento
+    */
+    struct Split {
+        Node *right; ///< Nuovo nodo destro, nullptr se non c'è stata divisione
+        T key;       ///< Chiave separatrice da inserire nel padre
+    };
+
+    /**
+      @brief Nodi allocati prima di un inserimento per le divisioni che causerà
+
+      Allocando tutti i nodi nuovi prima di modificare l'albero, un'eccezione
+      di allocazione lascia l'albero invariato. I nodi non usati vengono
+      deallocati dal distruttore.
+    */
+    struct Spares {
+        Leaf *leaf;               ///< Nuova foglia, se la foglia si divide
+        Inner *inners[maxDepth];  ///< Nuovi nodi interni, compresa l'eventuale nuova radice
+        int count;                ///< Numero di nodi interni allocati
+        int used;                 ///< Numero di nodi interni già usati
+
+        /**
+         * @brief Costruttore di default
+         */
+        Spares() : leaf(nullptr), count(0), used(0) {}
+
+        /**
+         * @brief Distruttore: dealloca i nodi non usati.
+         */
+        ~Spares() {
+            delete leaf;
+            for (int i = used; i < count; ++i) {
+                delete inners[i];
+            }
+        }
+
+        /**
+         * @brief Preleva la nuova foglia.
+         */
+        Leaf *takeLeaf() {
+            Leaf *taken = leaf;
+            leaf = nullptr;
+            return taken;
+        }
+
+        /**
+         * @brief Preleva il prossimo nodo interno.
+         */
+        Inner *takeInner() {
+            return inners[used++];
+        }
+    };
+
+    Node *root;      ///< Radice dell'albero
+    Leaf *head;      ///< Prima foglia
+    Leaf *tail;      ///< Ultima foglia
+    int count;       ///< Numero di valori
+    Compare compare; ///< Funtore di confronto
+    Equal equals;    ///< Funtore di uguaglianza
+
+    /**
+     * @brief Conta il numero di bit a 1.
+     */
+    static int popcount(unsigned mask) {
+#if defined(__GNUC__)
+        return __builtin_popcount(mask);
+#else
+        int bits = 0;
+        for (; mask != 0; mask &= mask - 1) {
+            ++bits;
+        }
+        return bits;
+#endif
+    }
+
+    /**
+     * @brief Conta le chiavi minori (o non maggiori) del valore, con confronti scalari.
+     *
+     * @param keys Chiavi ordinate.
+     * @param n Numero di chiavi.
+     * @param value Valore di riferimento.
+     * @param inclusive true per contare anche le chiavi equivalenti a value.
+     * @return Il numero di chiavi contate.
+     */
+    int rank(const T *keys, int n, const T &value, bool inclusive, std::false_type) const {
+        if (inclusive) {
+            return static_cast<int>(std::upper_bound(keys, keys + n, value, compare) - keys);
+        }
+        return static_cast<int>(std::lower_bound(keys, keys + n, value, compare) - keys);
+    }
+
+    /**
+     * @brief Conta le chiavi int minori (o non maggiori) del valore, con confronti vettoriali.
+     *
+     * Tutte le chiavi del nodo vengono confrontate in blocchi di 8 (AVX2) o 4
+     * (SSE2); il conteggio dei bit della movemask dà direttamente la posizione.
+     *
+     * @param keys Chiavi ordinate.
+     * @param n Numero di chiavi.
+     * @param value Valore di riferimento.
+     * @param inclusive true per contare anche le chiavi uguali a value.
+     * @return Il numero di chiavi contate.
+     */
+    int rank(const T *keys, int n, const T &value, bool inclusive, std::true_type) const {
+        int i = 0;
+        int result = 0;
+#if defined(__AVX2__)
+        const __m256i v8 = _mm256_set1_epi32(value);
+        for (; i + 8 <= n; i += 8) {
+            __m256i k = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(keys + i));
+            // k > value: le chiavi che non vanno contate se inclusive
+            // value > k: le chiavi che vanno contate se !inclusive
+            __m256i mask = inclusive ? _mm256_cmpgt_epi32(k, v8) : _mm256_cmpgt_epi32(v8, k);
+            int bits = popcount(static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(mask))));
+            result += inclusive ? 8 - bits : bits;
+        }
+#endif
+#if defined(__SSE2__)
+        const __m128i v4 = _mm_set1_epi32(value);
+        for (; i + 4 <= n; i += 4) {
+            __m128i k = _mm_loadu_si128(reinterpret_cast<const __m128i *>(keys + i));
+            __m128i mask = inclusive ? _mm_cmpgt_epi32(k, v4) : _mm_cmplt_epi32(k, v4);
+            int bits = popcount(static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(mask))));
+            result += inclusive ? 4 - bits : bits;
+        }
+#endif
+        for (; i < n; ++i) {
+            result += inclusive ? !(value < keys[i]) : keys[i] < value;
+        }
+        return result;
+    }
+
+    /**
+     * @brief Conta le chiavi del nodo minori (o non maggiori) del valore.
+     *
+     * @param node Nodo in cui cercare.
+     * @param value Valore di riferimento.
+     * @param inclusive true per contare anche le chiavi equivalenti a value.
+     * @return Il numero di chiavi contate.
+     */
+    int rank(const Node *node, const T &value, bool inclusive) const {
+        return rank(node->keys, node->n, value, inclusive,
+                    std::integral_constant<bool, natural_order<Compare>::value && std::is_same<T, int>::value>());
+    }
+
+    /**
+     * @brief Verifica l'uguaglianza con il funtore Equal.
+     */
+    bool equivalent(const T &a, const T &b, std::false_type) const {
+        return equals(a, b);
+    }
+
+    /**
+     * @brief Verifica l'equivalenza derivata dal funtore Compare.
+     */
+    bool equivalent(const T &a, const T &b, std::true_type) const {
+        return !compare(a, b) && !compare(b, a);
+    }
+
+    /**
+     * @brief Verifica se due valori sono uguali secondo Equal (o Compare con compare_equivalence).
+     */
+    bool equivalent(const T &a, const T &b) const {
+        return equivalent(a, b, std::integral_constant<bool, std::is_same<Equal, compare_equivalence>::value>());
+    }
+
+    /**
+     * @brief Trova la foglia che può contenere il valore.
+     *
+     * @param value Valore da cercare.
+     * @return La foglia in cui cercare value, nullptr se l'albero è vuoto.
+     */
+    Leaf *findLeaf(const T &value) const {
+        Node *node = root;
+        while (node != nullptr && !node->leaf) {
+            node = static_cast<Inner *>(node)->children[rank(node, value, true)];
+        }
+        return static_cast<Leaf *>(node);
+    }
+
+    /**
+     * @brief Conta i nodi che si divideranno inserendo un valore.
+     *
+     * Si dividono la foglia e i suoi antenati pieni consecutivi.
+     *
+     * @param value Valore da inserire.
+     * @param grow Impostato a true se si divide anche la radice e serve una nuova radice.
+     * @return Il numero di nodi che si divideranno, 0 se il valore è già presente.
+     */
+    int pendingSplits(const T &value, bool &grow) const {
+        int full = 0;
+        int depth = 0;
+        Node *node = root;
+        for (;;) {
+            ++depth;
+            full = node->n == NodeKeys ? full + 1 : 0;
+            if (node->leaf) {
+                break;
+            }
+            node = static_cast<Inner *>(node)->children[rank(node, value, true)];
+        }
+        int pos = rank(node, value, false);
+        if (pos < node->n && !compare(value, node->keys[pos])) {
+            grow = false;
+            return 0;
+        }
+        grow = full == depth;
+        return full;
+    }
+
+    /**
+     * @brief Inserisce ricorsivamente un valore nel sottoalbero.
+     *
+     * @param node Radice del sottoalbero.
+     * @param value Valore da inserire.
+     * @param leaf Impostato alla foglia che contiene il valore.
+     * @param pos Impostato alla posizione del valore nella foglia.
+     * @param inserted Impostato a true se il valore non era presente.
+     * @param spares Nodi preallocati per le divisioni.
+     * @return La divisione da propagare al padre.
+     */
+    Split insertRec(Node *node, const T &value, Leaf *&leaf, int &pos, bool &inserted, Spares &spares) {
+        Split split;
+        split.right = nullptr;
+        if (node->leaf) {
+            leaf = static_cast<Leaf *>(node);
+            pos = rank(node, value, false);
+            if (pos < node->n && !compare(value, node->keys[pos])) {
+                inserted = false;
+                return split;
+            }
+            inserted = true;
+            std::copy_backward(node->keys + pos, node->keys + node->n, node->keys + node->n + 1);
+            node->keys[pos] = value;
+            ++node->n;
+            if (node->n > NodeKeys) {
+                Leaf *right = spares.takeLeaf();
+                int keep = node->n / 2;
+                std::copy(node->keys + keep, node->keys + node->n, right->keys);
+                right->n = node->n - keep;
+                node->n = keep;
+                right->next = leaf->next;
+                right->prev = leaf;
+                if (leaf->next != nullptr) {
+                    leaf->next->prev = right;
+                } else {
+                    tail = right;
+                }
+                leaf->next = right;
+                if (pos >= keep) {
+                    leaf = right;
+                    pos -= keep;
+                }
+                split.right = right;
+                split.key = right->keys[0];
+            }
+            return split;
+        }
+
+        Inner *inner = static_cast<Inner *>(node);
+        int i = rank(node, value, true);
+        Split child = insertRec(inner->children[i], value, leaf, pos, inserted, spares);
+        if (child.right == nullptr) {
+            return split;
+        }
+        std::copy_backward(inner->keys + i, inner->keys + inner->n, inner->keys + inner->n + 1);
+        std::copy_backward(inner->children + i + 1, inner->children + inner->n + 1, inner->children + inner->n + 2);
+        inner->keys[i] = child.key;
+        inner->children[i + 1] = child.right;
+        ++inner->n;
+        if (inner->n > NodeKeys) {
+            Inner *right = spares.takeInner();
+            int mid = inner->n / 2;
+            split.key = inner->keys[mid];
+            std::copy(inner->keys + mid + 1, inner->keys + inner->n, right->keys);
+            std::copy(inner->children + mid + 1, inner->children + inner->n + 1, right->children);
+            right->n = inner->n - mid - 1;
+            inner->n = mid;
+            split.right = right;
+        }
+        return split;
+    }
+
+    /**
+     * @brief Unisce il figlio idx + 1 nel figlio idx di un nodo interno.
+     *
+     * @param parent Nodo interno.
+     * @param idx Indice del figlio sinistro.
+     */
+    void mergeChildren(Inner *parent, int idx) {
+        Node *left = parent->children[idx];
+        Node *right = parent->children[idx + 1];
+        if (left->leaf) {
+            std::copy(right->keys, right->keys + right->n, left->keys + left->n);
+            left->n += right->n;
+            Leaf *l = static_cast<Leaf *>(left);
+            Leaf *r = static_cast<Leaf *>(right);
+            l->next = r->next;
+            if (r->next != nullptr) {
+                r->next->prev = l;
+            } else {
+                tail = l;
+            }
+            delete r;
+        } else {
+            Inner *l = static_cast<Inner *>(left);
+            Inner *r = static_cast<Inner *>(right);
+            l->keys[l->n] = parent->keys[idx];
+            std::copy(r->keys, r->keys + r->n, l->keys + l->n + 1);
+            std::copy(r->children, r->children + r->n + 1, l->children + l->n + 1);
+            l->n += r->n + 1;
+            delete r;
+        }
+        std::copy(parent->keys + idx + 1, parent->keys + parent->n, parent->keys + idx);
+        std::copy(parent->children + idx + 2, parent->children + parent->n + 1, parent->children + idx + 1);
+        --parent->n;
+    }
+
+    /**
+     * @brief Ripristina il numero minimo di chiavi del figlio i di un nodo interno.
+     *
+     * Prende in prestito una chiave da un fratello se possibile, altrimenti
+     * unisce il figlio a un fratello.
+     *
+     * @param parent Nodo interno.
+     * @param i Indice del figlio sotto il minimo.
+     */
+    void fixChild(Inner *parent, int i) {
+        Node *child = parent->children[i];
+        Node *left = i > 0 ? parent->children[i - 1] : nullptr;
+        Node *right = i < parent->n ? parent->children[i + 1] : nullptr;
+        if (left != nullptr && left->n > minKeys) {
+            std::copy_backward(child->keys, child->keys + child->n, child->keys + child->n + 1);
+            if (child->leaf) {
+                child->keys[0] = left->keys[left->n - 1];
+                parent->keys[i - 1] = child->keys[0];
+            } else {
+                Inner *c = static_cast<Inner *>(child);
+                Inner *l = static_cast<Inner *>(left);
+                std::copy_backward(c->children, c->children + c->n + 1, c->children + c->n + 2);
+                c->keys[0] = parent->keys[i - 1];
+                c->children[0] = l->children[l->n];
+                parent->keys[i - 1] = l->keys[l->n - 1];
+            }
+            ++child->n;
+            --left->n;
+        } else if (right != nullptr && right->n > minKeys) {
+            if (child->leaf) {
+                child->keys[child->n] = right->keys[0];
+                std::copy(right->keys + 1, right->keys + right->n, right->keys);
+                parent->keys[i] = right->keys[0];
+            } else {
+                Inner *c = static_cast<Inner *>(child);
+                Inner *r = static_cast<Inner *>(right);
+                c->keys[c->n] = parent->keys[i];
+                c->children[c->n + 1] = r->children[0];
+                parent->keys[i] = r->keys[0];
+                std::copy(r->keys + 1, r->keys + r->n, r->keys);
+                std::copy(r->children + 1, r->children + r->n + 1, r->children);
+            }
+            ++child->n;
+            --right->n;
+        } else if (left != nullptr) {
+            mergeChildren(parent, i - 1);
+        } else {
+            mergeChildren(parent, i);
+        }
+    }
+
+    /**
+     * @brief Rimuove ricorsivamente un valore dal sottoalbero.
+     *
+     * @param node Radice del sottoalbero.
+     * @param value Valore da rimuovere.
+     * @return true se il valore era presente.
+     */
+    bool removeRec(Node *node, const T &value) {
+        if (node->leaf) {
+            int pos = rank(node, value, false);
+            if (pos == node->n || compare(value, node->keys[pos])) {
+                return false;
+            }
+            std::copy(node->keys + pos + 1, node->keys + node->n, node->keys + pos);
+            --node->n;
+            return true;
+        }
+        Inner *inner = static_cast<Inner *>(node);
+        int i = rank(node, value, true);
+        if (!removeRec(inner->children[i], value)) {
+            return false;
+        }
+        if (inner->children[i]->n < minKeys) {
+            fixChild(inner, i);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Dealloca ricorsivamente il sottoalbero (profondità O(log n)).
+     *
+     * @param node Radice del sottoalbero.
+     */
+    static void deleteSubtree(Node *node) {
+        if (node == nullptr) {
+            return;
+        }
+        if (node->leaf) {
+            delete static_cast<Leaf *>(node);
+        } else {
+            Inner *inner = static_cast<Inner *>(node);
+            for (int i = 0; i <= inner->n; ++i) {
+                deleteSubtree(inner->children[i]);
+            }
+            delete inner;
+        }
+    }
+
+public:
+    /**
+     * @brief Iteratore costante per l'albero B+.
+     */
+    class const_iterator {
+    public:
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const T *pointer;
+        typedef const T &reference;
+
+        /**
+         * @brief Costruttore di default.
+         */
+        const_iterator() : leaf(nullptr), pos(0), tree(nullptr) {}
+
+        /**
+         * @brief Dereferenzia l'iteratore.
+         *
+         * @return Il riferimento al valore puntato dall'iteratore.
+         */
+        reference operator*() const {
+            return leaf->keys[pos];
+        }
+
+        /**
+         * @brief Accede al membro puntato dall'iteratore.
+         *
+         * @return Un puntatore al valore puntato dall'iteratore.
+         */
+        pointer operator->() const {
+            return &leaf->keys[pos];
+        }
+
+        /**
+         * @brief Operatore di pre-incremento.
+         *
+         * @return Un riferimento all'iteratore avanzato.
+         */
+        const_iterator &operator++() {
+            if (leaf != nullptr && ++pos == leaf->n) {
+                leaf = leaf->next;
+                pos = 0;
+            }
+            return *this;
+        }
+
+        /**
+         * @brief Operatore di post-incremento.
+         *
+         * @return L'iteratore alla posizione precedente.
+         */
+        const_iterator operator++(int) {
+            const_iterator tmp(*this);
+            ++(*this);
+            return tmp;
+        }
+
+        /**
+         * @brief Operatore di pre-decremento.
+         *
+         * Decrementare end() porta all'ultimo elemento.
+         *
+         * @return Un riferimento all'iteratore spostato.
+         */
+        const_iterator &operator--() {
+            if (leaf == nullptr) {
+                leaf = tree != nullptr ? tree->tail : nullptr;
+                pos = leaf != nullptr ? leaf->n - 1 : 0;
+            } else if (pos > 0) {
+                --pos;
+            } else {
+                leaf = leaf->prev;
+                pos = leaf != nullptr ? leaf->n - 1 : 0;
+            }
+            return *this;
+        }
+
+        /**
+         * @brief Operatore di post-decremento.
+         *
+         * @return L'iteratore alla posizione corrente prima dello spostamento.
+         */
+        const_iterator operator--(int) {
+            const_iterator tmp(*this);
+            --(*this);
+            return tmp;
+        }
+
+        /**
+         * @brief Operatore di uguaglianza.
+         *
+         * @param other L'iteratore da confrontare.
+         * @return true se gli iteratori sono uguali, false altrimenti.
+         */
+        bool operator==(const const_iterator &other) const {
+            return leaf == other.leaf && pos == other.pos;
+        }
+
+        /**
+         * @brief Operatore di disuguaglianza.
+         *
+         * @param other L'iteratore da confrontare.
+         * @return true se gli iteratori sono diversi, false altrimenti.
+         */
+        bool operator!=(const const_iterator &other) const {
+            return !(*this == other);
+        }
+
+    private:
+        const Leaf *leaf;       ///< Foglia corrente, nullptr per la fine
+        int pos;                ///< Posizione nella foglia
+        const BPlusTree *tree;  ///< Albero a cui appartiene l'iteratore
+
+        /**
+         * @brief Costruttore privato per inizializzare un iteratore a una posizione specifica.
+         *
+         * @param leaf La foglia (nullptr per la fine).
+         * @param pos La posizione nella foglia.
+         * @param tree L'albero a cui appartiene la foglia.
+         */
+        const_iterator(const Leaf *leaf, int pos, const BPlusTree *tree) : leaf(leaf), pos(pos), tree(tree) {}
+
+        friend class BPlusTree;
+    };
+
+    /**
+      @brief Costruttore di default
+
+      Inizializza un albero vuoto.
+     */
+    BPlusTree() : root(nullptr), head(nullptr), tail(nullptr), count(0) {}
+
+    /**
+     * @brief Costruttore tramite iteratori.
+     *
+     * @tparam Iter tipo dell'iteratore
+     * @param begin iteratore di inizio sequenza
+     * @param end iteratore di fine sequenza
+     *
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    template <typename Iter>
+    BPlusTree(Iter begin, Iter end) : root(nullptr), head(nullptr), tail(nullptr), count(0) {
+        try {
+            for (Iter it = begin; it != end; ++it) {
+                insert(*it);
+            }
+        } catch (...) {
+            clear();
+            throw;
+        }
+    }
+
+    /**
+     * @brief Copy constructor
+     *
+     * @param other Albero da copiare
+     *
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    BPlusTree(const BPlusTree &other)
+        : root(nullptr), head(nullptr), tail(nullptr), count(0), compare(other.compare), equals(other.equals) {
+        try {
+            for (const_iterator it = other.begin(); it != other.end(); ++it) {
+                insertHint(*it);
+            }
+        } catch (...) {
+            clear();
+            throw;
+        }
+    }
+
+    /**
+     * @brief Move constructor
+     *
+     * @param other Albero da spostare
+     *
+     * @post other è vuoto
+     */
+    BPlusTree(BPlusTree &&other)
+        : root(other.root), head(other.head), tail(other.tail), count(other.count), compare(other.compare),
+          equals(other.equals) {
+        other.root = nullptr;
+        other.head = other.tail = nullptr;
+        other.count = 0;
+    }
+
+    /**
+     * @brief Distruttore
+     */
+    ~BPlusTree() {
+        clear();
+    }
+
+    /**
+     * @brief Operatore di assegnamento
+     *
+     * @param other Albero da copiare (o spostare)
+     * @return reference all'albero this
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    BPlusTree &operator=(BPlusTree other) {
+        swap(other);
+        return *this;
+    }
+
+    /**
+     * @brief Scambia il contenuto di due alberi in O(1).
+     *
+     * @param other Albero con cui scambiare il contenuto.
+     */
+    void swap(BPlusTree &other) {
+        std::swap(root, other.root);
+        std::swap(head, other.head);
+        std::swap(tail, other.tail);
+        std::swap(count, other.count);
+        std::swap(compare, other.compare);
+        std::swap(equals, other.equals);
+    }
+
+    /**
+     * @brief Inserisce un valore.
+     *
+     * @param value Il valore da inserire.
+     * I nodi creati dalle eventuali divisioni vengono allocati prima di
+     * modificare l'albero: se l'allocazione (o il costruttore di T) lancia
+     * un'eccezione l'albero resta invariato.
+     *
+     * @param value Il valore da inserire.
+     * @return Una coppia con l'iteratore al valore equivalente nell'albero e
+     *         true se il valore è stato inserito, false se era già presente.
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    std::pair<const_iterator, bool> insert(const T &value) {
+        if (root == nullptr) {
+            Leaf *leaf = new Leaf();
+            try {
+                leaf->keys[0] = value;
+            } catch (...) {
+                delete leaf;
+                throw;
+            }
+            leaf->n = 1;
+            root = head = tail = leaf;
+            count = 1;
+            return std::make_pair(const_iterator(leaf, 0, this), true);
+        }
+        Spares spares;
+        bool grow;
+        int splits = pendingSplits(value, grow);
+        if (splits > 0) {
+            spares.leaf = new Leaf();
+        }
+        for (int i = grow ? 0 : 1; i < splits; ++i) {
+            spares.inners[spares.count++] = new Inner();
+        }
+        Leaf *leaf;
+        int pos;
+        bool inserted;
+        Split split = insertRec(root, value, leaf, pos, inserted, spares);
+        if (split.right != nullptr) {
+            Inner *newRoot = spares.takeInner();
+            newRoot->keys[0] = split.key;
+            newRoot->children[0] = root;
+            newRoot->children[1] = split.right;
+            newRoot->n = 1;
+            root = newRoot;
+        }
+        if (inserted) {
+            ++count;
+        }
+        return std::make_pair(const_iterator(leaf, pos, this), inserted);
+    }
+
+    /**
+     * @brief Verifica se un valore è presente nell'albero.
+     *
+     * @param value Il valore da cercare.
+     * @return true se il valore è presente, false altrimenti.
+     */
+    bool contains(const T &value) const {
+        const Leaf *leaf = findLeaf(value);
+        if (leaf == nullptr) {
+            return false;
+        }
+        int pos = rank(leaf, value, false);
+        return pos < leaf->n && equivalent(value, leaf->keys[pos]);
+    }
+
+    /**
+     * @brief Rimuove un valore dall'albero, se presente.
+     *
+     * @param value Il valore da rimuovere.
+     */
+    void remove(const T &value) {
+        if (root == nullptr || !removeRec(root, value)) {
+            return;
+        }
+        --count;
+        if (root->n == 0) {
+            Node *old = root;
+            if (root->leaf) {
+                root = nullptr;
+                head = tail = nullptr;
+                delete static_cast<Leaf *>(old);
+            } else {
+                root = static_cast<Inner *>(old)->children[0];
+                delete static_cast<Inner *>(old);
+            }
+        }
+    }
+
+    /**
+     * @brief Restituisce il numero di valori.
+     *
+     * @return Il numero di valori presenti nell'albero.
+     */
+    int size() const {
+        return count;
+    }
+
+    /**
+     * @brief Cancella tutti i valori dell'albero.
+     */
+    void clear() {
+        deleteSubtree(root);
+        root = nullptr;
+        head = tail = nullptr;
+        count = 0;
+    }
+
+    /**
+     * @brief Restituisce un iteratore costante all'inizio dell'albero.
+     *
+     * @return Un iteratore costante al primo elemento dell'albero.
+     */
+    const_iterator begin() const {
+        return const_iterator(head, 0, this);
+    }
+
+    /**
+     * @brief Restituisce un iteratore costante alla fine dell'albero.
+     *
+     * @return Un iteratore costante alla posizione successiva all'ultimo elemento.
+     */
+    const_iterator end() const {
+        return const_iterator(nullptr, 0, this);
+    }
+
+    /**
+     * @brief Iteratore inverso costante.
+     */
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    /**
+     * @brief Restituisce un iteratore inverso costante all'ultimo elemento dell'albero.
+     *
+     * @return Un iteratore inverso costante all'ultimo elemento dell'albero.
+     */
+    const_reverse_iterator rbegin() const {
+        return const_reverse_iterator(end());
+    }
+
+    /**
+     * @brief Restituisce un iteratore inverso costante alla posizione precedente al primo elemento.
+     *
+     * @return Un iteratore inverso costante alla posizione precedente al primo elemento.
+     */
+    const_reverse_iterator rend() const {
+        return const_reverse_iterator(begin());
+    }
+
+    /**
+     * @brief Funzione amica per la stampa dell'albero.
+     *
+     * @param os Stream di output.
+     * @param tree Albero da stampare.
+     * @return Lo stream di output.
+     */
+    friend std::ostream &operator<<(std::ostream &os, const BPlusTree &tree) {
+        for (const_iterator it = tree.begin(); it != tree.end(); ++it) {
+            os << *it << " ";
+        }
+        return os;
+    }
+
+private:
+    /**
+     * @brief Inserisce un valore maggiore di tutti quelli presenti.
+     *
+     * Usato dalla copia, che riceve i valori in ordine crescente.
+     *
+     * @param value Valore da inserire.
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    void insertHint(const T &value) {
+        if (tail != nullptr && tail->n < NodeKeys) {
+            tail->keys[tail->n++] = value;
+            ++count;
+            return;
+        }
+        insert(value);
+    }
+};
+
+#endif // BPLUSTREE_HPP
@@ -8,583 +8,4278 @@
 #define BINARYSEARCHTREE_HPP
 
 #include <algorithm>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <future>
 #include <iostream>
+#include <istream>
+#include <iterator>
+#include <limits>
+#include <locale>
+#include <memory>
+#include <mutex>
+#include <new>
 #include <ostream>
+#include <sstream>
+#include <streambuf>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "FrozenBinarySearchTree.hpp"
+#include "PoolAllocator.hpp"
 
 /**
-  @brief classe BinarySearchTree
+  @brief Politica di bilanciamento nulla
 
-  La classe implementa un generico albero binario di ricerca di oggetti T.
-  L'ordinamento è realizzato tramite il funtore Compare che prende
-  due valori a e b, e ritorna vero se a viene prima di b.
-  La valutazione di uguaglianza è realizzata tramite un secondo funtore Equal.
+  L'albero non viene mai ribilanciato: la sua forma dipende solo dall'ordine
+  con cui i valori vengono inseriti. È la politica di default.
 */
-template <typename T, typename Compare, typename Equal>
-class BinarySearchTree {
+struct no_balance {
+    static const bool enabled = false; ///< Nessun ribilanciamento
 
-private:
     /**
-      @brief struttura Nodo
+      @brief Dati aggiuntivi memorizzati in ogni nodo (nessuno)
+    */
+    struct node_data {};
 
-      Struttura dati nodo interna che viene usata per creare
-      e popolare l'albero.
+    /**
+     * @brief Aggiorna i dati del nodo a partire dai figli (nessuna operazione).
+     */
+    template <typename N>
+    static void update(N *) {}
+
+    /**
+     * @brief Fattore di bilanciamento del nodo (sempre 0).
+     */
+    template <typename N>
+    static int factor(const N *) {
+        return 0;
+    }
+};
+
+/**
+  @brief Politica di bilanciamento AVL
+
+  Ogni nodo memorizza l'altezza del proprio sottoalbero; dopo ogni inserimento
+  e rimozione l'albero viene ribilanciato tramite rotazioni in modo che le
+  altezze dei due figli di ogni nodo differiscano al più di 1.
+  Inserimento, rimozione e ricerca costano O(log n) nel caso peggiore.
+*/
+struct avl_balance {
+    static const bool enabled = true; ///< Ribilanciamento attivo
+
+    /**
+      @brief Dati aggiuntivi memorizzati in ogni nodo
     */
-    struct Node {
-        const T value; ///< Valore del nodo
-        Node *left;    ///< Puntatore al figlio sinistro
-        Node *right;   ///< Puntatore al figlio destro
+    struct node_data {
+        int height; ///< Altezza del sottoalbero radicato nel nodo
 
         /**
          * @brief Costruttore di default
          *
-         * Inizializza un nodo con valore di default e puntatori a nullptr.
-         *
-         * @post left == nullptr
-         * @post right == nullptr
+         * @post height == 1
          */
-        Node() : left(nullptr), right(nullptr) {}
+        node_data() : height(1) {}
+    };
 
-        /**
-         * @brief Costruttore secondario
-         *
-         * Inizializza un nodo con il valore specificato e puntatori ai figli specificati.
-         *
-         * @param v Valore da memorizzare nel nodo.
-         * @param l Puntatore al figlio sinistro.
-         * @param r Puntatore al figlio destro.
-         */
-        Node(const T &v, Node *l, Node *r) : value(v), left(l), right(r) {}
+    /**
+     * @brief Restituisce l'altezza di un sottoalbero.
+     *
+     * @param n Radice del sottoalbero (può essere nullptr).
+     * @return L'altezza del sottoalbero, 0 se vuoto.
+     */
+    template <typename N>
+    static int height(const N *n) {
+        return n ? n->height : 0;
+    }
+
+    /**
+     * @brief Ricalcola l'altezza del nodo a partire da quella dei figli.
+     *
+     * @param n Nodo da aggiornare.
+     */
+    template <typename N>
+    static void update(N *n) {
+        n->height = 1 + std::max(height(n->left), height(n->right));
+    }
+
+    /**
+     * @brief Fattore di bilanciamento del nodo.
+     *
+     * @param n Nodo da valutare.
+     * @return Differenza tra l'altezza del figlio sinistro e quella del figlio destro.
+     */
+    template <typename N>
+    static int factor(const N *n) {
+        return height(n->left) - height(n->right);
+    }
+};
+
+/**
+  @brief Nessuna augmentazione dei nodi
+
+  I nodi non memorizzano informazioni aggiuntive. È l'augmentazione di default.
+*/
+struct no_augment {
+    static const bool enabled = false; ///< Nessuna informazione aggiuntiva
+
+    /**
+      @brief Dati aggiuntivi memorizzati in ogni nodo (nessuno)
+    */
+    struct node_data {};
+
+    /**
+     * @brief Aggiorna i dati del nodo a partire dai figli (nessuna operazione).
+     */
+    template <typename N>
+    static void update(N *) {}
+};
+
+/**
+  @brief Augmentazione con la dimensione dei sottoalberi
+
+  Ogni nodo memorizza il numero di nodi del proprio sottoalbero. Abilita le
+  operazioni di order statistic rank, select e count_range in O(altezza),
+  cioè O(log n) se combinata con avl_balance.
+*/
+struct size_augment {
+    static const bool enabled = true; ///< Dimensione dei sottoalberi memorizzata
+
+    /**
+      @brief Dati aggiuntivi memorizzati in ogni nodo
+    */
+    struct node_data {
+        int count; ///< Numero di nodi del sottoalbero radicato nel nodo
 
         /**
-         * @brief Copy constructor
-         *
-         * Costruisce un nuovo nodo come copia di un altro nodo.
+         * @brief Costruttore di default
          *
-         * @param other Nodo da copiare
+         * @post count == 1
          */
-        Node(const Node &other) : value(other.value), left(nullptr), right(nullptr) {}
+        node_data() : count(1) {}
     };
 
-    Node *root;      ///< Puntatore alla radice dell'albero
-    Compare compare; ///< Funtore di confronto
-    Equal equals;    ///< Funtore di uguaglianza
+    /**
+     * @brief Restituisce la dimensione di un sottoalbero.
+     *
+     * @param n Radice del sottoalbero (può essere nullptr).
+     * @return Il numero di nodi del sottoalbero, 0 se vuoto.
+     */
+    template <typename N>
+    static int count(const N *n) {
+        return n ? n->count : 0;
+    }
 
     /**
-     * @brief Visita ricorsivamente l'albero in ordine e stampa i valori.
+     * @brief Ricalcola la dimensione del sottoalbero a partire da quella dei figli.
      *
-     * @param os Stream di output.
-     * @param node Nodo radice del sottoalbero da visitare.
+     * @param n Nodo da aggiornare.
      */
-    void toString(std::ostream &os, const Node *node) const {
-        if (node != nullptr) {
-            toString(os, node->left);
-            os << node->value << " ";
-            toString(os, node->right);
-        }
+    template <typename N>
+    static void update(N *n) {
+        n->count = 1 + count(n->left) + count(n->right);
     }
+};
+
+/**
+  @brief Uguaglianza derivata dal funtore di confronto
+
+  Usato come parametro Equal, indica all'albero di considerare equivalenti due
+  valori a e b quando né compare(a, b) né compare(b, a) sono veri, senza usare
+  un secondo funtore. Le ricerche eseguono così un solo confronto per livello.
+  Se il funtore Compare fornisce anche un metodo
+  <tt>int three_way(const T &a, const T &b) const</tt> (negativo, zero o positivo
+  se a precede, è equivalente o segue b), questo viene usato al posto delle
+  due chiamate a compare.
+*/
+struct compare_equivalence {};
+
+/**
+  @brief Verifica se il funtore Compare fornisce il confronto a tre vie three_way
+*/
+template <typename Compare, typename T>
+struct has_three_way {
+private:
+    template <typename C>
+    static auto test(int) -> decltype(std::declval<const C &>().three_way(std::declval<const T &>(), std::declval<const T &>()),
+                                      std::true_type());
+
+    template <typename C>
+    static std::false_type test(...);
+
+public:
+    static const bool value = decltype(test<Compare>(0))::value; ///< true se three_way è disponibile
+};
+
+/**
+  @brief Tag per i costruttori che ricevono una sequenza ordinata senza duplicati
+*/
+struct sorted_unique_t {};
 
+/**
+  @brief Istanza del tag sorted_unique_t
+*/
+const sorted_unique_t sorted_unique = sorted_unique_t();
+
+/**
+  @brief Codifica a lunghezza variabile (varint) degli interi senza segno
+
+  Ogni byte porta 7 bit del valore, dal meno significativo; il bit alto indica
+  che segue un altro byte. Usata dai codec di bst_codec e disponibile per
+  quelli definiti dall'utente.
+*/
+struct bst_varint {
     /**
-     * @brief Calcola ricorsivamente la dimensione del sottoalbero.
+     * @brief Accoda la codifica di un valore.
      *
-     * @param node Nodo radice del sottoalbero.
-     * @return La dimensione del sottoalbero.
+     * @param value Valore da codificare.
+     * @param out Buffer a cui accodare i byte.
      */
-    int size(const Node *node) const {
-        if (node == nullptr) {
-            return 0;
+    static void put(std::uint64_t value, std::string &out) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
         }
-        return 1 + size(node->left) + size(node->right);
+        out.push_back(static_cast<char>(value));
     }
 
     /**
-     * @brief Rimuove ricorsivamente il nodo con il valore specificato dall'albero.
+     * @brief Legge un valore.
      *
-     * @param node Puntatore al nodo radice del sottoalbero corrente.
-     * @param value Valore da rimuovere.
+     * @param pos Posizione del primo byte, avanzata oltre il valore letto.
+     * @param end Fine dei byte disponibili.
+     * @return Il valore letto.
+     * @throw std::runtime_error se i byte finiscono prima del valore o il valore supera 64 bit
      */
-    void deleteNode(Node *&node, const T &value) {
-        if (node == nullptr) {
-            return;
-        }
-        if (compare(value, node->value)) {
-            deleteNode(node->left, value);
-        } else if (compare(node->value, value)) {
-            deleteNode(node->right, value);
-        } else {
-            if (node->left == nullptr) {
-                Node *temp = node->right;
-                delete node;
-                node = temp;
-            } else if (node->right == nullptr) {
-                Node *temp = node->left;
-                delete node;
-                node = temp;
-            } else {
-                Node *temp = node->right;
-                while (temp->left != nullptr) {
-                    temp = temp->left;
-                }
-                Node *newNode = new Node(temp->value, node->left, node->right);
-                delete node;
-                node = newNode;
-                deleteNode(node->right, temp->value);
+    static std::uint64_t get(const char *&pos, const char *end) {
+        std::uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (pos == end) {
+                throw std::runtime_error("deserialize: varint troncato");
+            }
+            unsigned char byte = static_cast<unsigned char>(*pos++);
+            value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+            if (byte < 0x80) {
+                return value;
             }
         }
+        throw std::runtime_error("deserialize: varint troppo lungo");
     }
+};
+
+/**
+  @brief Codec dei valori per BinarySearchTree::serialize e deserialize
+
+  Un codec fornisce encode(value, out), che accoda a out i byte del valore, e
+  decode(pos, end), che legge un valore avanzando pos senza superare end. I
+  valori vengono codificati in ordine crescente e un'istanza del codec è
+  usata per un intero flusso, per cui può ricordare il valore precedente.
+  La versione generica copia i byte dei tipi banalmente copiabili; per gli
+  altri tipi va specializzata.
+*/
+template <typename T, typename Enable = void>
+struct bst_codec {
+    static_assert(std::is_trivially_copyable<T>::value, "bst_codec va specializzato per i tipi non banalmente copiabili");
 
     /**
-     * @brief Cancella ricorsivamente tutti i nodi dell'albero.
-     *
-     * @param node Nodo radice del sottoalbero da cancellare.
+     * @brief Accoda i byte del valore.
      */
-    void deleteSubtree(Node *node) {
-        if (node != nullptr) {
-            deleteSubtree(node->left);
-            deleteSubtree(node->right);
-            delete node;
-        }
+    void encode(const T &value, std::string &out) {
+        out.append(reinterpret_cast<const char *>(&value), sizeof(T));
     }
 
     /**
-     * @brief Crea una copia ricorsiva del sottoalbero.
+     * @brief Legge un valore.
      *
-     * @param node Nodo radice del sottoalbero da copiare.
-     * @return Puntatore alla radice del sottoalbero copiato.
+     * @throw std::runtime_error se i byte disponibili non bastano
      */
-    Node *copyNodes(Node *node) const {
-        if (node == nullptr) {
-            return nullptr;
+    T decode(const char *&pos, const char *end) {
+        if (static_cast<std::size_t>(end - pos) < sizeof(T)) {
+            throw std::runtime_error("deserialize: valore troncato");
         }
-        Node *newNode = new Node(node->value, nullptr, nullptr);
-        newNode->left = copyNodes(node->left);
-        newNode->right = copyNodes(node->right);
-        return newNode;
+        T value;
+        std::memcpy(&value, pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
     }
+};
+
+/**
+  @brief Codec degli interi: differenza dal valore precedente in zigzag e varint
+
+  In un flusso ordinato le differenze sono piccole e occupano pochi byte;
+  lo zigzag rende compatte anche le differenze negative, che compaiono se
+  Compare non è l'ordine crescente.
+*/
+template <typename T>
+struct bst_codec<T, typename std::enable_if<std::is_integral<T>::value>::type> {
+    std::uint64_t previous; ///< Valore precedente del flusso
 
     /**
-     * @brief Trova ricorsivamente il nodo con il valore specificato.
-     *
-     * @param node Nodo radice del sottoalbero corrente.
-     * @param value Valore da cercare.
-     * @return Puntatore al nodo con il valore specificato, se presente; nullptr altrimenti.
+     * @brief Costruttore: il primo valore è codificato come differenza da 0.
      */
-    Node *findNode(Node *node, const T &value) const {
-        if (!node)
-            return nullptr;
-        if (equals(value, node->value))
-            return node;
-        if (compare(value, node->value))
-            return findNode(node->left, value);
-        return findNode(node->right, value);
-    }
+    bst_codec() : previous(0) {}
 
-public:
     /**
-      @brief Costruttore di default
+     * @brief Accoda la differenza dal valore precedente.
+     */
+    void encode(const T &value, std::string &out) {
+        std::uint64_t current = static_cast<std::uint64_t>(static_cast<std::int64_t>(value));
+        std::uint64_t delta = current - previous;
+        bst_varint::put((delta << 1) ^ (0 - (delta >> 63)), out);
+        previous = current;
+    }
 
-      Inizializza un albero binario di ricerca vuoto.
+    /**
+     * @brief Legge un valore sommando la differenza al precedente.
+     *
+     * @throw std::runtime_error se i byte disponibili non bastano
+     */
+    T decode(const char *&pos, const char *end) {
+        std::uint64_t zigzag = bst_varint::get(pos, end);
+        previous += (zigzag >> 1) ^ (0 - (zigzag & 1));
+        return static_cast<T>(static_cast<std::int64_t>(previous));
+    }
+};
 
-      @post root == nullptr
+/**
+  @brief Codec delle stringhe: lunghezza in varint seguita dai caratteri
+*/
+template <>
+struct bst_codec<std::string> {
+    /**
+     * @brief Accoda lunghezza e caratteri.
      */
-    BinarySearchTree() : root(nullptr) {}
+    void encode(const std::string &value, std::string &out) {
+        bst_varint::put(value.size(), out);
+        out.append(value);
+    }
 
     /**
-     * @brief Copy constructor
-     *
-     * Costruisce un nuovo albero binario di ricerca come copia di un altro albero.
+     * @brief Legge una stringa.
      *
-     * @param bst BinarySearchTree da copiare
-     *
-     * @throw std::bad_alloc possibile eccezione di allocazione
+     * @throw std::runtime_error se i byte disponibili non bastano
      */
-    BinarySearchTree(const BinarySearchTree &bst) : root(nullptr), compare(bst.compare), equals(bst.equals) {
-        try {
-            if (bst.root) {
-                root = copyNodes(bst.root);
-            }
-        } catch (...) {
-            clear();
-            throw;
+    std::string decode(const char *&pos, const char *end) {
+        std::uint64_t length = bst_varint::get(pos, end);
+        if (length > static_cast<std::uint64_t>(end - pos)) {
+            throw std::runtime_error("deserialize: stringa troncata");
         }
+        std::string value(pos, static_cast<std::size_t>(length));
+        pos += length;
+        return value;
     }
+};
+
+/**
+  @brief Buffer di output a blocchi per la stampa dei valori
 
+  Accumula il testo in un array interno di 4 KiB e lo passa alla
+  destinazione (uno streambuf o una stringa) solo quando è pieno o alla
+  distruzione, per cui la stampa di molti valori non fa un'operazione di
+  output per valore e non alloca memoria. L'array è piccolo perché vive
+  sullo stack di chi stampa, anche nei thread della stampa parallela; un
+  buffer più grande non rende la stampa più veloce. Gli interi stampati con il
+  formato predefinito vengono convertiti direttamente nel buffer senza
+  passare dalle facet dello stream.
+*/
+class bst_output_buffer : public std::streambuf {
+public:
     /**
-     * @brief Distruttore
-     *
-     * Dealloca tutta la memoria occupata dall'albero binario di ricerca.
+     * @brief Costruttore che scrive su uno streambuf.
      *
-     * @post tutti i nodi dell'albero sono stati deallocati, root = nullptr
+     * @param target Destinazione del testo.
      */
-    ~BinarySearchTree() {
-        clear();
+    explicit bst_output_buffer(std::streambuf *target) : target(target), text(nullptr), failed(target == nullptr) {
+        setp(buffer, buffer + sizeof(buffer));
     }
 
     /**
+     * @brief Costruttore che accoda a una stringa.
      *
-     * @brief Costruttore tramite iteratori.
-     *
-     * Costruttore che crea un binary search tree riempito con dati
-     * presi da una sequenza identificata da un iteratore generico di inizio e uno di fine.
-     *
-     * @tparam Iter tipo dell'iteratore
-     * @param begin iteratore di inizio sequenza
-     * @param end iteratore di fine sequenza
-     *
-     * @throw std::bad_alloc possibile eccezione di allocazione
+     * @param text Stringa a cui accodare il testo.
      */
-    template <typename Iter>
-    BinarySearchTree(Iter begin, Iter end) : root(nullptr) {
-        try {
-            for (Iter it = begin; it != end; ++it) {
-                insert(*it);
-            }
-        } catch (...) {
-            clear();
-            throw;
-        }
+    explicit bst_output_buffer(std::string &text) : target(nullptr), text(&text), failed(false) {
+        setp(buffer, buffer + sizeof(buffer));
     }
 
     /**
-     * @brief Operatore di assegnamento
-     *
-     * Assegna un albero binario di ricerca a un altro.
-     *
-     * @param bst BinarySearchTree da copiare
-     * @return reference all'albero this
-     * @throw std::bad_alloc possibile eccezione di allocazione
+     * @brief Distruttore: passa alla destinazione il testo rimasto.
      */
-    BinarySearchTree &operator=(const BinarySearchTree &bst) {
-        try {
-            if (this != &bst) {
-                BinarySearchTree tmp(bst);
-                std::swap(root, tmp.root);
-                std::swap(compare, tmp.compare);
-                std::swap(equals, tmp.equals);
-            }
-        } catch (...) {
-            clear();
-            throw;
-        }
-        return *this;
+    ~bst_output_buffer() {
+        sync();
     }
 
     /**
-     * @brief Inserisce un valore nell'albero binario di ricerca.
-     *
-     * Aggiunge un nuovo nodo con il valore specificato nell'albero.
+     * @brief Scrive i valori di un intervallo che soddisfano un predicato, ciascuno seguito da uno spazio.
      *
-     * @param value Il valore da inserire.
+     * @param format Stream da cui copiare il formato (flag, precisione, locale).
+     * @param first Inizio dell'intervallo.
+     * @param last Fine dell'intervallo.
+     * @param limit Numero massimo di valori da scrivere.
+     * @param pred Predicato che i valori devono soddisfare.
+     * @param padFirst Se false la larghezza di format viene ignorata, come per
+     *        un segmento che non contiene il primo valore stampato.
+     * @return Il numero di valori scritti.
      */
-    void insert(const T &value) {
-        Node *node = new Node(value, nullptr, nullptr);
-        if (!root) {
-            root = node;
-            return;
+    template <typename Iter, typename P>
+    std::size_t write_range(const std::ostream &format, Iter first, Iter last, std::size_t limit, P pred,
+                            bool padFirst = true) {
+        typedef typename std::iterator_traits<Iter>::value_type value_type;
+        std::ostream out(this);
+        out.copyfmt(format);
+        if (!padFirst) {
+            out.width(0);
         }
-
-        Node *current = root;
-        Node *parent = nullptr;
-
-        while (current != nullptr) {
-            parent = current;
-            if (compare(value, current->value)) {
-                current = current->left;
-            } else if (compare(current->value, value)) {
-                current = current->right;
-            } else {
-                delete node;
-                return;
+        bool direct = plainIntegers<value_type>(out);
+        std::size_t written = 0;
+        for (; first != last && written < limit && !failed; ++first) {
+            if (pred(*first)) {
+                if (direct) {
+                    putInteger(*first);
+                } else {
+                    out << *first;
+                }
+                sputc(' ');
+                ++written;
             }
         }
-
-        if (compare(value, parent->value)) {
-            parent->left = node;
-        } else {
-            parent->right = node;
-        }
+        return written;
     }
 
     /**
-     * @brief Verifica se un valore è presente nell'albero.
+     * @brief Scrive su uno stream i valori di un intervallo che soddisfano un predicato.
      *
-     * Cerca il valore specificato nell'albero.
+     * Si comporta come un operator<< formattato: non scrive nulla se il
+     * sentry di os fallisce, azzera la larghezza dopo la scrittura e imposta
+     * badbit se lo streambuf rifiuta del testo.
      *
-     * @param value Il valore da cercare.
-     * @return true se il valore è presente, false altrimenti.
+     * @param os Stream di output, da cui è copiato anche il formato.
+     * @param first Inizio dell'intervallo.
+     * @param last Fine dell'intervallo.
+     * @param limit Numero massimo di valori da scrivere.
+     * @param pred Predicato che i valori devono soddisfare.
+     * @return Il numero di valori scritti.
      */
-    bool contains(const T &value) const {
-        Node *current = root;
-        while (current != nullptr) {
-            if (equals(value, current->value)) {
-                return true;
-            } else if (compare(value, current->value)) {
-                current = current->left;
-            } else {
-                current = current->right;
-            }
+    template <typename Iter, typename P>
+    static std::size_t write_stream(std::ostream &os, Iter first, Iter last, std::size_t limit, P pred) {
+        std::ostream::sentry ok(os);
+        if (!ok) {
+            return 0;
+        }
+        bst_output_buffer buffer(os.rdbuf());
+        std::size_t written = buffer.write_range(os, first, last, limit, pred);
+        os.width(0);
+        if (!buffer.flush()) {
+            os.setstate(std::ios_base::badbit);
         }
-        return false;
+        return written;
     }
 
     /**
-     * @brief Restituisce la dimensione dell'albero.
-     *
-     * Calcola il numero di nodi presenti nell'albero.
+     * @brief Passa alla destinazione il testo accumulato.
      *
-     * @return Il numero di nodi presenti nell'albero.
+     * @return true se tutto il testo scritto finora è arrivato alla destinazione.
      */
-    int size() const {
-        return size(root);
+    bool flush() {
+        return sync() == 0;
     }
 
+protected:
     /**
-     * @brief Rimuove un valore dall'albero.
-     *
-     * Elimina il nodo con il valore specificato dall'albero, se presente.
-     *
-     * @param value Il valore da rimuovere.
+     * @brief Svuota il buffer pieno e vi scrive il carattere c.
      */
-    void remove(const T &value) {
-        if (root == nullptr) {
-            return;
+    int_type overflow(int_type c) {
+        if (sync() != 0) {
+            return traits_type::eof();
+        }
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
         }
-        deleteNode(root, value);
+        return traits_type::not_eof(c);
     }
 
     /**
-     * @brief Cancella tutti i nodi dell'albero.
-     *
-     * Dealloca tutti i nodi dell'albero, rendendolo vuoto.
+     * @brief Passa il contenuto del buffer alla destinazione.
      */
-    void clear() {
-        deleteSubtree(root);
-        root = nullptr;
+    int sync() {
+        std::ptrdiff_t n = pptr() - pbase();
+        if (n > 0 && !failed) {
+            if (text != nullptr) {
+                text->append(pbase(), static_cast<std::size_t>(n));
+            } else if (target->sputn(pbase(), n) != n) {
+                failed = true;
+            }
+        }
+        setp(buffer, buffer + sizeof(buffer));
+        return failed ? -1 : 0;
     }
 
+private:
+    std::streambuf *target;  ///< Destinazione, se il testo va a uno streambuf
+    std::string *text;       ///< Destinazione, se il testo va a una stringa
+    bool failed;             ///< La destinazione ha rifiutato del testo
+    char buffer[1 << 12];    ///< Testo non ancora passato alla destinazione
+
     /**
-     * @brief Restituisce il sottoalbero cha ha come radice il nodo con il valore specificato.
+     * @brief Indica se i valori sono interi da stampare con il formato predefinito.
      *
-     * Questo metodo cerca il nodo con il valore specificato e restituisce un nuovo albero binario di ricerca
-     * che rappresenta il sottoalbero cha ha come radice il nodo trovato.
-     *
-     * @param value Il valore del nodo radice del sottoalbero da restituire.
-     * @return Un nuovo albero binario di ricerca che rappresenta il sottoalbero radicato nel nodo con il valore specificato.
-     *         Se il valore non è presente nell'albero, viene restituito un albero vuoto.
+     * I tipi di un byte (char, bool) sono esclusi perché lo stream non li stampa come numeri.
      */
-    BinarySearchTree<T, Compare, Equal> subtree(const T &value) const {
-        Node *subRoot = findNode(root, value);
-        BinarySearchTree<T, Compare, Equal> newTree;
-        if (subRoot != nullptr) {
-            newTree.root = copyNodes(subRoot);
-        }
-        return newTree;
+    template <typename V>
+    static bool plainIntegers(const std::ostream &out) {
+        return std::is_integral<V>::value && sizeof(V) > 1 && out.width() == 0 &&
+               (out.flags() & (std::ios_base::basefield | std::ios_base::showpos)) ==
+                   (out.flags() & std::ios_base::dec) &&
+               std::use_facet<std::numpunct<char> >(out.getloc()).grouping().empty();
     }
 
     /**
-     * @brief Funzione amica per la stampa dell'albero.
-     *
-     * Sovraccarica l'operatore di stream per permettere la stampa dell'albero.
-     *
-     * @param os Stream di output.
-     * @param bst Albero binario di ricerca da stampare.
-     * @return Lo stream di output.
+     * @brief Scrive in decimale un intero (ramo non usato per gli altri tipi).
      */
-    friend std::ostream &operator<<(std::ostream &os, const BinarySearchTree &bst) {
-        bst.toString(os, bst.root);
-        return os;
+    template <typename V>
+    void putInteger(const V &value) {
+        putDecimal(value, std::integral_constant<bool, std::is_integral<V>::value>());
+    }
+
+    template <typename V>
+    void putDecimal(const V &, std::false_type) {}
+
+    template <typename V>
+    void putDecimal(V value, std::true_type) {
+        typedef typename std::make_unsigned<V>::type U;
+        char digits[24];
+        char *end = digits + sizeof(digits);
+        char *p = end;
+        U magnitude = static_cast<U>(value);
+        bool negative = std::is_signed<V>::value && (magnitude >> (sizeof(V) * 8 - 1)) != 0;
+        if (negative) {
+            magnitude = static_cast<U>(0 - magnitude);
+        }
+        do {
+            *--p = static_cast<char>('0' + magnitude % 10);
+            magnitude = static_cast<U>(magnitude / 10);
+        } while (magnitude != 0);
+        if (negative) {
+            *--p = '-';
+        }
+        std::ptrdiff_t n = end - p;
+        if (epptr() - pptr() >= n) {
+            std::memcpy(pptr(), p, static_cast<std::size_t>(n));
+            pbump(static_cast<int>(n));
+        } else {
+            sputn(p, n);
+        }
     }
+};
+
+/**
+  @brief classe BinarySearchTree
 
+  La classe implementa un generico albero binario di ricerca di oggetti T.
+  L'ordinamento è realizzato tramite il funtore Compare che prende
+  due valori a e b, e ritorna vero se a viene prima di b.
+  La valutazione di uguaglianza è realizzata tramite un secondo funtore Equal.
+  Il parametro Balance sceglie la politica di bilanciamento (no_balance oppure
+  avl_balance), il parametro Augment le informazioni aggiuntive memorizzate nei
+  nodi (no_augment oppure size_augment). I nodi vengono allocati tramite
+  l'allocatore Alloc (ad esempio PoolAllocator).
+*/
+template <typename T, typename Compare, typename Equal, typename Balance = no_balance, typename Augment = no_augment,
+          typename Alloc = std::allocator<T> >
+class BinarySearchTree {
+
+private:
     /**
-     * @brief Iteratore costante per l'albero binario di ricerca.
-     */
-    class const_iterator {
-    public:
-        typedef std::forward_iterator_tag iterator_category;
-        typedef T value_type;
-        typedef ptrdiff_t difference_type;
-        typedef const T *pointer;
-        typedef const T &reference;
+      @brief Tag per la costruzione sul posto del valore di un nodo
+    */
+    struct EmplaceTag {};
 
-        /**
-         * @brief Costruttore di default.
-         *
-         * Inizializza un iteratore costante.
-         */
-        const_iterator() : n(nullptr), root(nullptr) {}
+    /**
+      @brief struttura Nodo
+
+      Struttura dati nodo interna che viene usata per creare
+      e popolare l'albero.
+    */
+    struct Node : Balance::node_data, Augment::node_data {
+        T value;      ///< Valore del nodo
+        Node *left;    ///< Puntatore al figlio sinistro
+        Node *right;   ///< Puntatore al figlio destro
+        Node *parent;  ///< Puntatore al padre
 
         /**
-         * @brief Costruttore di copia.
+         * @brief Costruttore di default
          *
-         * Inizializza un iteratore costante copiandone un altro.
+         * Inizializza un nodo con valore di default e puntatori a nullptr.
          *
-         * @param other L'iteratore da copiare.
+         * @post left == nullptr
+         * @post right == nullptr
+         * @post parent == nullptr
          */
-        const_iterator(const const_iterator &other) : n(other.n), root(other.root) {}
+        Node() : left(nullptr), right(nullptr), parent(nullptr) {}
 
         /**
-         * @brief Operatore di assegnamento.
+         * @brief Costruttore secondario
          *
-         * Assegna un iteratore costante a un altro.
+         * Inizializza un nodo con il valore specificato e puntatori ai figli specificati.
          *
-         * @param other L'iteratore da copiare.
-         * @return Un riferimento all'iteratore assegnato.
-         */
-        const_iterator &operator=(const const_iterator &other) {
-            n = other.n;
-            root = other.root;
-            return *this;
-        }
-
-        /**
-         * @brief Distruttore.
+         * @param v Valore da memorizzare nel nodo.
+         * @param l Puntatore al figlio sinistro.
+         * @param r Puntatore al figlio destro.
          */
-        ~const_iterator() {}
+        Node(const T &v, Node *l, Node *r) : value(v), left(l), right(r), parent(nullptr) {}
 
         /**
-         * @brief Dereferenzia l'iteratore.
+         * @brief Costruttore secondario con spostamento
          *
-         * @return Il riferimento al valore puntato dall'iteratore.
-         */
-        reference operator*() const {
-            return n->value;
-        }
-
-        /**
-         * @brief Accede al membro puntato dall'iteratore.
+         * Inizializza un nodo spostando al suo interno il valore specificato.
          *
-         * @return Un puntatore al valore puntato dall'iteratore.
+         * @param v Valore da spostare nel nodo.
+         * @param l Puntatore al figlio sinistro.
+         * @param r Puntatore al figlio destro.
          */
-        pointer operator->() const {
-            return &(n->value);
-        }
+        Node(T &&v, Node *l, Node *r) : value(std::move(v)), left(l), right(r), parent(nullptr) {}
 
         /**
-         * @brief Operatore di post-incremento.
+         * @brief Costruttore sul posto
          *
-         * Avanza l'iteratore alla posizione successiva.
+         * Costruisce il valore del nodo direttamente dagli argomenti specificati.
          *
-         * @return L'iteratore alla posizione precedente.
+         * @param args Argomenti per il costruttore di T.
          */
-        const_iterator operator++(int) {
-            const_iterator tmp(*this);
-            ++(*this);
-            return tmp;
-        }
+        template <typename... Args>
+        explicit Node(EmplaceTag, Args &&...args)
+            : value(std::forward<Args>(args)...), left(nullptr), right(nullptr), parent(nullptr) {}
 
         /**
-         * @brief Operatore di pre-incremento.
+         * @brief Copy constructor
          *
-         * Avanza l'iteratore alla posizione successiva.
+         * Costruisce un nuovo nodo come copia di un altro nodo.
          *
-         * @return Un riferimento all'iteratore avanzato.
+         * @param other Nodo da copiare
          */
-        const_iterator &operator++() {
-            if (n == nullptr) {
-                return *this;
-            }
+        Node(const Node &other) : Balance::node_data(other), Augment::node_data(other), value(other.value), left(nullptr), right(nullptr), parent(nullptr) {}
+    };
 
-            if (n->right != nullptr) {
-                n = n->right;
-                while (n->left != nullptr) {
-                    n = n->left;
-                }
-            } else {
-                const Node *parent = nullptr;
-                const Node *current = root;
-                while (current != n) {
-                    if (compare(n->value, current->value)) {
-                        parent = current;
-                        current = current->left;
-                    } else {
-                        current = current->right;
-                    }
-                }
-                n = parent;
+    typedef typename std::allocator_traits<Alloc>::template rebind_alloc<Node> NodeAlloc; ///< Allocatore dei nodi
+    typedef std::allocator_traits<NodeAlloc> NodeTraits;                               ///< Tratti dell'allocatore dei nodi
+
+    Node *root;      ///< Puntatore alla radice dell'albero
+    Node *leftmost;  ///< Puntatore al nodo con il valore minimo
+    Node *rightmost; ///< Puntatore al nodo con il valore massimo
+    int count;       ///< Numero di nodi dell'albero
+    Compare compare; ///< Funtore di confronto
+    Equal equals;    ///< Funtore di uguaglianza
+    NodeAlloc alloc; ///< Allocatore dei nodi
+
+    /**
+     * @brief Alloca e costruisce un nodo.
+     *
+     * @param args Argomenti per il costruttore del nodo.
+     * @return Puntatore al nodo creato.
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    template <typename... Args>
+    Node *createNode(Args &&...args) {
+        Node *node = NodeTraits::allocate(alloc, 1);
+        try {
+            NodeTraits::construct(alloc, node, std::forward<Args>(args)...);
+        } catch (...) {
+            NodeTraits::deallocate(alloc, node, 1);
+            throw;
+        }
+        return node;
+    }
+
+    /**
+     * @brief Distrugge e dealloca un nodo.
+     *
+     * @param node Nodo da distruggere.
+     */
+    void destroyNode(Node *node) {
+        NodeTraits::destroy(alloc, node);
+        NodeTraits::deallocate(alloc, node, 1);
+    }
+
+    /**
+     * @brief Restituisce il nodo successivo in ordine.
+     *
+     * @param node Nodo di partenza.
+     * @return Il nodo successivo, nullptr se node è il massimo.
+     */
+    static Node *successor(const Node *node) {
+        if (node->right != nullptr) {
+            Node *next = node->right;
+            while (next->left != nullptr) {
+                next = next->left;
             }
-            return *this;
+            return next;
+        }
+        Node *parent = node->parent;
+        while (parent != nullptr && node == parent->right) {
+            node = parent;
+            parent = parent->parent;
         }
+        return parent;
+    }
 
-        /**
-         * @brief Operatore di uguaglianza.
-         *
-         * Confronta due iteratori per uguaglianza.
-         *
-         * @param other L'iteratore da confrontare.
-         * @return true se gli iteratori sono uguali, false altrimenti.
-         */
-        bool operator==(const const_iterator &other) const {
-            return n == other.n;
+    /**
+     * @brief Restituisce il nodo precedente in ordine.
+     *
+     * @param node Nodo di partenza.
+     * @return Il nodo precedente, nullptr se node è il minimo.
+     */
+    static Node *predecessor(const Node *node) {
+        if (node->left != nullptr) {
+            Node *prev = node->left;
+            while (prev->right != nullptr) {
+                prev = prev->right;
+            }
+            return prev;
+        }
+        Node *parent = node->parent;
+        while (parent != nullptr && node == parent->left) {
+            node = parent;
+            parent = parent->parent;
         }
+        return parent;
+    }
 
-        /**
-         * @brief Operatore di disuguaglianza.
-         *
-         * Confronta due iteratori per disuguaglianza.
-         *
-         * @param other L'iteratore da confrontare.
-         * @return true se gli iteratori sono diversi, false altrimenti.
-         */
-        bool operator!=(const const_iterator &other) const {
-            return n != other.n;
+    /**
+     * @brief Ricalcola i puntatori al minimo e al massimo scendendo dalla radice.
+     */
+    void updateExtremes() {
+        leftmost = rightmost = root;
+        if (root != nullptr) {
+            while (leftmost->left != nullptr) {
+                leftmost = leftmost->left;
+            }
+            while (rightmost->right != nullptr) {
+                rightmost = rightmost->right;
+            }
         }
+    }
 
-    private:
-        const Node *n;
-        const Node *root;
-        Compare compare;
+    /**
+     * @brief Ricalcola i dati di bilanciamento e di augmentazione del nodo.
+     *
+     * @param node Nodo da aggiornare.
+     */
+    static void updateNode(Node *node) {
+        Balance::update(node);
+        Augment::update(node);
+    }
 
-        /**
-         * @brief Costruttore privato per inizializzare un iteratore con un nodo specifico.
-         *
-         * @param node Il nodo da cui iniziare l'iterazione.
-         * @param root La radice dell'albero.
-         * @param comp Il funtore di confronto.
-         */
-        const_iterator(const Node *node, const Node *root, Compare comp) : n(node), root(root), compare(comp) {}
+    /**
+     * @brief Sostituisce un figlio di un nodo con un altro sottoalbero.
+     *
+     * Se parent è nullptr il sottoalbero sostituito è la radice dell'albero.
+     *
+     * @param parent Padre del nodo da sostituire.
+     * @param oldChild Nodo da sostituire.
+     * @param newChild Nuovo sottoalbero (può essere nullptr).
+     */
+    void replaceChild(Node *parent, Node *oldChild, Node *newChild) {
+        if (parent == nullptr) {
+            root = newChild;
+        } else if (parent->left == oldChild) {
+            parent->left = newChild;
+        } else {
+            parent->right = newChild;
+        }
+        if (newChild != nullptr) {
+            newChild->parent = parent;
+        }
+    }
 
-        friend class BinarySearchTree;
-    };
+    /**
+     * @brief Rotazione a sinistra del sottoalbero radicato in x.
+     *
+     * @param x Radice del sottoalbero, deve avere un figlio destro.
+     * @return La nuova radice del sottoalbero.
+     */
+    Node *rotateLeft(Node *x) {
+        Node *y = x->right;
+        x->right = y->left;
+        if (y->left != nullptr) {
+            y->left->parent = x;
+        }
+        replaceChild(x->parent, x, y);
+        y->left = x;
+        x->parent = y;
+        updateNode(x);
+        updateNode(y);
+        return y;
+    }
 
     /**
-     * @brief Restituisce un iteratore costante all'inizio dell'albero.
+     * @brief Rotazione a destra del sottoalbero radicato in x.
      *
-     * @return Un iteratore costante al primo elemento dell'albero.
+     * @param x Radice del sottoalbero, deve avere un figlio sinistro.
+     * @return La nuova radice del sottoalbero.
      */
-    const_iterator begin() const {
-        const Node *n = root;
-        if (n != nullptr) {
-            while (n->left != nullptr) {
-                n = n->left;
-            }
+    Node *rotateRight(Node *x) {
+        Node *y = x->left;
+        x->left = y->right;
+        if (y->right != nullptr) {
+            y->right->parent = x;
         }
-        return const_iterator(n, root, compare);
+        replaceChild(x->parent, x, y);
+        y->right = x;
+        x->parent = y;
+        updateNode(x);
+        updateNode(y);
+        return y;
     }
 
     /**
-     * @brief Restituisce un iteratore costante alla fine dell'albero.
+     * @brief Ripristina gli invarianti della politica di bilanciamento.
      *
-     * @return Un iteratore costante alla posizione successiva all'ultimo elemento dell'albero.
+     * Risale dal nodo specificato fino alla radice aggiornando i dati dei nodi
+     * ed eseguendo le rotazioni necessarie.
+     *
+     * @param node Primo nodo da aggiornare (può essere nullptr).
      */
-    const_iterator end() const {
-        return const_iterator(nullptr, root, compare);
+    void rebalance(Node *node) {
+        if (!Balance::enabled && !Augment::enabled) {
+            return;
+        }
+        while (node != nullptr) {
+            updateNode(node);
+            int factor = Balance::factor(node);
+            if (factor > 1) {
+                if (Balance::factor(node->left) < 0) {
+                    rotateLeft(node->left);
+                }
+                node = rotateRight(node);
+            } else if (factor < -1) {
+                if (Balance::factor(node->right) > 0) {
+                    rotateRight(node->right);
+                }
+                node = rotateLeft(node);
+            }
+            node = node->parent;
+        }
     }
-};
 
-/**
- * @brief Funzione globale che stampa i valori dell'albero che soddisfano un predicato.
- *
- * @param bst Albero binario di ricerca sorgente.
- * @param pred Predicato da soddisfare.
- */
-template <typename T, typename Comp, typename Equal, typename P>
-void printIF(const BinarySearchTree<T, Comp, Equal> &bst, P pred) {
-    typename BinarySearchTree<T, Comp, Equal>::const_iterator i, ie;
+    /**
+     * @brief Stacca dall'albero il nodo specificato senza deallocarlo.
+     *
+     * Se il nodo ha due figli il suo successore viene staccato dalla propria
+     * posizione e ricollegato al posto del nodo: nessun valore viene copiato e
+     * gli altri nodi (e gli iteratori che vi puntano) restano validi.
+     *
+     * @param node Nodo da staccare, deve appartenere all'albero.
+     * @post node ha figli e padre nulli e i dati di bilanciamento e augmentazione iniziali
+     */
+    void unlinkNode(Node *node) {
+        if (node == leftmost) {
+            leftmost = successor(node);
+        }
+        if (node == rightmost) {
+            rightmost = predecessor(node);
+        }
+        Node *start;
+        if (node->left != nullptr && node->right != nullptr) {
+            Node *next = node->right;
+            while (next->left != nullptr) {
+                next = next->left;
+            }
+            if (next == node->right) {
+                start = next;
+            } else {
+                start = next->parent;
+                start->left = next->right;
+                if (next->right != nullptr) {
+                    next->right->parent = start;
+                }
+                next->right = node->right;
+                next->right->parent = next;
+            }
+            next->left = node->left;
+            next->left->parent = next;
+            replaceChild(node->parent, node, next);
+        } else {
+            start = node->parent;
+            replaceChild(start, node, node->left != nullptr ? node->left : node->right);
+        }
+        node->left = node->right = node->parent = nullptr;
+        static_cast<typename Balance::node_data &>(*node) = typename Balance::node_data();
+        static_cast<typename Augment::node_data &>(*node) = typename Augment::node_data();
+        --count;
+        rebalance(start);
+    }
 
-    for (i = bst.begin(), ie = bst.end(); i != ie; ++i) {
-        if (pred(*i))
-            std::cout << *i << " ";
+    /**
+     * @brief Rimuove il nodo specificato dall'albero.
+     *
+     * @param node Nodo da rimuovere, deve appartenere all'albero.
+     */
+    void deleteNode(Node *node) {
+        unlinkNode(node);
+        destroyNode(node);
     }
+
+    /**
+     * @brief Cancella tutti i nodi di un sottoalbero.
+     *
+     * La visita scende fino a una foglia, la dealloca e risale tramite il
+     * puntatore al padre: lo stack usato non dipende dall'altezza dell'albero.
+     *
+     * @param node Nodo radice del sottoalbero da cancellare.
+     * @param deallocate false per distruggere i valori senza deallocare i nodi.
+     */
+    void deleteSubtree(Node *node, bool deallocate = true) {
+        Node *top = node;
+        while (node != nullptr) {
+            if (node->left != nullptr) {
+                node = node->left;
+            } else if (node->right != nullptr) {
+                node = node->right;
+            } else {
+                Node *parent = node == top ? nullptr : node->parent;
+                if (parent != nullptr) {
+                    if (parent->left == node) {
+                        parent->left = nullptr;
+                    } else {
+                        parent->right = nullptr;
+                    }
+                }
+                if (deallocate) {
+                    destroyNode(node);
+                } else {
+                    NodeTraits::destroy(alloc, node);
+                }
+                node = parent;
+            }
+        }
+    }
+
+    /**
+     * @brief Crea una copia del sottoalbero.
+     *
+     * La visita in preordine del sottoalbero sorgente avanza di pari passo con
+     * quella della copia usando i puntatori al padre, senza ricorsione.
+     * Se un'allocazione fallisce i nodi già copiati vengono deallocati.
+     *
+     * @param node Nodo radice del sottoalbero da copiare.
+     * @param copied Contatore incrementato per ogni nodo copiato.
+     * @return Puntatore alla radice del sottoalbero copiato.
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    Node *copyNodes(const Node *node, int &copied) {
+        if (node == nullptr) {
+            return nullptr;
+        }
+        Node *newRoot = createNode(*node);
+        ++copied;
+        const Node *source = node;
+        Node *target = newRoot;
+        try {
+            while (true) {
+                if (source->left != nullptr && target->left == nullptr) {
+                    target->left = createNode(*source->left);
+                    target->left->parent = target;
+                    ++copied;
+                    source = source->left;
+                    target = target->left;
+                } else if (source->right != nullptr && target->right == nullptr) {
+                    target->right = createNode(*source->right);
+                    target->right->parent = target;
+                    ++copied;
+                    source = source->right;
+                    target = target->right;
+                } else if (source != node) {
+                    source = source->parent;
+                    target = target->parent;
+                } else {
+                    break;
+                }
+            }
+        } catch (...) {
+            deleteSubtree(newRoot);
+            throw;
+        }
+        return newRoot;
+    }
+
+    /**
+     * @brief Costruisce un sottoalbero bilanciato da una sequenza ordinata.
+     *
+     * Consuma n valori in ordine crescente dall'iteratore it; la radice di ogni
+     * sottoalbero è l'elemento centrale, per cui le dimensioni dei due figli
+     * differiscono al più di 1. Il costo è O(n), la ricorsione ha profondità O(log n).
+     *
+     * @param it Iteratore al prossimo valore da consumare, viene avanzato.
+     * @param n Numero di valori del sottoalbero.
+     * @return Puntatore alla radice del sottoalbero costruito.
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    template <typename Iter>
+    Node *buildSorted(Iter &it, std::size_t n) {
+        if (n == 0) {
+            return nullptr;
+        }
+        Node *left = buildSorted(it, (n - 1) / 2);
+        Node *node;
+        try {
+            node = createNode(*it, left, nullptr);
+        } catch (...) {
+            deleteSubtree(left);
+            throw;
+        }
+        ++it;
+        if (left != nullptr) {
+            left->parent = node;
+        }
+        try {
+            node->right = buildSorted(it, n - 1 - (n - 1) / 2);
+        } catch (...) {
+            deleteSubtree(node);
+            throw;
+        }
+        if (node->right != nullptr) {
+            node->right->parent = node;
+        }
+        updateNode(node);
+        return node;
+    }
+
+    /**
+     * @brief Riempie l'albero da una sequenza di iteratori ad accesso casuale.
+     *
+     * Se la sequenza è strettamente ordinata l'albero viene costruito direttamente
+     * in O(n), altrimenti la sequenza viene copiata, ordinata e privata dei duplicati
+     * (mantenendo il primo di ogni gruppo di valori equivalenti, come insert).
+     *
+     * @param begin iteratore di inizio sequenza
+     * @param end iteratore di fine sequenza
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    template <typename Iter>
+    void assignRange(Iter begin, Iter end, std::random_access_iterator_tag) {
+        Iter it = begin;
+        if (it != end) {
+            for (++it; it != end && compare(*(it - 1), *it); ++it) {
+            }
+        }
+        if (it == end) {
+            assign_sorted(begin, end);
+            return;
+        }
+        std::vector<T> values(begin, end);
+        std::stable_sort(values.begin(), values.end(), compare);
+        std::size_t kept = 0;
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            if (kept == 0 || compare(values[kept - 1], values[i])) {
+                if (kept != i) {
+                    values[kept] = values[i];
+                }
+                ++kept;
+            }
+        }
+        assign_sorted(std::make_move_iterator(values.begin()), std::make_move_iterator(values.begin() + kept));
+    }
+
+    /**
+     * @brief Riempie l'albero inserendo uno alla volta i valori di una sequenza.
+     *
+     * @param begin iteratore di inizio sequenza
+     * @param end iteratore di fine sequenza
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    template <typename Iter>
+    void assignRange(Iter begin, Iter end, std::input_iterator_tag) {
+        for (Iter it = begin; it != end; ++it) {
+            insert(*it);
+        }
+    }
+
+    /**
+     * @brief Cerca la posizione in cui inserire un valore.
+     *
+     * @param value Valore da inserire.
+     * @param parent Impostato al nodo a cui collegare il nuovo nodo (nullptr se l'albero è vuoto).
+     * @param left Impostato a true se il nuovo nodo va collegato come figlio sinistro.
+     * @return Il nodo con un valore equivalente se presente, nullptr altrimenti.
+     */
+    Node *findInsertPosition(const T &value, Node *&parent, bool &left) const {
+        Node *current = root;
+        parent = nullptr;
+        left = false;
+        while (current != nullptr) {
+            parent = current;
+            int c = order(value, current->value);
+            if (c == 0) {
+                return current;
+            }
+            left = c < 0;
+            current = left ? current->left : current->right;
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief Collega un nuovo nodo nella posizione trovata da findInsertPosition.
+     *
+     * @param node Nodo da collegare, con figli e padre nulli.
+     * @param parent Nodo a cui collegarlo (nullptr se l'albero è vuoto).
+     * @param left true se va collegato come figlio sinistro.
+     */
+    void attachNode(Node *node, Node *parent, bool left) {
+        node->parent = parent;
+        if (parent == nullptr) {
+            root = leftmost = rightmost = node;
+        } else if (left) {
+            parent->left = node;
+            if (parent == leftmost) {
+                leftmost = node;
+            }
+        } else {
+            parent->right = node;
+            if (parent == rightmost) {
+                rightmost = node;
+            }
+        }
+        ++count;
+        rebalance(parent);
+    }
+
+    /**
+     * @brief Inserisce un valore allocando il nodo solo se non è un duplicato.
+     *
+     * @param value Valore da inserire, copiato o spostato nel nodo.
+     * @return Una coppia con il nodo che contiene il valore e true se è stato inserito.
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    template <typename V>
+    std::pair<Node *, bool> insertValue(V &&value) {
+        Node *parent;
+        bool left;
+        Node *existing = findInsertPosition(value, parent, left);
+        if (existing != nullptr) {
+            return std::make_pair(existing, false);
+        }
+        Node *node = createNode(std::forward<V>(value), nullptr, nullptr);
+        attachNode(node, parent, left);
+        return std::make_pair(node, true);
+    }
+
+    /**
+     * @brief Inserisce un valore usando una posizione suggerita.
+     *
+     * Se il valore va collocato subito prima di hint il nodo viene collegato
+     * direttamente al suo vicino, altrimenti l'inserimento scende dalla radice.
+     *
+     * @param hint Nodo prima del quale si suggerisce di inserire (nullptr per la fine).
+     * @param value Valore da inserire, copiato o spostato nel nodo.
+     * @return Il nodo che contiene il valore equivalente nell'albero.
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    template <typename V>
+    Node *insertHint(const Node *hint, V &&value) {
+        Node *next = const_cast<Node *>(hint);
+        Node *prev = next == nullptr ? rightmost : (next == leftmost ? nullptr : predecessor(next));
+        if (root != nullptr && (next == nullptr || compare(value, next->value)) &&
+            (prev == nullptr || compare(prev->value, value))) {
+            Node *node = createNode(std::forward<V>(value), nullptr, nullptr);
+            if (prev != nullptr && prev->right == nullptr) {
+                attachNode(node, prev, false);
+            } else {
+                attachNode(node, next, true);
+            }
+            return node;
+        }
+        return insertValue(std::forward<V>(value)).first;
+    }
+
+    /**
+     * @brief Collega all'albero un nodo già costruito.
+     *
+     * Se l'albero contiene già un valore equivalente il nodo viene distrutto.
+     *
+     * @param node Nodo da collegare, con figli e padre nulli.
+     * @return Una coppia con il nodo che contiene il valore e true se il nodo è stato collegato.
+     */
+    std::pair<Node *, bool> insertNode(Node *node) {
+        Node *parent;
+        bool left;
+        Node *existing = findInsertPosition(node->value, parent, left);
+        if (existing != nullptr) {
+            destroyNode(node);
+            return std::make_pair(existing, false);
+        }
+        attachNode(node, parent, left);
+        return std::make_pair(node, true);
+    }
+
+    /**
+     * @brief Cerca la posizione di un valore partendo da un nodo vicino (finger search).
+     *
+     * Risale da finger fino al primo antenato il cui sottoalbero può contenere
+     * value e da lì scende come findInsertPosition. Per valori vicini a finger il
+     * costo è proporzionale al logaritmo della loro distanza invece che all'altezza.
+     *
+     * @param value Valore da cercare.
+     * @param finger Nodo di partenza, nullptr per scendere dalla radice.
+     * @param parent Impostato al nodo a cui collegare un nuovo nodo con quel valore.
+     * @param left Impostato a true se il nuovo nodo va collegato come figlio sinistro.
+     * @return Il nodo con un valore equivalente se presente, nullptr altrimenti.
+     *
+     * @pre finger è nullptr oppure il suo valore precede value
+     */
+    Node *findFromFinger(const T &value, Node *finger, Node *&parent, bool &left) const {
+        Node *current = root;
+        if (finger != nullptr) {
+            current = finger;
+            while (current->parent != nullptr) {
+                Node *up = current->parent;
+                if (up->left == current) {
+                    int c = order(value, up->value);
+                    if (c == 0) {
+                        return up;
+                    }
+                    if (c < 0) {
+                        break;
+                    }
+                }
+                current = up;
+            }
+        }
+        parent = current != nullptr ? current->parent : nullptr;
+        left = parent != nullptr && parent->left == current;
+        while (current != nullptr) {
+            parent = current;
+            int c = order(value, current->value);
+            if (c == 0) {
+                return current;
+            }
+            left = c < 0;
+            current = left ? current->left : current->right;
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief Verifica se una sequenza è ordinata.
+     *
+     * @param first Iteratore di inizio sequenza.
+     * @param last Iteratore di fine sequenza.
+     * @param strict Impostato a false se la sequenza contiene valori equivalenti consecutivi.
+     * @return true se nessun valore precede quello che lo precede nella sequenza.
+     */
+    template <typename ForwardIt>
+    bool sortedRange(ForwardIt first, ForwardIt last, bool &strict) const {
+        strict = true;
+        if (first == last) {
+            return true;
+        }
+        for (ForwardIt prev = first++; first != last; prev = first++) {
+            if (compare(*first, *prev)) {
+                return false;
+            }
+            if (!compare(*prev, *first)) {
+                strict = false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Inserisce i valori di una sequenza di iteratori di input uno alla volta.
+     *
+     * @return Il numero di valori inseriti.
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    template <typename Iter>
+    int insertBatch(Iter first, Iter last, std::input_iterator_tag) {
+        int inserted = 0;
+        for (; first != last; ++first) {
+            inserted += insertValue(*first).second ? 1 : 0;
+        }
+        return inserted;
+    }
+
+    /**
+     * @brief Inserisce i valori di una sequenza, sfruttandone l'ordinamento.
+     *
+     * Una sequenza non ordinata viene inserita un valore alla volta. Per una
+     * sequenza ordinata lo spazio per i nodi viene riservato in una volta sola;
+     * poi con avl_balance e valori distinti la sequenza diventa un albero
+     * bilanciato in O(k) che viene unito a questo come in set_union, altrimenti
+     * ogni valore viene cercato partendo dal nodo inserito per ultimo.
+     *
+     * @return Il numero di valori inseriti.
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    template <typename Iter>
+    int insertBatch(Iter first, Iter last, std::forward_iterator_tag) {
+        bool strict;
+        if (!sortedRange(first, last, strict)) {
+            return insertBatch(first, last, std::input_iterator_tag());
+        }
+        allocator_release_traits<NodeAlloc>::reserve(alloc, static_cast<std::size_t>(std::distance(first, last)));
+        int before = size();
+        if (Balance::enabled && strict) {
+            BinarySearchTree batch(alloc);
+            batch.compare = compare;
+            batch.equals = equals;
+            batch.assign_sorted(first, last);
+            combine(batch, setUnion, 1);
+            return count - before;
+        }
+        Node *finger = nullptr;
+        for (; first != last; ++first) {
+            Node *parent;
+            bool left;
+            finger = findFromFinger(*first, finger, parent, left);
+            if (finger == nullptr) {
+                finger = createNode(*first, nullptr, nullptr);
+                attachNode(finger, parent, left);
+            }
+        }
+        return size() - before;
+    }
+
+    /**
+     * @brief Rimuove i valori di una sequenza di iteratori di input uno alla volta.
+     *
+     * @return Il numero di valori rimossi.
+     */
+    template <typename Iter>
+    int eraseBatch(Iter first, Iter last, std::input_iterator_tag) {
+        int erased = 0;
+        for (; first != last; ++first) {
+            Node *parent;
+            bool left;
+            Node *node = findFromFinger(*first, nullptr, parent, left);
+            if (node != nullptr) {
+                deleteNode(node);
+                ++erased;
+            }
+        }
+        return erased;
+    }
+
+    /**
+     * @brief Rimuove i valori di una sequenza, sfruttandone l'ordinamento.
+     *
+     * Per una sequenza ordinata ogni valore viene cercato partendo dal
+     * predecessore dell'ultimo nodo rimosso, che resta valido dopo la rimozione.
+     *
+     * @return Il numero di valori rimossi.
+     */
+    template <typename Iter>
+    int eraseBatch(Iter first, Iter last, std::forward_iterator_tag) {
+        bool strict;
+        if (!sortedRange(first, last, strict)) {
+            return eraseBatch(first, last, std::input_iterator_tag());
+        }
+        int erased = 0;
+        Node *finger = nullptr;
+        for (; first != last && root != nullptr; ++first) {
+            Node *parent;
+            bool left;
+            Node *node = findFromFinger(*first, finger, parent, left);
+            if (node != nullptr) {
+                finger = predecessor(node);
+                deleteNode(node);
+                ++erased;
+            } else if (!left) {
+                finger = parent;
+            }
+        }
+        return erased;
+    }
+
+    /**
+     * @brief Confronto a tre vie tramite il metodo three_way del funtore.
+     *
+     * @param a Primo valore.
+     * @param b Secondo valore.
+     * @return Negativo se a precede b, positivo se lo segue, 0 se sono equivalenti.
+     */
+    int order(const T &a, const T &b, std::true_type) const {
+        return compare.three_way(a, b);
+    }
+
+    /**
+     * @brief Confronto a tre vie tramite due chiamate al funtore di confronto.
+     *
+     * @param a Primo valore.
+     * @param b Secondo valore.
+     * @return Negativo se a precede b, positivo se lo segue, 0 se sono equivalenti.
+     */
+    int order(const T &a, const T &b, std::false_type) const {
+        if (compare(a, b)) {
+            return -1;
+        }
+        return compare(b, a) ? 1 : 0;
+    }
+
+    /**
+     * @brief Confronto a tre vie tra due valori.
+     *
+     * @param a Primo valore.
+     * @param b Secondo valore.
+     * @return Negativo se a precede b, positivo se lo segue, 0 se sono equivalenti.
+     */
+    int order(const T &a, const T &b) const {
+        return order(a, b, std::integral_constant<bool, has_three_way<Compare, T>::value>());
+    }
+
+    /**
+     * @brief Trova il nodo con il valore specificato usando il funtore Equal.
+     *
+     * Ad ogni livello vengono valutati equals e compare.
+     *
+     * @param value Valore da cercare.
+     * @return Puntatore al nodo con il valore specificato, se presente; nullptr altrimenti.
+     */
+    Node *findNode(const T &value, std::false_type) const {
+        Node *current = root;
+        while (current != nullptr) {
+            if (equals(value, current->value)) {
+                return current;
+            } else if (compare(value, current->value)) {
+                current = current->left;
+            } else {
+                current = current->right;
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief Trova il nodo con il valore specificato derivando l'uguaglianza da Compare.
+     *
+     * Con un funtore three_way viene fatta una chiamata per livello. Altrimenti
+     * la discesa esegue un solo compare per livello ricordando l'ultimo nodo non
+     * maggiore del valore cercato, e l'equivalenza viene verificata una volta sola
+     * alla fine.
+     *
+     * @param value Valore da cercare.
+     * @return Puntatore al nodo con il valore specificato, se presente; nullptr altrimenti.
+     */
+    Node *findNode(const T &value, std::true_type) const {
+        Node *current = root;
+        if (has_three_way<Compare, T>::value) {
+            while (current != nullptr) {
+                int c = order(value, current->value);
+                if (c == 0) {
+                    return current;
+                }
+                current = c < 0 ? current->left : current->right;
+            }
+            return nullptr;
+        }
+        Node *candidate = nullptr;
+        while (current != nullptr) {
+            if (compare(value, current->value)) {
+                current = current->left;
+            } else {
+                candidate = current;
+                current = current->right;
+            }
+        }
+        return candidate != nullptr && !compare(candidate->value, value) ? candidate : nullptr;
+    }
+
+    /**
+     * @brief Trova il nodo con il valore specificato.
+     *
+     * @param value Valore da cercare.
+     * @return Puntatore al nodo con il valore specificato, se presente; nullptr altrimenti.
+     */
+    Node *findNode(const T &value) const {
+        return findNode(value, std::integral_constant<bool, std::is_same<Equal, compare_equivalence>::value>());
+    }
+
+    /**
+     * @brief Numero di ricerche che avanzano insieme in contains_batch e find_batch.
+     */
+    static const int batchGroup = 16;
+
+    /**
+      @brief Stato di una ricerca all'interno di un gruppo
+    */
+    struct BatchSearch {
+        const T *value;  ///< Valore cercato
+        Node *current;   ///< Prossimo nodo da confrontare, nullptr a ricerca conclusa
+        Node *candidate; ///< Nodo trovato, o ultimo nodo non maggiore del valore
+    };
+
+    /**
+     * @brief Avanza di un livello una ricerca usando il funtore Equal.
+     *
+     * @param search Ricerca da avanzare.
+     */
+    void stepSearch(BatchSearch &search, std::false_type) const {
+        Node *current = search.current;
+        if (equals(*search.value, current->value)) {
+            search.candidate = current;
+            search.current = nullptr;
+        } else {
+            search.current = compare(*search.value, current->value) ? current->left : current->right;
+        }
+    }
+
+    /**
+     * @brief Avanza di un livello una ricerca derivando l'uguaglianza da Compare.
+     *
+     * Segue la stessa discesa di findNode: con un funtore three_way si ferma sul
+     * nodo equivalente, altrimenti ricorda l'ultimo nodo non maggiore del valore.
+     *
+     * @param search Ricerca da avanzare.
+     */
+    void stepSearch(BatchSearch &search, std::true_type) const {
+        Node *current = search.current;
+        if (has_three_way<Compare, T>::value) {
+            int c = order(*search.value, current->value);
+            if (c == 0) {
+                search.candidate = current;
+                search.current = nullptr;
+            } else {
+                search.current = c < 0 ? current->left : current->right;
+            }
+        } else if (compare(*search.value, current->value)) {
+            search.current = current->left;
+        } else {
+            search.candidate = current;
+            search.current = current->right;
+        }
+    }
+
+    /**
+     * @brief Conclude una ricerca restituendo il nodo trovato.
+     *
+     * @param search Ricerca conclusa.
+     * @return Il nodo con il valore cercato, nullptr se non è presente.
+     */
+    Node *searchResult(const BatchSearch &search, std::false_type) const {
+        return search.candidate;
+    }
+
+    /**
+     * @brief Conclude una ricerca verificando l'equivalenza del candidato.
+     *
+     * @param search Ricerca conclusa.
+     * @return Il nodo con il valore cercato, nullptr se non è presente.
+     */
+    Node *searchResult(const BatchSearch &search, std::true_type) const {
+        Node *candidate = search.candidate;
+        if (has_three_way<Compare, T>::value) {
+            return candidate;
+        }
+        return candidate != nullptr && !compare(candidate->value, *search.value) ? candidate : nullptr;
+    }
+
+    /**
+     * @brief Cerca un gruppo di valori facendo avanzare le discese insieme.
+     *
+     * Ad ogni giro ogni ricerca ancora aperta scende di un livello e anticipa il
+     * caricamento (prefetch) del nodo successivo, così i mancati accessi alla cache
+     * delle diverse ricerche si sovrappongono invece di essere attesi uno alla volta.
+     *
+     * @param first Iteratore al primo valore da cercare.
+     * @param count Numero di valori, al più batchGroup.
+     * @param found Array di count elementi in cui vengono scritti i nodi trovati.
+     */
+    template <typename ForwardIt>
+    void findGroup(ForwardIt first, int count, Node **found) const {
+        typedef std::integral_constant<bool, std::is_same<Equal, compare_equivalence>::value> Tag;
+        BatchSearch searches[batchGroup];
+        for (int i = 0; i < count; ++i, ++first) {
+            searches[i].value = &*first;
+            searches[i].current = root;
+            searches[i].candidate = nullptr;
+        }
+        int active = root != nullptr ? count : 0;
+        while (active > 0) {
+            active = 0;
+            for (int i = 0; i < count; ++i) {
+                if (searches[i].current == nullptr) {
+                    continue;
+                }
+                stepSearch(searches[i], Tag());
+                if (searches[i].current != nullptr) {
+#if defined(__GNUC__)
+                    __builtin_prefetch(searches[i].current);
+#endif
+                    ++active;
+                }
+            }
+        }
+        for (int i = 0; i < count; ++i) {
+            found[i] = searchResult(searches[i], Tag());
+        }
+    }
+
+public:
+    class const_iterator;
+    class node_type;
+    struct insert_return_type;
+
+    /**
+      @brief Costruttore di default
+
+      Inizializza un albero binario di ricerca vuoto.
+
+      @post root == nullptr
+      @post count == 0
+     */
+    BinarySearchTree() : root(nullptr), leftmost(nullptr), rightmost(nullptr), count(0) {}
+
+    /**
+      @brief Costruttore con allocatore
+
+      Inizializza un albero binario di ricerca vuoto che alloca i nodi tramite
+      una copia dell'allocatore specificato.
+
+      @param a Allocatore da usare.
+
+      @post root == nullptr
+      @post count == 0
+     */
+    explicit BinarySearchTree(const Alloc &a) : root(nullptr), leftmost(nullptr), rightmost(nullptr), count(0), alloc(a) {}
+
+    /**
+     * @brief Copy constructor
+     *
+     * Costruisce un nuovo albero binario di ricerca come copia di un altro albero.
+     *
+     * @param bst BinarySearchTree da copiare
+     *
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    BinarySearchTree(const BinarySearchTree &bst)
+        : root(nullptr), leftmost(nullptr), rightmost(nullptr), count(0), compare(bst.compare), equals(bst.equals),
+          alloc(NodeTraits::select_on_container_copy_construction(bst.alloc)) {
+        try {
+            if (bst.root) {
+                root = copyNodes(bst.root, count);
+                updateExtremes();
+            }
+        } catch (...) {
+            clear();
+            throw;
+        }
+    }
+
+    /**
+     * @brief Distruttore
+     *
+     * Dealloca tutta la memoria occupata dall'albero binario di ricerca.
+     *
+     * @post tutti i nodi dell'albero sono stati deallocati, root = nullptr
+     */
+    ~BinarySearchTree() {
+        clear();
+    }
+
+    /**
+     *
+     * @brief Costruttore tramite iteratori.
+     *
+     * Costruttore che crea un binary search tree riempito con dati
+     * presi da una sequenza identificata da un iteratore generico di inizio e uno di fine.
+     * Con iteratori ad accesso casuale l'albero viene costruito già bilanciato:
+     * in O(n) se la sequenza è ordinata e senza duplicati, in O(n log n) altrimenti.
+     * Con gli altri iteratori i valori vengono inseriti uno alla volta.
+     *
+     * @tparam Iter tipo dell'iteratore
+     * @param begin iteratore di inizio sequenza
+     * @param end iteratore di fine sequenza
+     * @param a allocatore da usare
+     *
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    template <typename Iter>
+    BinarySearchTree(Iter begin, Iter end, const Alloc &a = Alloc()) : root(nullptr), leftmost(nullptr), rightmost(nullptr), count(0), alloc(a) {
+        try {
+            assignRange(begin, end, typename std::iterator_traits<Iter>::iterator_category());
+        } catch (...) {
+            clear();
+            throw;
+        }
+    }
+
+    /**
+     *
+     * @brief Costruttore tramite sequenza ordinata.
+     *
+     * Costruisce un albero perfettamente bilanciato in O(n) da una sequenza
+     * già ordinata secondo Compare e priva di valori equivalenti.
+     *
+     * @tparam Iter tipo dell'iteratore, almeno forward
+     * @param begin iteratore di inizio sequenza
+     * @param end iteratore di fine sequenza
+     * @param a allocatore da usare
+     *
+     * @pre [begin, end) è strettamente crescente secondo Compare
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    template <typename Iter>
+    BinarySearchTree(sorted_unique_t, Iter begin, Iter end, const Alloc &a = Alloc()) : root(nullptr), leftmost(nullptr), rightmost(nullptr), count(0), alloc(a) {
+        assign_sorted(begin, end);
+    }
+
+    /**
+     * @brief Operatore di assegnamento
+     *
+     * Assegna un albero binario di ricerca a un altro.
+     *
+     * @param bst BinarySearchTree da copiare
+     * @return reference all'albero this
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    BinarySearchTree &operator=(const BinarySearchTree &bst) {
+        try {
+            if (this != &bst) {
+                BinarySearchTree tmp(bst);
+                swap(tmp);
+            }
+        } catch (...) {
+            clear();
+            throw;
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Move constructor
+     *
+     * Costruisce un nuovo albero binario di ricerca prendendo possesso dei nodi
+     * di un altro albero, in O(1). Copia solo puntatori, funtori e allocatore
+     * e non lancia eccezioni, per cui i contenitori standard spostano gli
+     * alberi invece di copiarli quando si riallocano.
+     *
+     * @param bst BinarySearchTree da spostare
+     *
+     * @post bst è vuoto
+     */
+    BinarySearchTree(BinarySearchTree &&bst) noexcept
+        : root(bst.root), leftmost(bst.leftmost), rightmost(bst.rightmost), count(bst.count), compare(bst.compare),
+          equals(bst.equals), alloc(bst.alloc) {
+        bst.root = bst.leftmost = bst.rightmost = nullptr;
+        bst.count = 0;
+    }
+
+    /**
+     * @brief Operatore di assegnamento con spostamento
+     *
+     * Dealloca i nodi dell'albero e prende possesso dei nodi di un altro albero
+     * (insieme al suo allocatore).
+     *
+     * @param bst BinarySearchTree da spostare
+     * @return reference all'albero this
+     *
+     * @post bst è vuoto
+     */
+    BinarySearchTree &operator=(BinarySearchTree &&bst) noexcept {
+        if (this != &bst) {
+            clear();
+            swap(bst);
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Scambia il contenuto di due alberi in O(1).
+     *
+     * Vengono scambiati anche i funtori e gli allocatori.
+     *
+     * @param other Albero con cui scambiare il contenuto.
+     */
+    void swap(BinarySearchTree &other) {
+        std::swap(root, other.root);
+        std::swap(leftmost, other.leftmost);
+        std::swap(rightmost, other.rightmost);
+        std::swap(count, other.count);
+        std::swap(compare, other.compare);
+        std::swap(equals, other.equals);
+        std::swap(alloc, other.alloc);
+    }
+
+    /**
+     * @brief Inserisce un valore nell'albero binario di ricerca.
+     *
+     * Aggiunge un nuovo nodo con il valore specificato nell'albero. Il nodo
+     * viene allocato solo dopo aver verificato che il valore non sia già presente.
+     *
+     * @param value Il valore da inserire.
+     * @return Una coppia con l'iteratore al valore equivalente nell'albero e
+     *         true se il valore è stato inserito, false se era già presente.
+     */
+    std::pair<const_iterator, bool> insert(const T &value) {
+        std::pair<Node *, bool> result = insertValue(value);
+        return std::make_pair(const_iterator(result.first, this), result.second);
+    }
+
+    /**
+     * @brief Inserisce un valore nell'albero binario di ricerca spostandolo.
+     *
+     * Aggiunge un nuovo nodo il cui valore è spostato da quello specificato.
+     * Se il valore è già presente value non viene modificato.
+     *
+     * @param value Il valore da inserire.
+     * @return Una coppia con l'iteratore al valore equivalente nell'albero e
+     *         true se il valore è stato inserito, false se era già presente.
+     */
+    std::pair<const_iterator, bool> insert(T &&value) {
+        std::pair<Node *, bool> result = insertValue(std::move(value));
+        return std::make_pair(const_iterator(result.first, this), result.second);
+    }
+
+    /**
+     * @brief Inserisce un valore usando una posizione suggerita.
+     *
+     * Se il valore va inserito subito prima di hint non viene eseguita alcuna
+     * discesa dalla radice: in particolare inserire valori crescenti con
+     * hint == end() costa O(1) per elemento (più il ribilanciamento).
+     * Altrimenti si comporta come insert(value).
+     *
+     * @param hint Iteratore alla posizione prima della quale inserire.
+     * @param value Il valore da inserire.
+     * @return Un iteratore al valore equivalente nell'albero.
+     */
+    const_iterator insert(const_iterator hint, const T &value) {
+        return const_iterator(insertHint(hint.n, value), this);
+    }
+
+    /**
+     * @brief Inserisce un valore spostandolo e usando una posizione suggerita.
+     *
+     * Come insert(hint, const T &), ma il valore viene spostato nel nodo.
+     *
+     * @param hint Iteratore alla posizione prima della quale inserire.
+     * @param value Il valore da inserire.
+     * @return Un iteratore al valore equivalente nell'albero.
+     */
+    const_iterator insert(const_iterator hint, T &&value) {
+        return const_iterator(insertHint(hint.n, std::move(value)), this);
+    }
+
+    /**
+     * @brief Costruisce un valore direttamente nel nodo e lo inserisce.
+     *
+     * Il valore viene costruito sul posto dagli argomenti specificati; se
+     * l'albero contiene già un valore equivalente il nodo viene distrutto.
+     *
+     * @param args Argomenti per il costruttore di T.
+     * @return Una coppia con l'iteratore al valore equivalente nell'albero e
+     *         true se il valore è stato inserito, false se era già presente.
+     */
+    template <typename... Args>
+    std::pair<const_iterator, bool> emplace(Args &&...args) {
+        std::pair<Node *, bool> result = insertNode(createNode(EmplaceTag(), std::forward<Args>(args)...));
+        return std::make_pair(const_iterator(result.first, this), result.second);
+    }
+
+    /**
+     * @brief Inserisce una sequenza di valori.
+     *
+     * Equivale a chiamare insert per ogni valore, ma se la sequenza è ordinata
+     * secondo Compare non riparte dalla radice per ogni valore: lo spazio per i
+     * nodi viene riservato in una volta sola (con PoolAllocator in un unico
+     * blocco) e con avl_balance la sequenza viene unita all'albero come in
+     * set_union, in O(k log(n/k + 1)); senza bilanciamento ogni valore viene
+     * cercato partendo dal nodo inserito per ultimo (finger search). Una
+     * sequenza non ordinata viene inserita un valore alla volta.
+     *
+     * Se un'allocazione fallisce i valori già inseriti restano nell'albero.
+     *
+     * @param first iteratore di inizio sequenza
+     * @param last iteratore di fine sequenza
+     * @return Il numero di valori inseriti (esclusi quelli già presenti).
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    template <typename Iter>
+    int insert_batch(Iter first, Iter last) {
+        return insertBatch(first, last, typename std::iterator_traits<Iter>::iterator_category());
+    }
+
+    /**
+     * @brief Sostituisce il contenuto dell'albero con una sequenza ordinata.
+     *
+     * Costruisce un albero perfettamente bilanciato in O(n) da una sequenza
+     * già ordinata secondo Compare e priva di valori equivalenti. Se la
+     * costruzione fallisce l'albero resta invariato.
+     *
+     * @tparam Iter tipo dell'iteratore, almeno forward
+     * @param begin iteratore di inizio sequenza
+     * @param end iteratore di fine sequenza
+     *
+     * @pre [begin, end) è strettamente crescente secondo Compare
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    template <typename Iter>
+    void assign_sorted(Iter begin, Iter end) {
+        std::size_t n = static_cast<std::size_t>(std::distance(begin, end));
+        Node *oldRoot = root;
+        root = buildSorted(begin, n);
+        count = static_cast<int>(n);
+        updateExtremes();
+        deleteSubtree(oldRoot);
+    }
+
+    /**
+     * @brief Verifica se un valore è presente nell'albero.
+     *
+     * Cerca il valore specificato nell'albero. Con Equal = compare_equivalence
+     * viene eseguito un solo confronto per livello.
+     *
+     * @param value Il valore da cercare.
+     * @return true se il valore è presente, false altrimenti.
+     */
+    bool contains(const T &value) const {
+        return findNode(value) != nullptr;
+    }
+
+    /**
+     * @brief Verifica la presenza di una sequenza di valori.
+     *
+     * Le ricerche vengono eseguite a gruppi di batchGroup che scendono
+     * nell'albero insieme, un livello per volta, anticipando il caricamento dei
+     * nodi successivi: le attese sulla memoria delle diverse ricerche si
+     * sovrappongono. Il risultato è lo stesso di una chiamata a contains per
+     * ogni valore.
+     *
+     * @param first Iteratore al primo valore da cercare.
+     * @param last Iteratore oltre l'ultimo valore da cercare.
+     * @param out Iteratore di output su cui viene scritto un bool per ogni valore.
+     * @return L'iteratore di output dopo l'ultimo risultato scritto.
+     */
+    template <typename ForwardIt, typename OutputIt>
+    OutputIt contains_batch(ForwardIt first, ForwardIt last, OutputIt out) const {
+        Node *found[batchGroup];
+        while (first != last) {
+            ForwardIt groupEnd = first;
+            int count = 0;
+            while (groupEnd != last && count < batchGroup) {
+                ++groupEnd;
+                ++count;
+            }
+            findGroup(first, count, found);
+            for (int i = 0; i < count; ++i) {
+                *out++ = found[i] != nullptr;
+            }
+            first = groupEnd;
+        }
+        return out;
+    }
+
+    /**
+     * @brief Restituisce la dimensione dell'albero.
+     *
+     * Il numero di nodi è mantenuto ad ogni modifica, il costo è O(1).
+     *
+     * @return Il numero di nodi presenti nell'albero.
+     */
+    int size() const {
+        return count;
+    }
+
+    /**
+     * @brief Restituisce una copia dell'allocatore usato dall'albero.
+     *
+     * @return L'allocatore dell'albero.
+     */
+    Alloc get_allocator() const {
+        return Alloc(alloc);
+    }
+
+    /**
+     * @brief Restituisce l'altezza dell'albero.
+     *
+     * Calcola il numero di livelli dell'albero visitandolo per livelli.
+     *
+     * @return L'altezza dell'albero, 0 se vuoto.
+     */
+    int height() const {
+        int levels = 0;
+        std::vector<const Node *> level;
+        std::vector<const Node *> next;
+        if (root != nullptr) {
+            level.push_back(root);
+        }
+        while (!level.empty()) {
+            ++levels;
+            next.clear();
+            for (std::size_t i = 0; i < level.size(); ++i) {
+                if (level[i]->left != nullptr) {
+                    next.push_back(level[i]->left);
+                }
+                if (level[i]->right != nullptr) {
+                    next.push_back(level[i]->right);
+                }
+            }
+            level.swap(next);
+        }
+        return levels;
+    }
+
+    /**
+     * @brief Rimuove un valore dall'albero.
+     *
+     * Elimina il nodo con il valore specificato dall'albero, se presente.
+     *
+     * @param value Il valore da rimuovere.
+     */
+    void remove(const T &value) {
+        Node *node = root;
+        while (node != nullptr) {
+            int c = order(value, node->value);
+            if (c == 0) {
+                deleteNode(node);
+                return;
+            }
+            node = c < 0 ? node->left : node->right;
+        }
+    }
+
+    /**
+     * @brief Rimuove una sequenza di valori.
+     *
+     * Equivale a chiamare remove per ogni valore. Se la sequenza è ordinata
+     * secondo Compare ogni valore viene cercato partendo dal predecessore
+     * dell'ultimo nodo rimosso invece che dalla radice, per cui rimuovere valori
+     * vicini costa molto meno di una discesa completa. Nessun nodo viene allocato.
+     *
+     * @param first iteratore di inizio sequenza
+     * @param last iteratore di fine sequenza
+     * @return Il numero di valori rimossi.
+     */
+    template <typename Iter>
+    int erase_batch(Iter first, Iter last) {
+        return eraseBatch(first, last, typename std::iterator_traits<Iter>::iterator_category());
+    }
+
+    /**
+     * @brief Rimuove il valore puntato da un iteratore.
+     *
+     * Gli iteratori agli altri valori restano validi.
+     *
+     * @param pos Iteratore al valore da rimuovere, diverso da end().
+     * @return Un iteratore al valore successivo a quello rimosso.
+     */
+    const_iterator erase(const_iterator pos) {
+        Node *node = const_cast<Node *>(pos.n);
+        const_iterator next(successor(node), this);
+        deleteNode(node);
+        return next;
+    }
+
+    /**
+     * @brief Stacca dall'albero il nodo puntato da un iteratore.
+     *
+     * Il nodo non viene deallocato: il suo valore può essere modificato tramite
+     * l'handle e il nodo reinserito con insert(node_type &&).
+     *
+     * @param pos Iteratore al valore da estrarre, diverso da end().
+     * @return L'handle che possiede il nodo.
+     */
+    node_type extract(const_iterator pos) {
+        Node *node = const_cast<Node *>(pos.n);
+        unlinkNode(node);
+        return node_type(node, alloc);
+    }
+
+    /**
+     * @brief Stacca dall'albero il nodo con il valore specificato.
+     *
+     * @param value Il valore da estrarre.
+     * @return L'handle che possiede il nodo, vuoto se il valore non è presente.
+     */
+    node_type extract(const T &value) {
+        Node *parent;
+        bool left;
+        Node *node = findFromFinger(value, nullptr, parent, left);
+        return node != nullptr ? extract(const_iterator(node, this)) : node_type();
+    }
+
+    /**
+     * @brief Reinserisce un nodo estratto.
+     *
+     * Se l'albero contiene già un valore equivalente il nodo resta nell'handle
+     * restituito. Se l'allocatore del nodo è diverso da quello dell'albero il
+     * valore viene spostato in un nuovo nodo e quello dell'handle deallocato.
+     *
+     * @param nh Handle con il nodo da inserire, vuoto dopo un inserimento riuscito.
+     * @return La posizione del valore, l'esito e l'eventuale nodo non inserito.
+     * @throw std::bad_alloc possibile eccezione di allocazione, solo con allocatori diversi
+     */
+    insert_return_type insert(node_type &&nh) {
+        insert_return_type result;
+        result.position = end();
+        result.inserted = false;
+        if (nh.empty()) {
+            return result;
+        }
+        Node *parent;
+        bool left;
+        Node *existing = findInsertPosition(nh.node->value, parent, left);
+        if (existing != nullptr) {
+            result.position = const_iterator(existing, this);
+            result.node = std::move(nh);
+            return result;
+        }
+        Node *node;
+        if (nh.alloc == alloc) {
+            node = nh.release();
+        } else {
+            node = createNode(std::move(nh.node->value), nullptr, nullptr);
+            nh.reset();
+        }
+        attachNode(node, parent, left);
+        result.position = const_iterator(node, this);
+        result.inserted = true;
+        return result;
+    }
+
+    /**
+     * @brief Cancella tutti i nodi dell'albero.
+     *
+     * Dealloca tutti i nodi dell'albero, rendendolo vuoto. Se l'allocatore
+     * supporta il rilascio in blocco (PoolAllocator) e non è condiviso con
+     * altri, la memoria viene restituita in O(numero di blocchi); i valori
+     * vengono comunque distrutti uno per uno se T ha un distruttore non banale.
+     */
+    void clear() {
+        typedef allocator_release_traits<NodeAlloc> Release;
+        if (Release::enabled && Release::exclusive(alloc)) {
+            if (!std::is_trivially_destructible<T>::value) {
+                deleteSubtree(root, false);
+            }
+            Release::release(alloc);
+        } else {
+            deleteSubtree(root);
+        }
+        root = leftmost = rightmost = nullptr;
+        count = 0;
+    }
+
+    /**
+     * @brief Restituisce il sottoalbero cha ha come radice il nodo con il valore specificato.
+     *
+     * Questo metodo cerca il nodo con il valore specificato e restituisce un nuovo albero binario di ricerca
+     * che rappresenta il sottoalbero cha ha come radice il nodo trovato.
+     *
+     * @param value Il valore del nodo radice del sottoalbero da restituire.
+     * @return Un nuovo albero binario di ricerca che rappresenta il sottoalbero radicato nel nodo con il valore specificato.
+     *         Se il valore non è presente nell'albero, viene restituito un albero vuoto.
+     */
+    BinarySearchTree subtree(const T &value) const {
+        Node *subRoot = findNode(value);
+        BinarySearchTree newTree(Alloc(NodeTraits::select_on_container_copy_construction(alloc)));
+        if (subRoot != nullptr) {
+            newTree.root = newTree.copyNodes(subRoot, newTree.count);
+            newTree.updateExtremes();
+        }
+        return newTree;
+    }
+
+    /**
+     * @brief Restituisce una fotografia immutabile e contigua dell'albero.
+     *
+     * I valori vengono copiati in un array in ordine di Eytzinger, adatto a
+     * ricerche con pochi cache miss. La fotografia non segue le modifiche
+     * successive dell'albero e va ricostruita quando necessario. Il costo è O(n).
+     *
+     * @return La fotografia dei valori dell'albero.
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    FrozenBinarySearchTree<T, Compare> freeze() const {
+        return FrozenBinarySearchTree<T, Compare>(begin(), end(), compare);
+    }
+
+    /**
+     * @brief Salva i valori dell'albero su file.
+     *
+     * Il file contiene un'intestazione e i valori in un array piatto in ordine
+     * di Eytzinger, senza puntatori (vedi frozen_file_header). Il costo è O(n).
+     *
+     * @param path Percorso del file, sovrascritto se esiste.
+     * @throw std::runtime_error se il file non può essere scritto
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    void save(const std::string &path) const {
+        freeze().save(path);
+    }
+
+    /**
+     * @brief Scrive i valori dell'albero in formato binario.
+     *
+     * Il formato è composto dall'intestazione "BSTS", dalla versione e dal
+     * numero di valori, seguiti dai valori in ordine crescente raggruppati in
+     * blocchi di circa 64 KiB (numero di valori, lunghezza in byte, valori
+     * codificati) e da un blocco vuoto finale. Gli interi sono in formato
+     * varint. I valori sono codificati da Codec: per gli interi la
+     * differenza dal precedente, per std::string lunghezza e caratteri, per
+     * gli altri tipi banalmente copiabili i byte del valore; per gli altri
+     * tipi va specializzato bst_codec o passato un codec apposito.
+     *
+     * @param out Stream di output, aperto in modalità binaria.
+     * @param codec Codec dei valori.
+     * @throw std::runtime_error se la scrittura fallisce
+     */
+    template <typename Codec = bst_codec<T> >
+    void serialize(std::ostream &out, Codec codec = Codec()) const {
+        std::string bytes("BSTS");
+        bst_varint::put(streamVersion, bytes);
+        bst_varint::put(static_cast<std::uint64_t>(size()), bytes);
+        out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        bytes.clear();
+        std::uint64_t values = 0;
+        for (const Node *node = leftmost; node != nullptr && out; node = successor(node)) {
+            codec.encode(node->value, bytes);
+            ++values;
+            if (bytes.size() >= streamChunk) {
+                writeChunk(out, values, bytes);
+                bytes.clear();
+                values = 0;
+            }
+        }
+        if (values > 0) {
+            writeChunk(out, values, bytes);
+        }
+        writeChunk(out, 0, std::string());
+        if (!out) {
+            throw std::runtime_error("serialize: errore di scrittura");
+        }
+    }
+
+    /**
+     * @brief Sostituisce il contenuto dell'albero con quello letto da serialize.
+     *
+     * Poiché i valori del flusso sono ordinati l'albero viene ricostruito
+     * perfettamente bilanciato in O(n), senza inserimenti né ordinamenti,
+     * leggendo un blocco alla volta. Se la lettura fallisce l'albero resta
+     * invariato.
+     *
+     * @param in Stream di input, aperto in modalità binaria.
+     * @param codec Codec dei valori, lo stesso usato da serialize.
+     * @throw std::runtime_error se il flusso non è valido, è troncato o non è ordinato secondo Compare
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    template <typename Codec = bst_codec<T> >
+    void deserialize(std::istream &in, Codec codec = Codec()) {
+        char magic[4];
+        if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, "BSTS", sizeof(magic)) != 0) {
+            throw std::runtime_error("deserialize: il flusso non contiene un albero");
+        }
+        if (readVarint(in) != static_cast<std::uint64_t>(streamVersion)) {
+            throw std::runtime_error("deserialize: versione del formato non supportata");
+        }
+        std::uint64_t n = readVarint(in);
+        if (n > static_cast<std::uint64_t>(std::numeric_limits<int>::max())) {
+            throw std::runtime_error("deserialize: numero di valori non valido");
+        }
+        StreamReader<Codec> reader(in, codec, compare);
+        Node *newRoot = buildSorted(reader, static_cast<std::size_t>(n));
+        try {
+            reader.finish();
+        } catch (...) {
+            deleteSubtree(newRoot);
+            throw;
+        }
+        Node *oldRoot = root;
+        root = newRoot;
+        count = static_cast<int>(n);
+        updateExtremes();
+        deleteSubtree(oldRoot);
+    }
+
+    /**
+     * @brief Apre in sola lettura un file scritto da save().
+     *
+     * Il file viene mappato in memoria e interrogato direttamente, senza
+     * ricostruire l'albero: l'apertura costa O(1) anche per file molto grandi.
+     * Il risultato offre contains, lower_bound, upper_bound e l'iterazione in
+     * ordine; per modificare i valori va costruito un nuovo albero a partire
+     * dalla sua sequenza, che è già ordinata.
+     *
+     * @param path Percorso del file.
+     * @return La fotografia mappata in memoria.
+     * @throw std::runtime_error se il file non esiste o non è valido per T
+     *
+     * @note Richiede l'inclusione di FrozenFileMapping.hpp.
+     */
+    static FrozenBinarySearchTree<T, Compare> open_mmap(const std::string &path) {
+        return FrozenBinarySearchTree<T, Compare>::open_mmap(path);
+    }
+
+    /**
+     * @brief Funzione amica per la stampa dell'albero.
+     *
+     * Sovraccarica l'operatore di stream per permettere la stampa dell'albero:
+     * stampa tutti i valori in ordine, ciascuno seguito da uno spazio, come dump(os).
+     *
+     * @param os Stream di output.
+     * @param bst Albero binario di ricerca da stampare.
+     * @return Lo stream di output.
+     */
+    friend std::ostream &operator<<(std::ostream &os, const BinarySearchTree &bst) {
+        bst.dump(os);
+        return os;
+    }
+
+    /**
+     * @brief Stampa i primi valori dell'albero in ordine, ciascuno seguito da uno spazio.
+     *
+     * Il testo è preparato in un buffer di 4 KiB e scritto sullo streambuf di
+     * os a blocchi; la visita segue i puntatori al padre, senza ricorsione.
+     * Il formato di os (flag, precisione, locale) si applica a ogni valore; la
+     * larghezza, come per operator<<, si applica solo al primo e viene azzerata.
+     *
+     * @param os Stream di output.
+     * @param limit Numero massimo di valori da stampare.
+     * @return Il numero di valori stampati.
+     */
+    std::size_t dump(std::ostream &os, std::size_t limit = std::numeric_limits<std::size_t>::max()) const {
+        return dump(os, begin(), end(), limit);
+    }
+
+    /**
+     * @brief Stampa i valori di un intervallo dell'albero, ciascuno seguito da uno spazio.
+     *
+     * Per stampare le chiavi in [a, b] si usa dump(os, lower_bound(a), upper_bound(b)).
+     * Se la scrittura fallisce viene impostato badbit su os.
+     *
+     * @param os Stream di output.
+     * @param first Iteratore al primo valore da stampare.
+     * @param last Iteratore al valore successivo all'ultimo.
+     * @param limit Numero massimo di valori da stampare.
+     * @return Il numero di valori stampati.
+     */
+    std::size_t dump(std::ostream &os, const_iterator first, const_iterator last,
+                     std::size_t limit = std::numeric_limits<std::size_t>::max()) const {
+        return bst_output_buffer::write_stream(os, first, last, limit, [](const T &) { return true; });
+    }
+
+    /**
+     * @brief Iteratore costante per l'albero binario di ricerca.
+     */
+    class const_iterator {
+    public:
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef ptrdiff_t difference_type;
+        typedef const T *pointer;
+        typedef const T &reference;
+
+        /**
+         * @brief Costruttore di default.
+         *
+         * Inizializza un iteratore costante.
+         */
+        const_iterator() : n(nullptr), tree(nullptr) {}
+
+        /**
+         * @brief Costruttore di copia.
+         *
+         * Inizializza un iteratore costante copiandone un altro.
+         *
+         * @param other L'iteratore da copiare.
+         */
+        const_iterator(const const_iterator &other) : n(other.n), tree(other.tree) {}
+
+        /**
+         * @brief Operatore di assegnamento.
+         *
+         * Assegna un iteratore costante a un altro.
+         *
+         * @param other L'iteratore da copiare.
+         * @return Un riferimento all'iteratore assegnato.
+         */
+        const_iterator &operator=(const const_iterator &other) {
+            n = other.n;
+            tree = other.tree;
+            return *this;
+        }
+
+        /**
+         * @brief Distruttore.
+         */
+        ~const_iterator() {}
+
+        /**
+         * @brief Dereferenzia l'iteratore.
+         *
+         * @return Il riferimento al valore puntato dall'iteratore.
+         */
+        reference operator*() const {
+            return n->value;
+        }
+
+        /**
+         * @brief Accede al membro puntato dall'iteratore.
+         *
+         * @return Un puntatore al valore puntato dall'iteratore.
+         */
+        pointer operator->() const {
+            return &(n->value);
+        }
+
+        /**
+         * @brief Operatore di post-incremento.
+         *
+         * Avanza l'iteratore alla posizione successiva.
+         *
+         * @return L'iteratore alla posizione precedente.
+         */
+        const_iterator operator++(int) {
+            const_iterator tmp(*this);
+            ++(*this);
+            return tmp;
+        }
+
+        /**
+         * @brief Operatore di pre-incremento.
+         *
+         * Avanza l'iteratore alla posizione successiva.
+         *
+         * @return Un riferimento all'iteratore avanzato.
+         */
+        const_iterator &operator++() {
+            if (n != nullptr) {
+                n = successor(n);
+            }
+            return *this;
+        }
+
+        /**
+         * @brief Operatore di post-decremento.
+         *
+         * Sposta l'iteratore alla posizione precedente.
+         *
+         * @return L'iteratore alla posizione corrente prima dello spostamento.
+         */
+        const_iterator operator--(int) {
+            const_iterator tmp(*this);
+            --(*this);
+            return tmp;
+        }
+
+        /**
+         * @brief Operatore di pre-decremento.
+         *
+         * Sposta l'iteratore alla posizione precedente. Decrementare end()
+         * porta all'ultimo elemento dell'albero.
+         *
+         * @return Un riferimento all'iteratore spostato.
+         */
+        const_iterator &operator--() {
+            if (n == nullptr) {
+                n = tree != nullptr ? tree->rightmost : nullptr;
+            } else {
+                n = predecessor(n);
+            }
+            return *this;
+        }
+
+        /**
+         * @brief Operatore di uguaglianza.
+         *
+         * Confronta due iteratori per uguaglianza.
+         *
+         * @param other L'iteratore da confrontare.
+         * @return true se gli iteratori sono uguali, false altrimenti.
+         */
+        bool operator==(const const_iterator &other) const {
+            return n == other.n;
+        }
+
+        /**
+         * @brief Operatore di disuguaglianza.
+         *
+         * Confronta due iteratori per disuguaglianza.
+         *
+         * @param other L'iteratore da confrontare.
+         * @return true se gli iteratori sono diversi, false altrimenti.
+         */
+        bool operator!=(const const_iterator &other) const {
+            return n != other.n;
+        }
+
+    private:
+        const Node *n;
+        const BinarySearchTree *tree;
+
+        /**
+         * @brief Costruttore privato per inizializzare un iteratore con un nodo specifico.
+         *
+         * @param node Il nodo da cui iniziare l'iterazione.
+         * @param tree L'albero a cui appartiene il nodo.
+         */
+        const_iterator(const Node *node, const BinarySearchTree *tree) : n(node), tree(tree) {}
+
+        friend class BinarySearchTree;
+    };
+
+    /**
+      @brief Nodo estratto dall'albero (node handle)
+
+      Possiede un nodo staccato da extract() insieme a una copia dell'allocatore
+      che lo ha allocato. Il valore può essere modificato e il nodo reinserito
+      con insert(node_type &&) senza nuove allocazioni; se l'handle viene
+      distrutto prima, il nodo viene deallocato. Come in std::set l'handle si
+      può solo spostare.
+    */
+    class node_type {
+    public:
+        typedef T value_type;      ///< Tipo del valore
+        typedef Alloc allocator_type; ///< Tipo dell'allocatore
+
+        /**
+         * @brief Costruttore di default: handle vuoto.
+         */
+        node_type() : node(nullptr) {}
+
+        /**
+         * @brief Move constructor
+         *
+         * @param other Handle da cui prendere il nodo, che resta vuoto.
+         */
+        node_type(node_type &&other) : node(nullptr) {
+            take(other);
+        }
+
+        /**
+         * @brief Move assignment
+         *
+         * Il nodo eventualmente posseduto viene deallocato.
+         *
+         * @param other Handle da cui prendere il nodo, che resta vuoto.
+         * @return reference all'handle this
+         */
+        node_type &operator=(node_type &&other) {
+            if (this != &other) {
+                reset();
+                take(other);
+            }
+            return *this;
+        }
+
+        /**
+         * @brief Distruttore
+         *
+         * Dealloca il nodo posseduto, se presente.
+         */
+        ~node_type() {
+            reset();
+        }
+
+        /**
+         * @brief Verifica se l'handle è vuoto.
+         *
+         * @return true se l'handle non possiede alcun nodo.
+         */
+        bool empty() const {
+            return node == nullptr;
+        }
+
+        /**
+         * @brief Verifica se l'handle possiede un nodo.
+         */
+        explicit operator bool() const {
+            return node != nullptr;
+        }
+
+        /**
+         * @brief Accede al valore del nodo, modificabile finché il nodo è fuori dall'albero.
+         *
+         * @pre !empty()
+         * @return Il riferimento al valore.
+         */
+        T &value() const {
+            return node->value;
+        }
+
+        /**
+         * @brief Restituisce l'allocatore del nodo.
+         *
+         * @pre !empty()
+         */
+        allocator_type get_allocator() const {
+            return allocator_type(alloc);
+        }
+
+        /**
+         * @brief Scambia il contenuto di due handle.
+         *
+         * @param other Handle con cui scambiare il nodo.
+         */
+        void swap(node_type &other) {
+            node_type temp(std::move(other));
+            other = std::move(*this);
+            *this = std::move(temp);
+        }
+
+    private:
+        Node *node; ///< Nodo posseduto, nullptr se vuoto
+        union {
+            NodeAlloc alloc; ///< Allocatore del nodo, costruito solo se node != nullptr
+        };
+
+        /**
+         * @brief Costruisce un handle che possiede un nodo già staccato.
+         *
+         * @param n Nodo staccato.
+         * @param a Allocatore che ha allocato il nodo.
+         */
+        node_type(Node *n, const NodeAlloc &a) : node(n) {
+            ::new (static_cast<void *>(&alloc)) NodeAlloc(a);
+        }
+
+        /**
+         * @brief Prende il nodo e l'allocatore di un altro handle.
+         *
+         * @pre this è vuoto
+         */
+        void take(node_type &other) {
+            if (other.node != nullptr) {
+                ::new (static_cast<void *>(&alloc)) NodeAlloc(std::move(other.alloc));
+                node = other.release();
+            }
+        }
+
+        /**
+         * @brief Cede il nodo senza deallocarlo, lasciando l'handle vuoto.
+         *
+         * @return Il nodo posseduto.
+         */
+        Node *release() {
+            Node *n = node;
+            node = nullptr;
+            alloc.~NodeAlloc();
+            return n;
+        }
+
+        /**
+         * @brief Dealloca il nodo posseduto, lasciando l'handle vuoto.
+         */
+        void reset() {
+            if (node != nullptr) {
+                NodeTraits::destroy(alloc, node);
+                NodeTraits::deallocate(alloc, node, 1);
+                release();
+            }
+        }
+
+        friend class BinarySearchTree;
+    };
+
+    /**
+      @brief Risultato dell'inserimento di un node_type
+    */
+    struct insert_return_type {
+        const_iterator position; ///< Valore inserito o valore equivalente già presente
+        bool inserted;           ///< true se il nodo è stato inserito
+        node_type node;          ///< Il nodo non inserito, vuoto se inserted
+    };
+
+    /**
+     * @brief Restituisce un iteratore costante all'inizio dell'albero.
+     *
+     * @return Un iteratore costante al primo elemento dell'albero.
+     */
+    const_iterator begin() const {
+        return const_iterator(leftmost, this);
+    }
+
+    /**
+     * @brief Restituisce un iteratore costante alla fine dell'albero.
+     *
+     * @return Un iteratore costante alla posizione successiva all'ultimo elemento dell'albero.
+     */
+    const_iterator end() const {
+        return const_iterator(nullptr, this);
+    }
+
+    /**
+     * @brief Iteratore inverso costante.
+     */
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    /**
+     * @brief Restituisce un iteratore inverso costante all'ultimo elemento dell'albero.
+     *
+     * @return Un iteratore inverso costante all'ultimo elemento dell'albero.
+     */
+    const_reverse_iterator rbegin() const {
+        return const_reverse_iterator(end());
+    }
+
+    /**
+     * @brief Restituisce un iteratore inverso costante alla posizione precedente al primo elemento.
+     *
+     * @return Un iteratore inverso costante alla fine della visita inversa.
+     */
+    const_reverse_iterator rend() const {
+        return const_reverse_iterator(begin());
+    }
+
+    /**
+     * @brief Restituisce un iteratore al valore equivalente a quello specificato.
+     *
+     * @param value Il valore da cercare.
+     * @return Un iteratore al valore, end() se non è presente.
+     */
+    const_iterator find(const T &value) const {
+        return const_iterator(findNode(value), this);
+    }
+
+    /**
+     * @brief Cerca una sequenza di valori.
+     *
+     * Come contains_batch, ma per ogni valore scrive l'iteratore che
+     * restituirebbe find, end() se il valore non è presente.
+     *
+     * @param first Iteratore al primo valore da cercare.
+     * @param last Iteratore oltre l'ultimo valore da cercare.
+     * @param out Iteratore di output su cui viene scritto un const_iterator per ogni valore.
+     * @return L'iteratore di output dopo l'ultimo risultato scritto.
+     */
+    template <typename ForwardIt, typename OutputIt>
+    OutputIt find_batch(ForwardIt first, ForwardIt last, OutputIt out) const {
+        Node *found[batchGroup];
+        while (first != last) {
+            ForwardIt groupEnd = first;
+            int count = 0;
+            while (groupEnd != last && count < batchGroup) {
+                ++groupEnd;
+                ++count;
+            }
+            findGroup(first, count, found);
+            for (int i = 0; i < count; ++i) {
+                *out++ = const_iterator(found[i], this);
+            }
+            first = groupEnd;
+        }
+        return out;
+    }
+
+    /**
+     * @brief Restituisce un iteratore al primo valore non minore di quello specificato.
+     *
+     * Il costo è O(altezza).
+     *
+     * @param value Il valore di riferimento.
+     * @return Un iteratore al primo valore v tale che !(v < value), end() se non esiste.
+     */
+    const_iterator lower_bound(const T &value) const {
+        const Node *candidate = nullptr;
+        const Node *current = root;
+        while (current != nullptr) {
+            if (compare(current->value, value)) {
+                current = current->right;
+            } else {
+                candidate = current;
+                current = current->left;
+            }
+        }
+        return const_iterator(candidate, this);
+    }
+
+    /**
+     * @brief Restituisce un iteratore al primo valore maggiore di quello specificato.
+     *
+     * Il costo è O(altezza).
+     *
+     * @param value Il valore di riferimento.
+     * @return Un iteratore al primo valore v tale che value < v, end() se non esiste.
+     */
+    const_iterator upper_bound(const T &value) const {
+        const Node *candidate = nullptr;
+        const Node *current = root;
+        while (current != nullptr) {
+            if (compare(value, current->value)) {
+                candidate = current;
+                current = current->left;
+            } else {
+                current = current->right;
+            }
+        }
+        return const_iterator(candidate, this);
+    }
+
+    /**
+     * @brief Restituisce l'intervallo dei valori equivalenti a quello specificato.
+     *
+     * @param value Il valore di riferimento.
+     * @return La coppia (lower_bound(value), upper_bound(value)).
+     */
+    std::pair<const_iterator, const_iterator> equal_range(const T &value) const {
+        return std::make_pair(lower_bound(value), upper_bound(value));
+    }
+
+    /**
+      @brief Vista sui valori di un intervallo chiuso dell'albero
+
+      Contiene solo i due iteratori estremi: la visita costa O(k) per k
+      valori nell'intervallo e non esamina i valori esterni.
+      Resta valida finché l'albero non viene modificato.
+    */
+    class const_range {
+    public:
+        /**
+         * @brief Restituisce un iteratore al primo valore dell'intervallo.
+         */
+        const_iterator begin() const {
+            return first;
+        }
+
+        /**
+         * @brief Restituisce un iteratore alla posizione successiva all'ultimo valore dell'intervallo.
+         */
+        const_iterator end() const {
+            return last;
+        }
+
+        /**
+         * @brief Verifica se l'intervallo è vuoto.
+         *
+         * @return true se l'intervallo non contiene valori, false altrimenti.
+         */
+        bool empty() const {
+            return first == last;
+        }
+
+    private:
+        const_iterator first; ///< Primo valore dell'intervallo
+        const_iterator last;  ///< Posizione successiva all'ultimo valore
+
+        /**
+         * @brief Costruttore privato.
+         *
+         * @param first Primo valore dell'intervallo.
+         * @param last Posizione successiva all'ultimo valore.
+         */
+        const_range(const const_iterator &first, const const_iterator &last) : first(first), last(last) {}
+
+        friend class BinarySearchTree;
+    };
+
+    /**
+     * @brief Restituisce la vista sui valori compresi nell'intervallo chiuso [lo, hi].
+     *
+     * Gli estremi sono posizionati in O(altezza), per cui una scansione
+     * dell'intervallo costa O(altezza + k).
+     *
+     * @param lo Estremo inferiore dell'intervallo.
+     * @param hi Estremo superiore dell'intervallo.
+     * @return La vista sui valori v tali che lo <= v <= hi (vuota se hi < lo).
+     */
+    const_range range(const T &lo, const T &hi) const {
+        if (compare(hi, lo)) {
+            return const_range(end(), end());
+        }
+        return const_range(lower_bound(lo), upper_bound(hi));
+    }
+
+    /**
+     * @brief Restituisce il numero di valori strettamente minori del valore specificato.
+     *
+     * Richiede l'augmentazione size_augment. Il costo è O(altezza).
+     *
+     * @param value Il valore di riferimento.
+     * @return Il numero di valori dell'albero minori di value.
+     */
+    int rank(const T &value) const {
+        static_assert(Augment::enabled, "rank() richiede size_augment");
+        int result = 0;
+        const Node *current = root;
+        while (current != nullptr) {
+            if (compare(current->value, value)) {
+                result += size_augment::count(current->left) + 1;
+                current = current->right;
+            } else {
+                current = current->left;
+            }
+        }
+        return result;
+    }
+
+    /**
+     * @brief Restituisce un iteratore al k-esimo valore in ordine crescente.
+     *
+     * Richiede l'augmentazione size_augment. Il costo è O(altezza).
+     *
+     * @param k Posizione del valore, a partire da 0.
+     * @return Un iteratore al k-esimo valore, end() se k non è una posizione valida.
+     */
+    const_iterator select(int k) const {
+        static_assert(Augment::enabled, "select() richiede size_augment");
+        const Node *current = root;
+        while (current != nullptr) {
+            int leftCount = size_augment::count(current->left);
+            if (k < leftCount) {
+                current = current->left;
+            } else if (k > leftCount) {
+                k -= leftCount + 1;
+                current = current->right;
+            } else {
+                break;
+            }
+        }
+        return const_iterator(k < 0 ? nullptr : current, this);
+    }
+
+    /**
+     * @brief Conta i valori compresi nell'intervallo chiuso [lo, hi].
+     *
+     * Richiede l'augmentazione size_augment. Il costo è O(altezza).
+     *
+     * @param lo Estremo inferiore dell'intervallo.
+     * @param hi Estremo superiore dell'intervallo.
+     * @return Il numero di valori v tali che lo <= v <= hi.
+     */
+    int count_range(const T &lo, const T &hi) const {
+        static_assert(Augment::enabled, "count_range() richiede size_augment");
+        if (compare(hi, lo)) {
+            return 0;
+        }
+        int notGreater = 0;
+        const Node *current = root;
+        while (current != nullptr) {
+            if (compare(hi, current->value)) {
+                current = current->left;
+            } else {
+                notGreater += size_augment::count(current->left) + 1;
+                current = current->right;
+            }
+        }
+        return notGreater - rank(lo);
+    }
+
+    /**
+     * @brief Sposta in this i nodi di other con valori non presenti in this.
+     *
+     * Come std::set::merge: i nodi non vengono copiati né riallocati e i
+     * valori già presenti in this restano in other. Con avl_balance l'unione
+     * è basata su split e join e costa O(m log(n/m + 1)), con m e n le
+     * dimensioni del più piccolo e del più grande dei due alberi: unire un
+     * piccolo insieme di modifiche a un albero grande costa in proporzione
+     * alle modifiche. Senza bilanciamento i due alberi vengono fusi in O(n + m)
+     * e ricostruiti bilanciati. Se gli allocatori sono diversi i valori di
+     * other vengono prima copiati con l'allocatore di this.
+     *
+     * @param other Albero sorgente, al termine contiene i valori duplicati.
+     * @param threads Numero massimo di thread (0 per usare quelli disponibili nel sistema).
+     * @throw std::bad_alloc possibile eccezione di allocazione (solo con allocatori diversi)
+     */
+    void merge(BinarySearchTree &other, unsigned threads = 0) {
+        if (this == &other) {
+            return;
+        }
+        if (!(alloc == other.alloc)) {
+            BinarySearchTree copy(sorted_unique, other.begin(), other.end(), get_allocator());
+            combine(copy, setUnion, threads);
+            other.assign_sorted(copy.begin(), copy.end());
+            return;
+        }
+        combine(other, setUnion, threads);
+    }
+
+    /**
+     * @brief Sostituisce this con l'unione di this e other.
+     *
+     * A parità di valore viene mantenuto quello di this. I nodi di other sono
+     * riutilizzati: passare un albero con std::move evita ogni allocazione.
+     * Costi come merge.
+     *
+     * @param other Albero da unire.
+     * @param threads Numero massimo di thread (0 per usare quelli disponibili nel sistema).
+     * @throw std::bad_alloc possibile eccezione di allocazione (solo con allocatori diversi)
+     */
+    void set_union(BinarySearchTree other, unsigned threads = 0) {
+        merge(other, threads);
+    }
+
+    /**
+     * @brief Sostituisce this con l'intersezione di this e other.
+     *
+     * Vengono mantenuti i nodi di this i cui valori sono presenti anche in
+     * other. Con avl_balance il costo è O(m log(n/m + 1)) più la distruzione
+     * dei nodi scartati; senza bilanciamento O(n + m).
+     *
+     * @param other Albero da intersecare.
+     * @param threads Numero massimo di thread (0 per usare quelli disponibili nel sistema).
+     * @throw std::bad_alloc possibile eccezione di allocazione (solo con allocatori diversi)
+     */
+    void set_intersection(BinarySearchTree other, unsigned threads = 0) {
+        combineAdopting(other, setIntersection, threads);
+    }
+
+    /**
+     * @brief Sostituisce this con la differenza tra this e other.
+     *
+     * Vengono rimossi da this i valori presenti in other. Con avl_balance il
+     * costo è O(m log(n/m + 1)) più la distruzione dei nodi scartati; senza
+     * bilanciamento O(n + m).
+     *
+     * @param other Albero dei valori da rimuovere.
+     * @param threads Numero massimo di thread (0 per usare quelli disponibili nel sistema).
+     * @throw std::bad_alloc possibile eccezione di allocazione (solo con allocatori diversi)
+     */
+    void set_difference(BinarySearchTree other, unsigned threads = 0) {
+        combineAdopting(other, setDifference, threads);
+    }
+
+    /**
+     * @brief Divide l'albero rispetto a un valore spostando i nodi in due nuovi alberi.
+     *
+     * Nessun nodo viene copiato o allocato. Con avl_balance i due alberi sono
+     * ricomposti con join e restano AVL, il costo è O(log n); senza
+     * bilanciamento i nodi vengono ricollegati lungo il cammino di ricerca in
+     * O(altezza). Senza size_augment i nodi di uno dei due alberi vengono
+     * inoltre contati per mantenere size() in O(1), per cui il costo è O(n).
+     *
+     * @param key Valore di divisione.
+     * @return La coppia di alberi con i valori minori di key e con quelli
+     *         non minori di key.
+     * @post this è vuoto
+     */
+    std::pair<BinarySearchTree, BinarySearchTree> split(const T &key) {
+        BinarySearchTree below(get_allocator()), above(get_allocator());
+        below.compare = above.compare = compare;
+        below.equals = above.equals = equals;
+        Node *left, *right;
+        splitRoot(key, left, right, std::integral_constant<bool, Balance::enabled>());
+        if (left != nullptr) {
+            left->parent = nullptr;
+        }
+        int belowCount = subtreeCount(left, std::integral_constant<bool, Augment::enabled>());
+        below.adoptRoot(left, belowCount);
+        above.adoptRoot(right, count - belowCount);
+        root = leftmost = rightmost = nullptr;
+        count = 0;
+        return std::make_pair(std::move(below), std::move(above));
+    }
+
+    /**
+     * @brief Concatena due alberi i cui valori sono ordinati, spostandone i nodi.
+     *
+     * Con avl_balance il risultato resta AVL e il costo è O(log n); senza
+     * bilanciamento right viene appeso sotto il massimo di left in
+     * O(altezza). Se gli allocatori sono diversi i valori di right vengono
+     * prima copiati con l'allocatore di left.
+     *
+     * @param left Albero con i valori minori.
+     * @param right Albero con i valori maggiori.
+     * @return L'albero con i valori di entrambi.
+     * @throw std::invalid_argument se il massimo di left non precede il minimo di right
+     * @throw std::bad_alloc possibile eccezione di allocazione (solo con allocatori diversi)
+     */
+    static BinarySearchTree join(BinarySearchTree left, BinarySearchTree right) {
+        if (left.root != nullptr && right.root != nullptr && !left.compare(left.rightmost->value, right.leftmost->value)) {
+            throw std::invalid_argument("join: i valori di left devono precedere quelli di right");
+        }
+        if (!(left.alloc == right.alloc)) {
+            BinarySearchTree copy(sorted_unique, right.begin(), right.end(), left.get_allocator());
+            return join(std::move(left), std::move(copy));
+        }
+        int total = left.count + right.count;
+        Node *joined = left.joinRoots(left.root, right.root, std::integral_constant<bool, Balance::enabled>());
+        right.root = right.leftmost = right.rightmost = nullptr;
+        right.count = 0;
+        left.adoptRoot(joined, total);
+        return left;
+    }
+
+    /**
+     * @brief Divide l'albero in segmenti contigui per una visita parallela.
+     *
+     * Con size_augment i segmenti hanno la stessa dimensione (a meno di uno),
+     * calcolata con select. Altrimenti i punti di divisione sono le radici dei
+     * primi livelli dell'albero, cioè i confini tra sottoalberi: i segmenti
+     * sono equilibrati quanto l'albero stesso.
+     *
+     * @param parts Numero di segmenti desiderato.
+     * @return Iteratori strettamente crescenti; il primo è begin(), l'ultimo
+     *         end() e ogni coppia consecutiva delimita un segmento non vuoto.
+     *         I segmenti possono essere meno di parts.
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    std::vector<const_iterator> partition_points(int parts) const {
+        std::vector<const_iterator> points;
+        points.push_back(begin());
+        if (count > 0 && parts > 1) {
+            partitionPoints(parts, points, std::integral_constant<bool, Augment::enabled>());
+        }
+        if (count > 0) {
+            points.push_back(end());
+        }
+        return points;
+    }
+
+private:
+    /**
+     * @brief Aggiunge i punti di divisione interni calcolandoli con select.
+     */
+    void partitionPoints(int parts, std::vector<const_iterator> &points, std::true_type) const {
+        int previous = 0;
+        for (int i = 1; i < parts; ++i) {
+            int k = static_cast<int>(static_cast<long long>(count) * i / parts);
+            if (k > previous) {
+                points.push_back(select(k));
+                previous = k;
+            }
+        }
+    }
+
+    /**
+     * @brief Aggiunge come punti di divisione interni le radici dei primi livelli.
+     */
+    void partitionPoints(int parts, std::vector<const_iterator> &points, std::false_type) const {
+        std::vector<const Node *> nodes;
+        nodes.push_back(root);
+        for (std::size_t i = 0; i < nodes.size() && nodes.size() < static_cast<std::size_t>(parts); ++i) {
+            if (nodes[i]->left != nullptr) {
+                nodes.push_back(nodes[i]->left);
+            }
+            if (nodes[i]->right != nullptr) {
+                nodes.push_back(nodes[i]->right);
+            }
+        }
+        if (nodes.size() >= static_cast<std::size_t>(parts)) {
+            nodes.resize(parts - 1);
+        }
+        const Compare &comp = compare;
+        std::sort(nodes.begin(), nodes.end(),
+                  [&comp](const Node *a, const Node *b) { return comp(a->value, b->value); });
+        for (std::size_t i = 0; i < nodes.size(); ++i) {
+            const Node *node = nodes[i];
+            // il nodo del minimo coincide con begin()
+            if (node != leftmost) {
+                points.push_back(const_iterator(node, this));
+            }
+        }
+    }
+
+    /**
+      @brief Operazioni insiemistiche tra due alberi
+    */
+    enum SetOperation {
+        setUnion,        ///< Unione; i duplicati di other restano in other
+        setIntersection, ///< Intersezione
+        setDifference    ///< Differenza this \ other
+    };
+
+    /**
+     * @brief Versione del formato scritto da serialize.
+     */
+    static const int streamVersion = 1;
+
+    /**
+     * @brief Dimensione in byte oltre la quale serialize chiude un blocco.
+     */
+    static const std::size_t streamChunk = 1 << 16;
+
+    /**
+     * @brief Legge da uno stream un intero in formato varint.
+     *
+     * @param in Stream di input.
+     * @return Il valore letto.
+     * @throw std::runtime_error se lo stream termina prima del valore
+     */
+    static std::uint64_t readVarint(std::istream &in) {
+        char bytes[10];
+        for (int i = 0; i < 10; ++i) {
+            int c = in.get();
+            if (c == std::char_traits<char>::eof()) {
+                throw std::runtime_error("deserialize: flusso troncato");
+            }
+            bytes[i] = static_cast<char>(c);
+            if ((c & 0x80) == 0) {
+                const char *pos = bytes;
+                return bst_varint::get(pos, bytes + i + 1);
+            }
+        }
+        throw std::runtime_error("deserialize: varint troppo lungo");
+    }
+
+    /**
+     * @brief Scrive un blocco del flusso binario: numero di valori, lunghezza e byte.
+     *
+     * @param out Stream di output.
+     * @param values Numero di valori codificati nel blocco.
+     * @param bytes Byte dei valori.
+     */
+    static void writeChunk(std::ostream &out, std::uint64_t values, const std::string &bytes) {
+        std::string frame;
+        bst_varint::put(values, frame);
+        bst_varint::put(bytes.size(), frame);
+        out.write(frame.data(), static_cast<std::streamsize>(frame.size()));
+        out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    }
+
+    /**
+      @brief Lettore dei valori di un flusso binario
+
+      Legge e decodifica un blocco alla volta e offre i valori a buildSorted
+      come un iteratore, spostandoli nei nodi. Verifica che i valori siano
+      strettamente crescenti, anche tra un blocco e il successivo.
+    */
+    template <typename Codec>
+    class StreamReader {
+    public:
+        /**
+         * @brief Costruttore
+         *
+         * @param in Stream da cui leggere, posizionato sul primo blocco.
+         * @param codec Codec dei valori.
+         * @param compare Funtore di confronto dell'albero.
+         */
+        StreamReader(std::istream &in, Codec &codec, const Compare &compare)
+            : in(in), codec(codec), compare(compare), index(0) {}
+
+        /**
+         * @brief Restituisce il valore corrente, leggendo un nuovo blocco se necessario.
+         *
+         * @return Il valore, da spostare nel nodo.
+         * @throw std::runtime_error se il flusso termina prima o è danneggiato
+         */
+        T &&operator*() {
+            if (index == values.size() && readChunk() == 0) {
+                throw std::runtime_error("deserialize: flusso troncato");
+            }
+            return std::move(values[index]);
+        }
+
+        /**
+         * @brief Passa al valore successivo.
+         */
+        StreamReader &operator++() {
+            ++index;
+            return *this;
+        }
+
+        /**
+         * @brief Verifica che dopo i valori letti il flusso termini.
+         *
+         * @throw std::runtime_error se il flusso contiene altri valori
+         */
+        void finish() {
+            if (index != values.size() || readChunk() != 0) {
+                throw std::runtime_error("deserialize: più valori di quelli dichiarati");
+            }
+        }
+
+    private:
+        std::istream &in;       ///< Stream di input
+        Codec &codec;           ///< Codec dei valori
+        const Compare &compare; ///< Funtore di confronto
+        std::string bytes;      ///< Byte del blocco corrente
+        std::vector<T> values;  ///< Valori decodificati del blocco corrente
+        std::size_t index;      ///< Prossimo valore da consegnare
+        std::vector<T> last;    ///< Ultimo valore del blocco precedente (al più uno)
+
+        /**
+         * @brief Legge e decodifica il blocco successivo.
+         *
+         * @return Il numero di valori del blocco, 0 per il blocco finale.
+         * @throw std::runtime_error se il blocco è troncato, danneggiato o non ordinato
+         */
+        std::uint64_t readChunk() {
+            std::uint64_t count = readVarint(in);
+            std::uint64_t length = readVarint(in);
+            // legge a pezzi: una lunghezza danneggiata non causa grandi allocazioni
+            bytes.clear();
+            while (bytes.size() < length) {
+                std::size_t piece = static_cast<std::size_t>(std::min(length - bytes.size(), static_cast<std::uint64_t>(streamChunk)));
+                std::size_t old = bytes.size();
+                bytes.resize(old + piece);
+                in.read(&bytes[old], static_cast<std::streamsize>(piece));
+                if (static_cast<std::size_t>(in.gcount()) != piece) {
+                    throw std::runtime_error("deserialize: flusso troncato");
+                }
+            }
+            values.clear();
+            index = 0;
+            const char *pos = bytes.data();
+            const char *end = pos + bytes.size();
+            for (std::uint64_t i = 0; i < count; ++i) {
+                values.push_back(codec.decode(pos, end));
+                const T *previous = values.size() > 1 ? &values[values.size() - 2] : (last.empty() ? nullptr : &last[0]);
+                if (previous != nullptr && !compare(*previous, values.back())) {
+                    throw std::runtime_error("deserialize: valori non ordinati");
+                }
+            }
+            if (pos != end) {
+                throw std::runtime_error("deserialize: blocco danneggiato");
+            }
+            if (count > 0) {
+                last.assign(1, values.back());
+            }
+            return count;
+        }
+    };
+
+    /**
+     * @brief Altezza minima del sottoalbero perché le due metà vengano elaborate in parallelo.
+     */
+    static const int parallelHeight = 12;
+
+    /**
+      @brief Lista di sottoalberi staccati
+
+      Le radici sono concatenate tramite il puntatore al padre, che per la
+      radice di un sottoalbero staccato è inutilizzato: la lista non alloca
+      memoria, per cui le operazioni insiemistiche non possono fallire a metà.
+    */
+    struct NodeList {
+        Node *head; ///< Primo sottoalbero
+        Node *tail; ///< Ultimo sottoalbero
+        int roots;  ///< Numero di sottoalberi
+
+        /**
+         * @brief Costruttore di default: lista vuota.
+         */
+        NodeList() : head(nullptr), tail(nullptr), roots(0) {}
+
+        /**
+         * @brief Aggiunge in coda un sottoalbero staccato.
+         *
+         * @param node Radice del sottoalbero (ignorata se nullptr).
+         */
+        void push(Node *node) {
+            if (node == nullptr) {
+                return;
+            }
+            node->parent = nullptr;
+            if (tail != nullptr) {
+                tail->parent = node;
+            } else {
+                head = node;
+            }
+            tail = node;
+            ++roots;
+        }
+
+        /**
+         * @brief Sposta in coda i sottoalberi di un'altra lista.
+         *
+         * @param other Lista da concatenare, al termine vuota.
+         */
+        void append(NodeList &other) {
+            if (other.head == nullptr) {
+                return;
+            }
+            if (tail != nullptr) {
+                tail->parent = other.head;
+            } else {
+                head = other.head;
+            }
+            tail = other.tail;
+            roots += other.roots;
+            other.head = other.tail = nullptr;
+            other.roots = 0;
+        }
+    };
+
+    /**
+     * @brief Esegue due funtori, in parallelo se richiesto e possibile.
+     *
+     * @param parallel true per eseguire first in un altro thread.
+     * @param first Primo funtore.
+     * @param second Secondo funtore, eseguito nel thread chiamante.
+     */
+    template <typename F, typename G>
+    static void invokeBoth(bool parallel, F first, G second) {
+        std::future<void> pending;
+        if (parallel) {
+            try {
+                pending = std::async(std::launch::async, first);
+            } catch (...) {
+                // nessun thread disponibile: first viene eseguito qui
+            }
+        }
+        second();
+        if (pending.valid()) {
+            pending.get();
+        } else {
+            first();
+        }
+    }
+
+    /**
+     * @brief Restituisce l'altezza di un sottoalbero (solo con avl_balance).
+     */
+    static int heightOf(const Node *node) {
+        return Balance::height(node);
+    }
+
+    /**
+     * @brief Collega un nodo ai figli specificati e ne aggiorna i dati.
+     *
+     * @return Il nodo.
+     */
+    static Node *link(Node *node, Node *left, Node *right) {
+        node->left = left;
+        node->right = right;
+        if (left != nullptr) {
+            left->parent = node;
+        }
+        if (right != nullptr) {
+            right->parent = node;
+        }
+        updateNode(node);
+        return node;
+    }
+
+    /**
+     * @brief Rotazione a sinistra di un sottoalbero staccato.
+     *
+     * @return La nuova radice.
+     */
+    static Node *rotateLeftDetached(Node *x) {
+        Node *y = x->right;
+        link(x, x->left, y->left);
+        return link(y, x, y->right);
+    }
+
+    /**
+     * @brief Rotazione a destra di un sottoalbero staccato.
+     *
+     * @return La nuova radice.
+     */
+    static Node *rotateRightDetached(Node *x) {
+        Node *y = x->left;
+        link(x, y->right, x->right);
+        return link(y, y->left, x);
+    }
+
+    /**
+     * @brief Join AVL quando left è più alto di right di almeno 2.
+     *
+     * Scende lungo il ramo destro di left fino a un sottoalbero alto quanto
+     * right, lo sostituisce con (sottoalbero, mid, right) e ribilancia
+     * risalendo. Il costo è O(altezza(left) - altezza(right)).
+     */
+    static Node *joinRight(Node *left, Node *mid, Node *right) {
+        Node *c = left->right;
+        if (heightOf(c) <= heightOf(right) + 1) {
+            Node *t = link(mid, c, right);
+            if (heightOf(t) <= heightOf(left->left) + 1) {
+                return link(left, left->left, t);
+            }
+            return rotateLeftDetached(link(left, left->left, rotateRightDetached(t)));
+        }
+        Node *t = joinRight(c, mid, right);
+        if (heightOf(t) <= heightOf(left->left) + 1) {
+            return link(left, left->left, t);
+        }
+        return rotateLeftDetached(link(left, left->left, t));
+    }
+
+    /**
+     * @brief Join AVL quando right è più alto di left di almeno 2 (simmetrico di joinRight).
+     */
+    static Node *joinLeft(Node *left, Node *mid, Node *right) {
+        Node *c = right->left;
+        if (heightOf(c) <= heightOf(left) + 1) {
+            Node *t = link(mid, left, c);
+            if (heightOf(t) <= heightOf(right->right) + 1) {
+                return link(right, t, right->right);
+            }
+            return rotateRightDetached(link(right, rotateLeftDetached(t), right->right));
+        }
+        Node *t = joinLeft(left, mid, c);
+        if (heightOf(t) <= heightOf(right->right) + 1) {
+            return link(right, t, right->right);
+        }
+        return rotateRightDetached(link(right, t, right->right));
+    }
+
+    /**
+     * @brief Unisce due alberi AVL staccati e un nodo intermedio.
+     *
+     * @pre i valori di left precedono mid, che precede quelli di right
+     * @return La radice dell'albero AVL risultante.
+     */
+    static Node *joinNodes(Node *left, Node *mid, Node *right) {
+        if (heightOf(left) > heightOf(right) + 1) {
+            return joinRight(left, mid, right);
+        }
+        if (heightOf(right) > heightOf(left) + 1) {
+            return joinLeft(left, mid, right);
+        }
+        return link(mid, left, right);
+    }
+
+    /**
+     * @brief Stacca il massimo da un albero AVL non vuoto.
+     *
+     * @param node Radice dell'albero.
+     * @param rest Impostato alla radice dell'albero senza il massimo.
+     * @return Il nodo del massimo, senza figli.
+     */
+    static Node *splitLast(Node *node, Node *&rest) {
+        if (node->right == nullptr) {
+            rest = node->left;
+            node->left = nullptr;
+            return node;
+        }
+        Node *right;
+        Node *last = splitLast(node->right, right);
+        rest = joinNodes(node->left, node, right);
+        return last;
+    }
+
+    /**
+     * @brief Concatena due alberi AVL staccati.
+     *
+     * @pre i valori di left precedono quelli di right
+     * @return La radice dell'albero AVL risultante.
+     */
+    static Node *joinTrees(Node *left, Node *right) {
+        if (left == nullptr) {
+            return right;
+        }
+        if (right == nullptr) {
+            return left;
+        }
+        Node *rest;
+        Node *mid = splitLast(left, rest);
+        return joinNodes(rest, mid, right);
+    }
+
+    /**
+     * @brief Divide un albero AVL staccato rispetto a un valore.
+     *
+     * Il costo è O(altezza) e i nodi vengono solo ricollegati.
+     *
+     * @param node Radice dell'albero.
+     * @param key Valore di divisione.
+     * @param left Impostato all'albero dei valori minori di key.
+     * @param right Impostato all'albero dei valori maggiori di key.
+     * @return Il nodo equivalente a key, senza figli, oppure nullptr.
+     */
+    Node *splitNode(Node *node, const T &key, Node *&left, Node *&right) const {
+        if (node == nullptr) {
+            left = right = nullptr;
+            return nullptr;
+        }
+        if (compare(key, node->value)) {
+            Node *between;
+            Node *match = splitNode(node->left, key, left, between);
+            right = joinNodes(between, node, node->right);
+            return match;
+        }
+        if (compare(node->value, key)) {
+            Node *between;
+            Node *match = splitNode(node->right, key, between, right);
+            left = joinNodes(node->left, node, between);
+            return match;
+        }
+        left = node->left;
+        right = node->right;
+        node->left = node->right = nullptr;
+        return node;
+    }
+
+    /**
+     * @brief Unione join-based di due alberi AVL staccati.
+     *
+     * Divide b rispetto alla radice di a e unisce ricorsivamente le due metà,
+     * in parallelo se i sottoalberi sono abbastanza grandi.
+     *
+     * @param a Albero più piccolo.
+     * @param b Albero più grande.
+     * @param aWins true per mantenere i nodi di a a parità di valore.
+     * @param losers Riceve in ordine crescente i nodi duplicati scartati.
+     * @param depth Livelli di ricorsione che possono ancora usare un nuovo thread.
+     * @return La radice dell'unione.
+     */
+    Node *uniteNodes(Node *a, Node *b, bool aWins, NodeList &losers, int depth) const {
+        if (a == nullptr) {
+            return b;
+        }
+        if (b == nullptr) {
+            return a;
+        }
+        Node *bl, *br;
+        Node *match = splitNode(b, a->value, bl, br);
+        Node *al = a->left, *ar = a->right;
+        Node *l = nullptr, *r = nullptr;
+        NodeList leftLosers, rightLosers;
+        invokeBoth(depth > 0 && heightOf(a) >= parallelHeight,
+                   [&]() { l = uniteNodes(al, bl, aWins, leftLosers, depth - 1); },
+                   [&]() { r = uniteNodes(ar, br, aWins, rightLosers, depth - 1); });
+        Node *kept = a;
+        if (match != nullptr && !aWins) {
+            std::swap(kept, match);
+            match->left = match->right = nullptr;
+        }
+        losers.append(leftLosers);
+        losers.push(match);
+        losers.append(rightLosers);
+        return joinNodes(l, kept, r);
+    }
+
+    /**
+     * @brief Intersezione join-based di due alberi AVL staccati.
+     *
+     * @param a Albero più piccolo.
+     * @param b Albero più grande.
+     * @param aWins true per mantenere i nodi di a a parità di valore.
+     * @param garbage Riceve i sottoalberi scartati.
+     * @param depth Livelli di ricorsione che possono ancora usare un nuovo thread.
+     * @return La radice dell'intersezione.
+     */
+    Node *intersectNodes(Node *a, Node *b, bool aWins, NodeList &garbage, int depth) const {
+        if (a == nullptr || b == nullptr) {
+            garbage.push(a);
+            garbage.push(b);
+            return nullptr;
+        }
+        Node *bl, *br;
+        Node *match = splitNode(b, a->value, bl, br);
+        Node *al = a->left, *ar = a->right;
+        a->left = a->right = nullptr;
+        Node *l = nullptr, *r = nullptr;
+        NodeList leftGarbage, rightGarbage;
+        invokeBoth(depth > 0 && heightOf(a) >= parallelHeight,
+                   [&]() { l = intersectNodes(al, bl, aWins, leftGarbage, depth - 1); },
+                   [&]() { r = intersectNodes(ar, br, aWins, rightGarbage, depth - 1); });
+        garbage.append(leftGarbage);
+        garbage.append(rightGarbage);
+        if (match == nullptr) {
+            garbage.push(a);
+            return joinTrees(l, r);
+        }
+        Node *kept = aWins ? a : match;
+        garbage.push(aWins ? match : a);
+        return joinNodes(l, kept, r);
+    }
+
+    /**
+     * @brief Differenza join-based a \ b di due alberi AVL staccati.
+     *
+     * Divide a rispetto alla radice di b: il costo dipende dalla dimensione di b.
+     *
+     * @param a Albero da cui rimuovere i valori.
+     * @param b Albero dei valori da rimuovere.
+     * @param garbage Riceve i sottoalberi scartati.
+     * @param depth Livelli di ricorsione che possono ancora usare un nuovo thread.
+     * @return La radice della differenza.
+     */
+    Node *subtractNodes(Node *a, Node *b, NodeList &garbage, int depth) const {
+        if (a == nullptr || b == nullptr) {
+            garbage.push(b);
+            return a;
+        }
+        Node *al, *ar;
+        Node *match = splitNode(a, b->value, al, ar);
+        Node *bl = b->left, *br = b->right;
+        b->left = b->right = nullptr;
+        Node *l = nullptr, *r = nullptr;
+        NodeList leftGarbage, rightGarbage;
+        invokeBoth(depth > 0 && heightOf(b) >= parallelHeight,
+                   [&]() { l = subtractNodes(al, bl, leftGarbage, depth - 1); },
+                   [&]() { r = subtractNodes(ar, br, rightGarbage, depth - 1); });
+        garbage.append(leftGarbage);
+        garbage.push(b);
+        garbage.push(match);
+        garbage.append(rightGarbage);
+        return joinTrees(l, r);
+    }
+
+    /**
+     * @brief Costruisce un albero bilanciato da nodi staccati in ordine crescente.
+     *
+     * @param nodes Nodi da collegare.
+     * @param n Numero di nodi.
+     * @return La radice dell'albero.
+     */
+    static Node *linkBalanced(Node *const *nodes, std::size_t n) {
+        if (n == 0) {
+            return nullptr;
+        }
+        std::size_t mid = (n - 1) / 2;
+        return link(nodes[mid], linkBalanced(nodes, mid), linkBalanced(nodes + mid + 1, n - mid - 1));
+    }
+
+    /**
+     * @brief Costruisce un albero bilanciato dai nodi di una lista in ordine crescente.
+     *
+     * @param cursor Prossimo nodo della lista, viene avanzato.
+     * @param n Numero di nodi da consumare.
+     * @return La radice dell'albero.
+     */
+    static Node *linkList(Node *&cursor, int n) {
+        if (n == 0) {
+            return nullptr;
+        }
+        Node *left = linkList(cursor, (n - 1) / 2);
+        Node *node = cursor;
+        cursor = cursor->parent;
+        return link(node, left, linkList(cursor, n - 1 - (n - 1) / 2));
+    }
+
+    /**
+     * @brief Aggiunge a un vettore i nodi di un sottoalbero in ordine crescente.
+     */
+    static void appendInOrder(Node *node, std::vector<Node *> &out) {
+        if (node == nullptr) {
+            return;
+        }
+        while (node->left != nullptr) {
+            node = node->left;
+        }
+        for (; node != nullptr; node = successor(node)) {
+            out.push_back(node);
+        }
+    }
+
+    /**
+     * @brief Combina due alberi fondendo le sequenze ordinate dei nodi, in O(n + m).
+     *
+     * Usata senza bilanciamento, quando la forma dei due alberi non dà garanzie
+     * sul costo di split. I vettori sono allocati prima di modificare i nodi.
+     *
+     * @param a Radice di this.
+     * @param b Radice di other.
+     * @param op Operazione da eseguire.
+     * @param losers Riceve i nodi scartati, singoli e in ordine crescente.
+     * @return La radice del risultato, bilanciato.
+     * @throw std::bad_alloc possibile eccezione di allocazione (prima di ogni modifica)
+     */
+    Node *combineLinear(Node *a, Node *b, SetOperation op, NodeList &losers) const {
+        std::vector<Node *> first, second, kept, dropped;
+        appendInOrder(a, first);
+        appendInOrder(b, second);
+        kept.reserve(first.size() + second.size());
+        dropped.reserve(first.size() + second.size());
+        std::size_t i = 0, j = 0;
+        while (i < first.size() || j < second.size()) {
+            if (j == second.size() || (i < first.size() && compare(first[i]->value, second[j]->value))) {
+                (op == setIntersection ? dropped : kept).push_back(first[i++]);
+            } else if (i == first.size() || compare(second[j]->value, first[i]->value)) {
+                (op == setUnion ? kept : dropped).push_back(second[j++]);
+            } else {
+                (op == setDifference ? dropped : kept).push_back(first[i++]);
+                dropped.push_back(second[j++]);
+            }
+        }
+        for (std::size_t k = 0; k < dropped.size(); ++k) {
+            dropped[k]->left = dropped[k]->right = nullptr;
+            losers.push(dropped[k]);
+        }
+        return linkBalanced(kept.data(), kept.size());
+    }
+
+    /**
+     * @brief Conta i nodi di un sottoalbero staccato (con padre della radice nullptr).
+     */
+    static int countNodes(const Node *top) {
+        int n = 0;
+        if (top == nullptr) {
+            return 0;
+        }
+        while (top->left != nullptr) {
+            top = top->left;
+        }
+        for (const Node *node = top; node != nullptr; node = successor(node)) {
+            ++n;
+        }
+        return n;
+    }
+
+    /**
+     * @brief Combina due alberi AVL staccati con gli algoritmi basati su split e join.
+     *
+     * Unione e intersezione dividono l'albero più grande rispetto ai valori di
+     * quello più piccolo.
+     */
+    Node *combineRoots(Node *a, int na, Node *b, int nb, SetOperation op, int depth, NodeList &losers,
+                       std::true_type) const {
+        switch (op) {
+        case setUnion:
+            return na <= nb ? uniteNodes(a, b, true, losers, depth) : uniteNodes(b, a, false, losers, depth);
+        case setIntersection:
+            return na <= nb ? intersectNodes(a, b, true, losers, depth) : intersectNodes(b, a, false, losers, depth);
+        default:
+            return subtractNodes(a, b, losers, depth);
+        }
+    }
+
+    /**
+     * @brief Combina due alberi non bilanciati fondendo le sequenze ordinate dei nodi.
+     */
+    Node *combineRoots(Node *a, int, Node *b, int, SetOperation op, int, NodeList &losers, std::false_type) const {
+        return combineLinear(a, b, op, losers);
+    }
+
+    /**
+     * @brief Esegue un'operazione che consuma other, copiandolo prima se gli allocatori sono diversi.
+     *
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    void combineAdopting(BinarySearchTree &other, SetOperation op, unsigned threads) {
+        if (!(alloc == other.alloc)) {
+            BinarySearchTree copy(sorted_unique, other.begin(), other.end(), get_allocator());
+            combine(copy, op, threads);
+            return;
+        }
+        combine(other, op, threads);
+    }
+
+    /**
+     * @brief Esegue un'operazione insiemistica tra this e other.
+     *
+     * @pre gli allocatori di this e other sono uguali
+     *
+     * Con setUnion i nodi duplicati vengono restituiti a other, con le altre
+     * operazioni i nodi scartati vengono distrutti e other resta vuoto.
+     *
+     * @param other Secondo operando.
+     * @param op Operazione da eseguire.
+     * @param threads Numero massimo di thread (0 per usare quelli disponibili nel sistema).
+     * @throw std::bad_alloc possibile eccezione di allocazione (solo senza bilanciamento, prima di ogni modifica)
+     */
+    void combine(BinarySearchTree &other, SetOperation op, unsigned threads) {
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        int depth = 0;
+        while ((1u << depth) < threads) {
+            ++depth;
+        }
+        NodeList losers;
+        Node *result = combineRoots(root, count, other.root, other.count, op, depth, losers,
+                                    std::integral_constant<bool, Balance::enabled>());
+        int total = count + other.count;
+        root = result;
+        if (root != nullptr) {
+            root->parent = nullptr;
+        }
+        other.root = nullptr;
+        other.count = 0;
+
+        int discarded = 0;
+        if (op == setUnion) {
+            // i duplicati sono nodi singoli, restituiti a other
+            Node *cursor = losers.head;
+            other.root = linkList(cursor, losers.roots);
+            if (other.root != nullptr) {
+                other.root->parent = nullptr;
+            }
+            other.count = discarded = losers.roots;
+        } else {
+            for (Node *top = losers.head; top != nullptr;) {
+                Node *next = top->parent;
+                top->parent = nullptr;
+                discarded += countNodes(top);
+                deleteSubtree(top);
+                top = next;
+            }
+        }
+        count = total - discarded;
+        updateExtremes();
+        other.updateExtremes();
+    }
+
+    /**
+     * @brief Restituisce la dimensione di un sottoalbero staccato, letta da size_augment in O(1).
+     */
+    static int subtreeCount(const Node *node, std::true_type) {
+        return size_augment::count(node);
+    }
+
+    /**
+     * @brief Senza size_augment la dimensione di un sottoalbero staccato si ottiene contandone i nodi in O(n).
+     */
+    static int subtreeCount(const Node *node, std::false_type) {
+        return countNodes(node);
+    }
+
+    /**
+     * @brief Rende node la radice dell'albero (vuoto) e ne aggiorna i dati.
+     *
+     * @param node Radice di un sottoalbero staccato (può essere nullptr).
+     * @param nodes Numero di nodi del sottoalbero.
+     */
+    void adoptRoot(Node *node, int nodes) {
+        root = node;
+        if (root != nullptr) {
+            root->parent = nullptr;
+        }
+        count = nodes;
+        updateExtremes();
+    }
+
+    /**
+     * @brief Ricalcola i dati dei nodi risalendo da node fino alla radice.
+     */
+    static void updateUpward(Node *node) {
+        if (!Augment::enabled) {
+            return;
+        }
+        for (; node != nullptr; node = node->parent) {
+            updateNode(node);
+        }
+    }
+
+    /**
+     * @brief Divide un albero AVL con splitNode; il nodo equivalente a key va a destra.
+     */
+    void splitRoot(const T &key, Node *&left, Node *&right, std::true_type) {
+        Node *match = splitNode(root, key, left, right);
+        if (match != nullptr) {
+            right = joinNodes(nullptr, match, right);
+        }
+    }
+
+    /**
+     * @brief Divide un albero non bilanciato lungo il cammino di ricerca, senza ricorsione.
+     *
+     * Ogni nodo del cammino minore di key viene appeso, con il suo figlio
+     * sinistro, al ramo destro dell'albero sinistro; gli altri, con il loro
+     * figlio destro, al ramo sinistro dell'albero destro.
+     */
+    void splitRoot(const T &key, Node *&left, Node *&right, std::false_type) {
+        left = right = nullptr;
+        Node **leftHook = &left, **rightHook = &right;
+        Node *leftParent = nullptr, *rightParent = nullptr;
+        for (Node *node = root; node != nullptr;) {
+            if (compare(node->value, key)) {
+                *leftHook = node;
+                node->parent = leftParent;
+                leftParent = node;
+                leftHook = &node->right;
+                node = node->right;
+            } else {
+                *rightHook = node;
+                node->parent = rightParent;
+                rightParent = node;
+                rightHook = &node->left;
+                node = node->left;
+            }
+        }
+        *leftHook = nullptr;
+        *rightHook = nullptr;
+        updateUpward(leftParent);
+        updateUpward(rightParent);
+    }
+
+    /**
+     * @brief Concatena due alberi AVL staccati.
+     */
+    Node *joinRoots(Node *left, Node *right, std::true_type) const {
+        return joinTrees(left, right);
+    }
+
+    /**
+     * @brief Concatena due alberi non bilanciati appendendo right sotto il massimo di left.
+     */
+    Node *joinRoots(Node *left, Node *right, std::false_type) const {
+        if (left == nullptr) {
+            return right;
+        }
+        if (right != nullptr) {
+            Node *last = left;
+            while (last->right != nullptr) {
+                last = last->right;
+            }
+            last->right = right;
+            right->parent = last;
+            updateUpward(last);
+        }
+        return left;
+    }
+};
+
+/**
+ * @brief Funzione globale che stampa i valori dell'albero che soddisfano un predicato.
+ *
+ * Il testo passa da un bst_output_buffer e arriva a std::cout a blocchi; come
+ * per operator<<, non viene scritto nulla se std::cout è in errore e la
+ * larghezza si applica solo al primo valore e viene poi azzerata.
+ *
+ * @param bst Albero binario di ricerca sorgente.
+ * @param pred Predicato da soddisfare.
+ */
+template <typename T, typename Comp, typename Equal, typename Balance, typename Augment, typename Alloc, typename P>
+void printIF(const BinarySearchTree<T, Comp, Equal, Balance, Augment, Alloc> &bst, P pred) {
+    bst_output_buffer::write_stream(std::cout, bst.begin(), bst.end(), std::numeric_limits<std::size_t>::max(), pred);
+}
+
+/**
+ * @brief Esegue in parallelo i compiti 0, ..., tasks - 1.
+ *
+ * I thread prelevano il prossimo compito da un contatore atomico condiviso,
+ * per cui un thread che termina presto prosegue con i compiti rimasti invece
+ * di restare inattivo. La prima eccezione lanciata da un compito viene
+ * rilanciata al chiamante dopo la terminazione di tutti i thread.
+ *
+ * @param tasks Numero di compiti.
+ * @param threads Numero di thread (0 per usare quelli disponibili nel sistema).
+ * @param task Funtore chiamato con l'indice di ciascun compito.
+ */
+template <typename F>
+void parallel_run(int tasks, unsigned threads, F task) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = std::min(threads, static_cast<unsigned>(std::max(tasks, 1)));
+    std::atomic<int> next(0);
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    auto worker = [&]() {
+        for (int i = next++; i < tasks; i = next++) {
+            try {
+                task(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+                next = tasks;
+            }
+        }
+    };
+    std::vector<std::thread> pool;
+    try {
+        for (unsigned t = 1; t < threads; ++t) {
+            pool.push_back(std::thread(worker));
+        }
+    } catch (...) {
+        // thread non creati: i compiti restano al thread chiamante
+    }
+    worker();
+    for (std::size_t t = 0; t < pool.size(); ++t) {
+        pool[t].join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+/**
+ * @brief Numero di segmenti per thread nelle visite parallele.
+ *
+ * Più segmenti che thread compensano i segmenti più lunghi di altri.
+ */
+const int parallel_segments_per_thread = 8;
+
+/**
+ * @brief Chiama un visitatore in parallelo sui valori che soddisfano un predicato.
+ *
+ * L'albero è diviso con partition_points in segmenti visitati da thread
+ * diversi; il visitatore può essere chiamato in modo concorrente e in un
+ * ordine qualsiasi. L'albero non deve essere modificato durante la visita.
+ *
+ * @param bst Albero binario di ricerca sorgente.
+ * @param pred Predicato da soddisfare.
+ * @param visit Visitatore chiamato su ogni valore che soddisfa pred.
+ * @param threads Numero di thread (0 per usare quelli disponibili nel sistema).
+ */
+template <typename T, typename Comp, typename Equal, typename Balance, typename Augment, typename Alloc, typename P,
+          typename V>
+void parallel_for_each_if(const BinarySearchTree<T, Comp, Equal, Balance, Augment, Alloc> &bst, P pred, V visit,
+                          unsigned threads = 0) {
+    typedef typename BinarySearchTree<T, Comp, Equal, Balance, Augment, Alloc>::const_iterator iterator;
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    std::vector<iterator> points = bst.partition_points(threads * parallel_segments_per_thread);
+    int segments = static_cast<int>(points.size()) - 1;
+    parallel_run(segments, threads, [&](int i) {
+        for (iterator it = points[i]; it != points[i + 1]; ++it) {
+            if (pred(*it)) {
+                visit(*it);
+            }
+        }
+    });
+}
+
+/**
+ * @brief Conta in parallelo i valori che soddisfano un predicato.
+ *
+ * Ogni segmento produce un conteggio parziale; i conteggi vengono sommati
+ * alla fine.
+ *
+ * @param bst Albero binario di ricerca sorgente.
+ * @param pred Predicato da soddisfare.
+ * @param threads Numero di thread (0 per usare quelli disponibili nel sistema).
+ * @return Il numero di valori che soddisfano pred.
+ */
+template <typename T, typename Comp, typename Equal, typename Balance, typename Augment, typename Alloc, typename P>
+long long parallel_count_if(const BinarySearchTree<T, Comp, Equal, Balance, Augment, Alloc> &bst, P pred,
+                            unsigned threads = 0) {
+    typedef typename BinarySearchTree<T, Comp, Equal, Balance, Augment, Alloc>::const_iterator iterator;
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    std::vector<iterator> points = bst.partition_points(threads * parallel_segments_per_thread);
+    std::vector<long long> partial(points.size(), 0);
+    parallel_run(static_cast<int>(points.size()) - 1, threads, [&](int i) {
+        long long found = 0;
+        for (iterator it = points[i]; it != points[i + 1]; ++it) {
+            if (pred(*it)) {
+                ++found;
+            }
+        }
+        partial[i] = found;
+    });
+    long long total = 0;
+    for (std::size_t i = 0; i < partial.size(); ++i) {
+        total += partial[i];
+    }
+    return total;
+}
+
+/**
+ * @brief Copia in parallelo, in ordine crescente, i valori che soddisfano un predicato.
+ *
+ * Ogni segmento raccoglie i propri valori in un buffer separato; i buffer
+ * vengono concatenati nell'ordine dei segmenti, che è l'ordine delle chiavi.
+ *
+ * @param bst Albero binario di ricerca sorgente.
+ * @param pred Predicato da soddisfare.
+ * @param threads Numero di thread (0 per usare quelli disponibili nel sistema).
+ * @return I valori che soddisfano pred, in ordine crescente.
+ * @throw std::bad_alloc possibile eccezione di allocazione
+ */
+template <typename T, typename Comp, typename Equal, typename Balance, typename Augment, typename Alloc, typename P>
+std::vector<T> parallel_copy_if(const BinarySearchTree<T, Comp, Equal, Balance, Augment, Alloc> &bst, P pred,
+                                unsigned threads = 0) {
+    typedef typename BinarySearchTree<T, Comp, Equal, Balance, Augment, Alloc>::const_iterator iterator;
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    std::vector<iterator> points = bst.partition_points(threads * parallel_segments_per_thread);
+    std::vector<std::vector<T> > buffers(points.size());
+    parallel_run(static_cast<int>(points.size()) - 1, threads, [&](int i) {
+        for (iterator it = points[i]; it != points[i + 1]; ++it) {
+            if (pred(*it)) {
+                buffers[i].push_back(*it);
+            }
+        }
+    });
+    std::size_t total = 0;
+    for (std::size_t i = 0; i < buffers.size(); ++i) {
+        total += buffers[i].size();
+    }
+    std::vector<T> result;
+    result.reserve(total);
+    for (std::size_t i = 0; i < buffers.size(); ++i) {
+        std::move(buffers[i].begin(), buffers[i].end(), std::back_inserter(result));
+    }
+    return result;
+}
+
+/**
+ * @brief Numero indicativo di valori per segmento nella stampa parallela.
+ */
+const std::size_t parallel_dump_segment = 1 << 14;
+
+/**
+ * @brief Stampa in parallelo i valori che soddisfano un predicato, ciascuno seguito da uno spazio.
+ *
+ * L'albero è diviso in segmenti di circa parallel_dump_segment valori; i
+ * segmenti vengono formattati in parallelo a gruppi, ciascuno in una
+ * stringa riutilizzata da un gruppo al successivo, e scritti su os
+ * nell'ordine delle chiavi. L'output è identico a quello della stampa
+ * sequenziale e la memoria usata dipende dal numero di thread, non dalla
+ * dimensione dell'albero: la larghezza di os si applica solo al primo valore
+ * stampato, per cui il segmento che lo contiene, se non è il primo, viene
+ * riformattato. Se la scrittura fallisce viene impostato badbit su os.
+ *
+ * @param bst Albero binario di ricerca sorgente.
+ * @param os Stream di output.
+ * @param pred Predicato da soddisfare.
+ * @param threads Numero di thread (0 per usare quelli disponibili nel sistema).
+ * @throw std::bad_alloc possibile eccezione di allocazione
+ */
+template <typename T, typename Comp, typename Equal, typename Balance, typename Augment, typename Alloc, typename P>
+void parallel_dump_if(const BinarySearchTree<T, Comp, Equal, Balance, Augment, Alloc> &bst, std::ostream &os, P pred,
+                      unsigned threads = 0) {
+    typedef typename BinarySearchTree<T, Comp, Equal, Balance, Augment, Alloc>::const_iterator iterator;
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    std::ostream::sentry ok(os);
+    if (!ok) {
+        return;
+    }
+    int window = static_cast<int>(threads) * parallel_segments_per_thread;
+    std::size_t wanted = std::max<std::size_t>(window, bst.size() / parallel_dump_segment + 1);
+    std::vector<iterator> points =
+        bst.partition_points(static_cast<int>(std::min<std::size_t>(wanted, std::numeric_limits<int>::max())));
+    int segments = static_cast<int>(points.size()) - 1;
+    std::vector<std::string> buffers(std::min(window, std::max(segments, 0)));
+    std::vector<std::size_t> written(buffers.size());
+    std::streambuf *target = os.rdbuf();
+    bool padPending = os.width() != 0;
+    for (int first = 0; first < segments; first += window) {
+        int tasks = std::min(window, segments - first);
+        parallel_run(tasks, threads, [&](int i) {
+            buffers[i].clear();
+            bst_output_buffer buffer(buffers[i]);
+            written[i] = buffer.write_range(os, points[first + i], points[first + i + 1],
+                                            std::numeric_limits<std::size_t>::max(), pred, first + i == 0);
+        });
+        for (int i = 0; i < tasks; ++i) {
+            if (padPending && written[i] > 0) {
+                // il primo valore stampato non era nel primo segmento
+                if (first + i != 0) {
+                    buffers[i].clear();
+                    bst_output_buffer buffer(buffers[i]);
+                    buffer.write_range(os, points[first + i], points[first + i + 1],
+                                       std::numeric_limits<std::size_t>::max(), pred);
+                }
+                padPending = false;
+            }
+            std::streamsize n = static_cast<std::streamsize>(buffers[i].size());
+            if (target->sputn(buffers[i].data(), n) != n) {
+                os.setstate(std::ios_base::badbit);
+                return;
+            }
+        }
+    }
+    os.width(0);
+}
+
+/**
+ * @brief Stampa in parallelo tutti i valori dell'albero, con lo stesso output di operator<<.
+ *
+ * @param bst Albero binario di ricerca sorgente.
+ * @param os Stream di output.
+ * @param threads Numero di thread (0 per usare quelli disponibili nel sistema).
+ * @throw std::bad_alloc possibile eccezione di allocazione
+ */
+template <typename T, typename Comp, typename Equal, typename Balance, typename Augment, typename Alloc>
+void parallel_dump(const BinarySearchTree<T, Comp, Equal, Balance, Augment, Alloc> &bst, std::ostream &os,
+                   unsigned threads = 0) {
+    parallel_dump_if(bst, os, [](const T &) { return true; }, threads);
+}
+
+/**
+ * @brief Versione parallela di printIF.
+ *
+ * I segmenti vengono formattati in parallelo e scritti su std::cout
+ * nell'ordine delle chiavi, per cui l'output è identico a quello di printIF.
+ *
+ * @param bst Albero binario di ricerca sorgente.
+ * @param pred Predicato da soddisfare.
+ * @param threads Numero di thread (0 per usare quelli disponibili nel sistema).
+ */
+template <typename T, typename Comp, typename Equal, typename Balance, typename Augment, typename Alloc, typename P>
+void parallel_printIF(const BinarySearchTree<T, Comp, Equal, Balance, Augment, Alloc> &bst, P pred,
+                      unsigned threads = 0) {
+    parallel_dump_if(bst, std::cout, pred, threads);
 }
 
 #endif // BINARYSEARCHTREE_HPP
\ No newline at end of file
@@ -0,0 +1,789 @@
+/**
+  @file CompactBinarySearchTree.hpp
+
+  @brief File di dichiarazioni/definizioni della classe CompactBinarySearchTree templata
+*/
+
+#ifndef COMPACTBINARYSEARCHTREE_HPP
+#define COMPACTBINARYSEARCHTREE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <ostream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/**
+  @brief Ordine dei nodi dopo CompactBinarySearchTree::compact()
+*/
+enum compact_order {
+    compact_in_order,     ///< Nodi in ordine crescente di valore: visite sequenziali in memoria
+    compact_breadth_first ///< Nodi per livelli dalla radice: i primi livelli di ogni ricerca sono contigui
+};
+
+/**
+  @brief classe CompactBinarySearchTree
+
+  Albero AVL con i nodi memorizzati in un unico array contiguo. I figli sono
+  indici a 32 bit invece che puntatori e non c'è il puntatore al padre: per
+  valori int un nodo occupa 16 byte, contro i 48 circa (32 più l'intestazione
+  di malloc) di un nodo di BinarySearchTree con avl_balance.
+
+  Gli slot dei nodi rimossi vengono riutilizzati tramite una free list
+  collegata attraverso l'indice del figlio sinistro; il loro valore resta
+  costruito finché lo slot non viene riusato o l'array compattato. compact()
+  riordina in loco i nodi in ordine crescente o per livelli ed elimina gli
+  slot liberi.
+
+  Gli iteratori memorizzano il cammino dalla radice e sono invalidati da
+  qualsiasi modifica dell'albero. L'equivalenza usata da inserimento,
+  rimozione e find è derivata da Compare; contains usa Equal come
+  BinarySearchTree.
+*/
+template <typename T, typename Compare, typename Equal>
+class CompactBinarySearchTree {
+
+public:
+    typedef std::uint32_t index_type; ///< Tipo degli indici dei nodi
+
+private:
+    /**
+     * @brief Indice che rappresenta l'assenza di un nodo.
+     */
+    static const index_type nil = 0xFFFFFFFFu;
+
+    /**
+     * @brief Altezza massima di un albero AVL con meno di 2^32 nodi, arrotondata per eccesso.
+     */
+    static const int maxHeight = 64;
+
+    /**
+      @brief Nodo memorizzato nell'array
+    */
+    struct Node {
+        T value;             ///< Valore del nodo
+        index_type left;     ///< Figlio sinistro, nil se assente; prossimo slot libero per i nodi liberi
+        index_type right;    ///< Figlio destro, nil se assente
+        std::uint8_t height; ///< Altezza del sottoalbero (una foglia ha altezza 1)
+
+        /**
+         * @brief Costruttore
+         *
+         * @param v Valore del nodo.
+         */
+        explicit Node(const T &v) : value(v), left(nil), right(nil), height(1) {}
+    };
+
+    std::vector<Node> nodes; ///< Nodi dell'albero e slot liberi
+    index_type root;         ///< Indice della radice
+    index_type freeHead;     ///< Primo slot libero
+    int count;               ///< Numero di valori
+    Compare compare;         ///< Funtore di confronto
+    Equal equals;            ///< Funtore di uguaglianza
+
+    /**
+     * @brief Altezza di un sottoalbero.
+     *
+     * @param i Indice della radice (può essere nil).
+     * @return L'altezza del sottoalbero, 0 se vuoto.
+     */
+    int heightOf(index_type i) const {
+        return i == nil ? 0 : nodes[i].height;
+    }
+
+    /**
+     * @brief Ricalcola l'altezza di un nodo a partire da quella dei figli.
+     *
+     * @param i Indice del nodo.
+     */
+    void updateHeight(index_type i) {
+        nodes[i].height = static_cast<std::uint8_t>(1 + std::max(heightOf(nodes[i].left), heightOf(nodes[i].right)));
+    }
+
+    /**
+     * @brief Fattore di bilanciamento di un nodo.
+     *
+     * @param i Indice del nodo.
+     * @return Differenza tra l'altezza del figlio sinistro e quella del destro.
+     */
+    int factor(index_type i) const {
+        return heightOf(nodes[i].left) - heightOf(nodes[i].right);
+    }
+
+    /**
+     * @brief Rotazione a sinistra del sottoalbero radicato in x.
+     *
+     * @param x Radice del sottoalbero, deve avere un figlio destro.
+     * @return La nuova radice del sottoalbero.
+     */
+    index_type rotateLeft(index_type x) {
+        index_type y = nodes[x].right;
+        nodes[x].right = nodes[y].left;
+        nodes[y].left = x;
+        updateHeight(x);
+        updateHeight(y);
+        return y;
+    }
+
+    /**
+     * @brief Rotazione a destra del sottoalbero radicato in x.
+     *
+     * @param x Radice del sottoalbero, deve avere un figlio sinistro.
+     * @return La nuova radice del sottoalbero.
+     */
+    index_type rotateRight(index_type x) {
+        index_type y = nodes[x].left;
+        nodes[x].left = nodes[y].right;
+        nodes[y].right = x;
+        updateHeight(x);
+        updateHeight(y);
+        return y;
+    }
+
+    /**
+     * @brief Aggiorna l'altezza di un nodo e ne ripristina il bilanciamento.
+     *
+     * @param i Indice del nodo.
+     * @return La radice del sottoalbero dopo le eventuali rotazioni.
+     */
+    index_type balance(index_type i) {
+        updateHeight(i);
+        int f = factor(i);
+        if (f > 1) {
+            if (factor(nodes[i].left) < 0) {
+                nodes[i].left = rotateLeft(nodes[i].left);
+            }
+            return rotateRight(i);
+        }
+        if (f < -1) {
+            if (factor(nodes[i].right) > 0) {
+                nodes[i].right = rotateRight(nodes[i].right);
+            }
+            return rotateLeft(i);
+        }
+        return i;
+    }
+
+    /**
+     * @brief Collega un sottoalbero al posto di un figlio lungo un cammino.
+     *
+     * @param path Cammino dalla radice.
+     * @param right Direzioni prese lungo il cammino (true = destra).
+     * @param k Posizione nel cammino del nodo sostituito.
+     * @param child Nuova radice del sottoalbero.
+     */
+    void relink(const index_type *path, const bool *right, int k, index_type child) {
+        if (k == 0) {
+            root = child;
+        } else if (right[k - 1]) {
+            nodes[path[k - 1]].right = child;
+        } else {
+            nodes[path[k - 1]].left = child;
+        }
+    }
+
+    /**
+     * @brief Ribilancia i nodi di un cammino risalendo verso la radice.
+     *
+     * La risalita si ferma al primo nodo la cui altezza non cambia e che non
+     * richiede rotazioni: gli antenati non sono influenzati dalla modifica.
+     *
+     * @param path Cammino dalla radice.
+     * @param right Direzioni prese lungo il cammino (true = destra).
+     * @param depth Lunghezza del cammino.
+     */
+    void rebalancePath(const index_type *path, const bool *right, int depth) {
+        for (int k = depth - 1; k >= 0; --k) {
+            int before = nodes[path[k]].height;
+            index_type top = balance(path[k]);
+            if (top == path[k] && nodes[top].height == before) {
+                return;
+            }
+            relink(path, right, k, top);
+        }
+    }
+
+    /**
+     * @brief Alloca uno slot per un nuovo nodo, riutilizzando quelli liberi.
+     *
+     * @param value Valore del nodo.
+     * @return L'indice del nuovo nodo.
+     * @throw std::length_error se gli indici a 32 bit sono esauriti
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    index_type allocateNode(const T &value) {
+        if (freeHead != nil) {
+            index_type i = freeHead;
+            nodes[i].value = value;
+            freeHead = nodes[i].left;
+            nodes[i].left = nodes[i].right = nil;
+            nodes[i].height = 1;
+            return i;
+        }
+        if (nodes.size() >= static_cast<std::size_t>(nil)) {
+            throw std::length_error("CompactBinarySearchTree: indici a 32 bit esauriti");
+        }
+        nodes.push_back(Node(value));
+        return static_cast<index_type>(nodes.size() - 1);
+    }
+
+    /**
+     * @brief Restituisce uno slot alla free list.
+     *
+     * @param i Indice dello slot.
+     */
+    void freeNode(index_type i) {
+        nodes[i].left = freeHead;
+        nodes[i].right = nil;
+        freeHead = i;
+    }
+
+    /**
+     * @brief Cerca il nodo uguale a value secondo Equal.
+     *
+     * Come findNode di BinarySearchTree ad ogni livello vengono valutati
+     * equals e compare; la scelta del figlio non dipende da un salto
+     * condizionale e il compilatore la traduce in una selezione senza salti.
+     *
+     * @param value Valore da cercare.
+     * @return L'indice del nodo, nil se non è presente.
+     */
+    index_type findIndex(const T &value) const {
+        index_type current = root;
+        while (current != nil) {
+            const Node &node = nodes[current];
+            if (equals(value, node.value)) {
+                return current;
+            }
+            current = compare(value, node.value) ? node.left : node.right;
+        }
+        return nil;
+    }
+
+    /**
+     * @brief Costruisce un sottoalbero bilanciato da una sequenza ordinata.
+     *
+     * @param it Iteratore al prossimo valore da consumare, viene avanzato.
+     * @param n Numero di valori del sottoalbero.
+     * @return L'indice della radice del sottoalbero.
+     */
+    template <typename Iter>
+    index_type buildSorted(Iter &it, std::size_t n) {
+        if (n == 0) {
+            return nil;
+        }
+        index_type left = buildSorted(it, (n - 1) / 2);
+        index_type node = allocateNode(*it);
+        ++it;
+        nodes[node].left = left;
+        nodes[node].right = buildSorted(it, n - 1 - (n - 1) / 2);
+        updateHeight(node);
+        return node;
+    }
+
+    /**
+     * @brief Elenca gli indici dei nodi nell'ordine richiesto.
+     *
+     * @param order Ordine dei nodi.
+     * @return Gli indici dei count nodi dell'albero.
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    std::vector<index_type> layout(compact_order order) const {
+        std::vector<index_type> result;
+        result.reserve(static_cast<std::size_t>(count));
+        if (root == nil) {
+            return result;
+        }
+        if (order == compact_breadth_first) {
+            result.push_back(root);
+            for (std::size_t i = 0; i < result.size(); ++i) {
+                const Node &node = nodes[result[i]];
+                if (node.left != nil) {
+                    result.push_back(node.left);
+                }
+                if (node.right != nil) {
+                    result.push_back(node.right);
+                }
+            }
+            return result;
+        }
+        index_type stack[maxHeight];
+        int top = 0;
+        index_type current = root;
+        while (current != nil || top > 0) {
+            for (; current != nil; current = nodes[current].left) {
+                stack[top++] = current;
+            }
+            current = stack[--top];
+            result.push_back(current);
+            current = nodes[current].right;
+        }
+        return result;
+    }
+
+public:
+    /**
+     * @brief Iteratore costante per l'albero compatto.
+     */
+    class const_iterator {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const T *pointer;
+        typedef const T &reference;
+
+        /**
+         * @brief Costruttore di default.
+         */
+        const_iterator() : tree(nullptr) {}
+
+        /**
+         * @brief Dereferenzia l'iteratore.
+         *
+         * @return Il riferimento al valore puntato dall'iteratore.
+         */
+        reference operator*() const {
+            return tree->nodes[path.back()].value;
+        }
+
+        /**
+         * @brief Accede al membro puntato dall'iteratore.
+         *
+         * @return Un puntatore al valore puntato dall'iteratore.
+         */
+        pointer operator->() const {
+            return &tree->nodes[path.back()].value;
+        }
+
+        /**
+         * @brief Operatore di pre-incremento.
+         *
+         * @return Un riferimento all'iteratore avanzato.
+         */
+        const_iterator &operator++() {
+            index_type node = path.back();
+            path.pop_back();
+            pushLeft(tree->nodes[node].right);
+            return *this;
+        }
+
+        /**
+         * @brief Operatore di post-incremento.
+         *
+         * @return L'iteratore alla posizione precedente.
+         */
+        const_iterator operator++(int) {
+            const_iterator tmp(*this);
+            ++(*this);
+            return tmp;
+        }
+
+        /**
+         * @brief Operatore di uguaglianza.
+         *
+         * @param other L'iteratore da confrontare.
+         * @return true se gli iteratori puntano allo stesso nodo (o sono entrambi alla fine).
+         */
+        bool operator==(const const_iterator &other) const {
+            index_type a = path.empty() ? nil : path.back();
+            index_type b = other.path.empty() ? nil : other.path.back();
+            return a == b;
+        }
+
+        /**
+         * @brief Operatore di disuguaglianza.
+         *
+         * @param other L'iteratore da confrontare.
+         * @return true se gli iteratori sono diversi, false altrimenti.
+         */
+        bool operator!=(const const_iterator &other) const {
+            return !(*this == other);
+        }
+
+    private:
+        const CompactBinarySearchTree *tree; ///< Albero visitato
+        std::vector<index_type> path;        ///< Antenati ancora da visitare; l'ultimo è il nodo corrente
+
+        /**
+         * @brief Costruttore privato per un iteratore alla fine della visita.
+         *
+         * @param tree Albero da visitare.
+         */
+        explicit const_iterator(const CompactBinarySearchTree *tree) : tree(tree) {}
+
+        /**
+         * @brief Scende a sinistra da un nodo memorizzando il cammino.
+         */
+        void pushLeft(index_type node) {
+            for (; node != nil; node = tree->nodes[node].left) {
+                path.push_back(node);
+            }
+        }
+
+        friend class CompactBinarySearchTree;
+    };
+
+    /**
+      @brief Costruttore di default
+
+      Inizializza un albero vuoto.
+     */
+    CompactBinarySearchTree() : root(nil), freeHead(nil), count(0) {}
+
+    /**
+     * @brief Costruttore tramite sequenza di iteratori.
+     *
+     * Se la sequenza è strettamente ordinata l'albero viene costruito
+     * direttamente in O(n), altrimenti i valori vengono inseriti uno alla volta.
+     *
+     * @param begin iteratore di inizio sequenza
+     * @param end iteratore di fine sequenza
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    template <typename Iter>
+    CompactBinarySearchTree(Iter begin, Iter end) : root(nil), freeHead(nil), count(0) {
+        std::vector<T> values(begin, end);
+        bool sorted = true;
+        for (std::size_t i = 1; i < values.size() && sorted; ++i) {
+            sorted = compare(values[i - 1], values[i]);
+        }
+        if (sorted) {
+            nodes.reserve(values.size());
+            typename std::vector<T>::const_iterator it = values.begin();
+            root = buildSorted(it, values.size());
+            count = static_cast<int>(values.size());
+        } else {
+            for (std::size_t i = 0; i < values.size(); ++i) {
+                insert(values[i]);
+            }
+        }
+    }
+
+    /**
+     * @brief Move constructor
+     *
+     * @param other Albero da cui prendere i nodi, che resta vuoto.
+     */
+    CompactBinarySearchTree(CompactBinarySearchTree &&other)
+        : nodes(std::move(other.nodes)), root(other.root), freeHead(other.freeHead), count(other.count),
+          compare(other.compare), equals(other.equals) {
+        other.nodes.clear();
+        other.root = other.freeHead = nil;
+        other.count = 0;
+    }
+
+    /**
+     * @brief Copy constructor
+     *
+     * Copia l'array dei nodi in un'unica allocazione; gli indici restano validi.
+     *
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    CompactBinarySearchTree(const CompactBinarySearchTree &) = default;
+
+    /**
+     * @brief Operatore di assegnamento
+     *
+     * @param other Albero da copiare o da cui prendere i nodi.
+     * @return reference all'albero this
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    CompactBinarySearchTree &operator=(CompactBinarySearchTree other) {
+        swap(other);
+        return *this;
+    }
+
+    /**
+     * @brief Scambia il contenuto di due alberi in O(1).
+     *
+     * @param other Albero con cui scambiare i nodi.
+     */
+    void swap(CompactBinarySearchTree &other) {
+        nodes.swap(other.nodes);
+        std::swap(root, other.root);
+        std::swap(freeHead, other.freeHead);
+        std::swap(count, other.count);
+        std::swap(compare, other.compare);
+        std::swap(equals, other.equals);
+    }
+
+    /**
+     * @brief Inserisce un valore, se non è già presente.
+     *
+     * @param value Il valore da inserire.
+     * @return true se il valore è stato inserito, false se era già presente.
+     * @throw std::length_error se gli indici a 32 bit sono esauriti
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    bool insert(const T &value) {
+        index_type path[maxHeight];
+        bool right[maxHeight] = {};
+        int depth = 0;
+        for (index_type current = root; current != nil; ++depth) {
+            path[depth] = current;
+            if (compare(value, nodes[current].value)) {
+                right[depth] = false;
+                current = nodes[current].left;
+            } else if (compare(nodes[current].value, value)) {
+                right[depth] = true;
+                current = nodes[current].right;
+            } else {
+                return false;
+            }
+        }
+        index_type node = allocateNode(value);
+        path[depth] = node;
+        relink(path, right, depth, node);
+        rebalancePath(path, right, depth);
+        ++count;
+        return true;
+    }
+
+    /**
+     * @brief Rimuove un valore, se presente.
+     *
+     * Un nodo con due figli viene sostituito dal suo successore, ricollegato
+     * al suo posto senza copiare valori.
+     *
+     * @param value Il valore da rimuovere.
+     * @return true se il valore è stato rimosso, false se non era presente.
+     */
+    bool remove(const T &value) {
+        index_type path[maxHeight];
+        bool right[maxHeight] = {};
+        int depth = 0;
+        index_type current = root;
+        while (current != nil) {
+            path[depth] = current;
+            if (compare(value, nodes[current].value)) {
+                right[depth++] = false;
+                current = nodes[current].left;
+            } else if (compare(nodes[current].value, value)) {
+                right[depth++] = true;
+                current = nodes[current].right;
+            } else {
+                break;
+            }
+        }
+        if (current == nil) {
+            return false;
+        }
+        int removed = depth;
+        Node &node = nodes[current];
+        if (node.left != nil && node.right != nil) {
+            // il successore prende il posto del nodo nel cammino
+            right[depth++] = true;
+            index_type next = node.right;
+            while (nodes[next].left != nil) {
+                path[depth] = next;
+                right[depth++] = false;
+                next = nodes[next].left;
+            }
+            relink(path, right, depth, nodes[next].right);
+            nodes[next].left = node.left;
+            nodes[next].right = node.right;
+            nodes[next].height = node.height;
+            path[removed] = next;
+            relink(path, right, removed, next);
+        } else {
+            relink(path, right, removed, node.left != nil ? node.left : node.right);
+        }
+        freeNode(current);
+        rebalancePath(path, right, depth);
+        --count;
+        return true;
+    }
+
+    /**
+     * @brief Verifica se un valore è presente nell'albero.
+     *
+     * @param value Il valore da cercare.
+     * @return true se il valore è presente, false altrimenti.
+     */
+    bool contains(const T &value) const {
+        return findIndex(value) != nil;
+    }
+
+    /**
+     * @brief Restituisce un iteratore al valore equivalente a quello specificato.
+     *
+     * @param value Il valore da cercare.
+     * @return Un iteratore al valore, end() se non è presente.
+     */
+    const_iterator find(const T &value) const {
+        const_iterator it(this);
+        index_type current = root;
+        while (current != nil) {
+            if (compare(value, nodes[current].value)) {
+                it.path.push_back(current);
+                current = nodes[current].left;
+            } else if (compare(nodes[current].value, value)) {
+                current = nodes[current].right;
+            } else {
+                it.path.push_back(current);
+                return it;
+            }
+        }
+        return end();
+    }
+
+    /**
+     * @brief Restituisce un iteratore al primo valore non minore di quello specificato.
+     *
+     * @param value Il valore di riferimento.
+     * @return Un iteratore al primo valore v tale che !(v < value), end() se non esiste.
+     */
+    const_iterator lower_bound(const T &value) const {
+        const_iterator it(this);
+        index_type current = root;
+        while (current != nil) {
+            if (compare(nodes[current].value, value)) {
+                current = nodes[current].right;
+            } else {
+                it.path.push_back(current);
+                current = nodes[current].left;
+            }
+        }
+        return it;
+    }
+
+    /**
+     * @brief Restituisce il numero di valori.
+     *
+     * @return Il numero di valori presenti nell'albero.
+     */
+    int size() const {
+        return count;
+    }
+
+    /**
+     * @brief Verifica se l'albero è vuoto.
+     *
+     * @return true se l'albero non contiene valori.
+     */
+    bool empty() const {
+        return count == 0;
+    }
+
+    /**
+     * @brief Restituisce l'altezza dell'albero.
+     *
+     * @return L'altezza dell'albero, 0 se vuoto.
+     */
+    int height() const {
+        return heightOf(root);
+    }
+
+    /**
+     * @brief Restituisce il numero di slot allocati, occupati o liberi.
+     *
+     * @return Il numero di nodi che l'array contiene senza riallocare.
+     */
+    std::size_t capacity() const {
+        return nodes.capacity();
+    }
+
+    /**
+     * @brief Riserva spazio per almeno n nodi.
+     *
+     * @param n Numero di nodi.
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    void reserve(std::size_t n) {
+        nodes.reserve(n);
+    }
+
+    /**
+     * @brief Cancella tutti i valori dell'albero.
+     *
+     * La capacità dell'array viene mantenuta.
+     */
+    void clear() {
+        nodes.clear();
+        root = freeHead = nil;
+        count = 0;
+    }
+
+    /**
+     * @brief Riordina i nodi in loco ed elimina gli slot liberi.
+     *
+     * Dopo la compattazione i nodi occupano le prime size() posizioni
+     * dell'array nell'ordine richiesto: in ordine crescente la visita legge
+     * la memoria in sequenza, per livelli i nodi vicini alla radice, visitati
+     * da ogni ricerca, stanno nelle stesse pagine. Il costo è O(n) con un
+     * array di indici temporaneo; la capacità dell'array non cambia.
+     *
+     * @param order Ordine dei nodi.
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    void compact(compact_order order = compact_in_order) {
+        std::vector<index_type> sequence = layout(order);
+        std::vector<index_type> target(nodes.size(), nil);
+        for (std::size_t i = 0; i < sequence.size(); ++i) {
+            target[sequence[i]] = static_cast<index_type>(i);
+        }
+        index_type newRoot = root == nil ? nil : target[root];
+        for (std::size_t i = 0; i < sequence.size(); ++i) {
+            Node &node = nodes[sequence[i]];
+            node.left = node.left == nil ? nil : target[node.left];
+            node.right = node.right == nil ? nil : target[node.right];
+        }
+        // ogni scambio porta un nodo nella sua posizione definitiva
+        for (std::size_t i = 0; i < nodes.size(); ++i) {
+            while (target[i] != nil && target[i] != i) {
+                index_type j = target[i];
+                std::swap(nodes[i], nodes[j]);
+                std::swap(target[i], target[j]);
+            }
+        }
+        nodes.erase(nodes.begin() + count, nodes.end());
+        root = newRoot;
+        freeHead = nil;
+    }
+
+    /**
+     * @brief Restituisce un iteratore costante all'inizio dell'albero.
+     *
+     * @return Un iteratore costante al valore minimo.
+     */
+    const_iterator begin() const {
+        const_iterator it(this);
+        it.pushLeft(root);
+        return it;
+    }
+
+    /**
+     * @brief Restituisce un iteratore costante alla fine dell'albero.
+     *
+     * @return Un iteratore costante alla posizione successiva all'ultimo valore.
+     */
+    const_iterator end() const {
+        return const_iterator(this);
+    }
+
+    /**
+     * @brief Funzione amica per la stampa dell'albero.
+     *
+     * @param os Stream di output.
+     * @param tree Albero da stampare.
+     * @return Lo stream di output.
+     */
+    friend std::ostream &operator<<(std::ostream &os, const CompactBinarySearchTree &tree) {
+        for (const_iterator it = tree.begin(); it != tree.end(); ++it) {
+            os << *it << " ";
+        }
+        return os;
+    }
+};
+
+template <typename T, typename Compare, typename Equal>
+const typename CompactBinarySearchTree<T, Compare, Equal>::index_type CompactBinarySearchTree<T, Compare, Equal>::nil;
+
+template <typename T, typename Compare, typename Equal>
+const int CompactBinarySearchTree<T, Compare, Equal>::maxHeight;
+
+#endif
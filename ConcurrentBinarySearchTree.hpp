@@ -0,0 +1,664 @@
+/**
+  @file ConcurrentBinarySearchTree.hpp
+
+  @brief File di dichiarazioni/definizioni della classe ConcurrentBinarySearchTree templata
+*/
+
+#ifndef CONCURRENTBINARYSEARCHTREE_HPP
+#define CONCURRENTBINARYSEARCHTREE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+/**
+  @brief classe ConcurrentBinarySearchTree
+
+  Albero AVL condivisibile tra thread: contains, size e l'iterazione non
+  acquisiscono lock e non vengono mai bloccati dagli scrittori.
+
+  I nodi pubblicati sono immutabili. Un inserimento o una rimozione copia il
+  cammino dalla radice al punto modificato (O(log n) nodi) e pubblica la nuova
+  radice con un'unica scrittura atomica, per cui un lettore vede sempre una
+  versione completa e bilanciata dell'albero. Gli scrittori sono serializzati
+  tra loro da un mutex che i lettori non toccano.
+
+  I nodi sostituiti vengono liberati con una reclamazione a epoche: ogni
+  lettore si registra nel contatore dell'epoca corrente per la durata della
+  visita, e i nodi ritirati in un'epoca sono liberati solo quando nessun
+  lettore di quell'epoca è ancora attivo. I contatori sono distribuiti su
+  readerStripes slot, ciascuno in una propria linea di cache, e ogni thread
+  usa sempre lo stesso slot: lettori su core diversi non si contendono la
+  stessa linea e lo scrittore somma gli slot quando deve avanzare l'epoca. Un iteratore mantiene la
+  registrazione finché esiste, quindi gli iteratori di lunga durata ritardano
+  (ma non bloccano) la liberazione della memoria.
+
+  L'equivalenza usata dagli scrittori è derivata da Compare; Equal è usato
+  per la verifica finale di contains, come in BinarySearchTree.
+*/
+template <typename T, typename Compare, typename Equal>
+class ConcurrentBinarySearchTree {
+
+private:
+    /**
+      @brief Nodo immutabile dell'albero
+    */
+    struct Node {
+        const T value;     ///< Valore del nodo
+        const Node *left;  ///< Figlio sinistro
+        const Node *right; ///< Figlio destro
+        int height;        ///< Altezza del sottoalbero (una foglia ha altezza 1)
+
+        /**
+         * @brief Costruttore
+         *
+         * @param v Valore del nodo.
+         * @param l Figlio sinistro.
+         * @param r Figlio destro.
+         */
+        Node(const T &v, const Node *l, const Node *r)
+            : value(v), left(l), right(r), height(1 + std::max(heightOf(l), heightOf(r))) {}
+    };
+
+    /**
+      @brief Nodi creati e sostituiti da una singola modifica
+    */
+    struct Update {
+        std::vector<const Node *> created; ///< Nodi allocati, da liberare se la modifica fallisce
+        std::vector<const Node *> retired; ///< Nodi da ritirare se la modifica viene pubblicata
+    };
+
+    static const std::size_t cacheLine = 64; ///< Dimensione (presunta) di una linea di cache
+    static const unsigned readerStripes = 64; ///< Numero di slot dei contatori dei lettori
+
+    /**
+      @brief Contatori dei lettori di uno slot, per parità di epoca
+
+      Occupa esattamente una linea di cache, per cui slot diversi non
+      condividono linee.
+    */
+    struct ReaderSlot {
+        std::atomic<int> readers[2];                            ///< Lettori attivi per parità di epoca
+        char padding[cacheLine - 2 * sizeof(std::atomic<int>)]; ///< Riempimento fino alla linea di cache
+    };
+
+    static_assert(sizeof(ReaderSlot) == cacheLine, "ReaderSlot deve occupare una linea di cache");
+
+    std::atomic<const Node *> root;   ///< Versione pubblicata dell'albero
+    std::atomic<int> count;           ///< Numero di valori nella versione pubblicata
+    mutable std::atomic<unsigned> epoch;      ///< Epoca corrente
+    std::unique_ptr<char[]> slotMemory;       ///< Memoria degli slot, allocata a parte per allinearla
+    ReaderSlot *slots;                        ///< Slot dei lettori, allineati alla linea di cache
+    std::vector<const Node *> retiredNodes[2]; ///< Nodi ritirati per parità di epoca
+    std::mutex writer;                ///< Serializza gli scrittori
+    Compare compare;                  ///< Funtore di confronto
+    Equal equals;                     ///< Funtore di uguaglianza
+
+    /**
+      @brief Registrazione di un lettore nell'epoca corrente
+
+      Finché esiste, i nodi raggiungibili dalla radice letta dopo la sua
+      creazione non vengono liberati.
+    */
+    class Guard {
+    public:
+        /**
+         * @brief Registra il lettore nell'epoca corrente, nello slot del thread chiamante.
+         *
+         * @param tree Albero da leggere (nullptr per una guardia vuota).
+         */
+        explicit Guard(const ConcurrentBinarySearchTree *tree) : counter(nullptr) {
+            if (tree == nullptr) {
+                return;
+            }
+            ReaderSlot &slot = tree->slots[threadStripe()];
+            for (;;) {
+                unsigned e = tree->epoch.load();
+                counter = &slot.readers[e & 1];
+                counter->fetch_add(1);
+                // se l'epoca è cambiata nel frattempo il contatore potrebbe
+                // essere già stato controllato da uno scrittore: riprova
+                if (tree->epoch.load() == e) {
+                    break;
+                }
+                counter->fetch_sub(1);
+            }
+        }
+
+        /**
+         * @brief Copy constructor: registra un altro lettore nella stessa epoca.
+         *
+         * La copia usa lo stesso contatore dell'originale, anche se creata
+         * da un altro thread.
+         *
+         * @param other Guardia da copiare.
+         */
+        Guard(const Guard &other) : counter(other.counter) {
+            if (counter != nullptr) {
+                counter->fetch_add(1);
+            }
+        }
+
+        /**
+         * @brief Operatore di assegnamento
+         *
+         * @param other Guardia da copiare.
+         * @return reference alla guardia this
+         */
+        Guard &operator=(Guard other) {
+            std::swap(counter, other.counter);
+            return *this;
+        }
+
+        /**
+         * @brief Distruttore: termina la registrazione.
+         */
+        ~Guard() {
+            if (counter != nullptr) {
+                counter->fetch_sub(1);
+            }
+        }
+
+    private:
+        std::atomic<int> *counter; ///< Contatore di registrazione (slot e parità dell'epoca)
+    };
+
+    /**
+     * @brief Restituisce lo slot dei lettori del thread chiamante.
+     *
+     * Gli slot sono assegnati ai thread a rotazione al loro primo accesso:
+     * fino a readerStripes thread lettori usano slot distinti.
+     */
+    static unsigned threadStripe() {
+        static std::atomic<unsigned> nextStripe(0);
+        static thread_local unsigned stripe = nextStripe.fetch_add(1) % readerStripes;
+        return stripe;
+    }
+
+    /**
+     * @brief Restituisce l'altezza di un sottoalbero.
+     */
+    static int heightOf(const Node *node) {
+        return node == nullptr ? 0 : node->height;
+    }
+
+    /**
+     * @brief Alloca un nodo e lo registra tra quelli creati dalla modifica.
+     *
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    static const Node *make(Update &update, const T &value, const Node *left, const Node *right) {
+        update.created.reserve(update.created.size() + 1);
+        const Node *node = new Node(value, left, right);
+        update.created.push_back(node);
+        return node;
+    }
+
+    /**
+     * @brief Ritira un nodo sostituito dalla modifica.
+     *
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    static void retire(Update &update, const Node *node) {
+        update.retired.push_back(node);
+    }
+
+    /**
+     * @brief Crea un nodo con i figli dati, ruotando se i figli sono sbilanciati.
+     *
+     * I figli differiscono in altezza al più di 2; i nodi ruotati vengono
+     * copiati e ritirati.
+     *
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    static const Node *balance(Update &update, const T &value, const Node *left, const Node *right) {
+        int hl = heightOf(left);
+        int hr = heightOf(right);
+        if (hl > hr + 1) {
+            retire(update, left);
+            if (heightOf(left->left) >= heightOf(left->right)) {
+                return make(update, left->value, left->left, make(update, value, left->right, right));
+            }
+            const Node *lr = left->right;
+            retire(update, lr);
+            return make(update, lr->value, make(update, left->value, left->left, lr->left),
+                        make(update, value, lr->right, right));
+        }
+        if (hr > hl + 1) {
+            retire(update, right);
+            if (heightOf(right->right) >= heightOf(right->left)) {
+                return make(update, right->value, make(update, value, left, right->left), right->right);
+            }
+            const Node *rl = right->left;
+            retire(update, rl);
+            return make(update, rl->value, make(update, value, left, rl->left),
+                        make(update, right->value, rl->right, right->right));
+        }
+        return make(update, value, left, right);
+    }
+
+    /**
+     * @brief Inserisce un valore assente copiando il cammino (profondità O(log n)).
+     *
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    const Node *insertPath(Update &update, const Node *node, const T &value) const {
+        if (node == nullptr) {
+            return make(update, value, nullptr, nullptr);
+        }
+        retire(update, node);
+        if (compare(value, node->value)) {
+            return balance(update, node->value, insertPath(update, node->left, value), node->right);
+        }
+        return balance(update, node->value, node->left, insertPath(update, node->right, value));
+    }
+
+    /**
+     * @brief Rimuove il minimo di un sottoalbero non vuoto copiando il cammino.
+     *
+     * @param minimum Impostato al valore rimosso.
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    static const Node *removeMinPath(Update &update, const Node *node, const Node *&minimum) {
+        retire(update, node);
+        if (node->left == nullptr) {
+            minimum = node;
+            return node->right;
+        }
+        return balance(update, node->value, removeMinPath(update, node->left, minimum), node->right);
+    }
+
+    /**
+     * @brief Rimuove un valore presente copiando il cammino (profondità O(log n)).
+     *
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    const Node *removePath(Update &update, const Node *node, const T &value) const {
+        retire(update, node);
+        if (compare(value, node->value)) {
+            return balance(update, node->value, removePath(update, node->left, value), node->right);
+        }
+        if (compare(node->value, value)) {
+            return balance(update, node->value, node->left, removePath(update, node->right, value));
+        }
+        if (node->left == nullptr) {
+            return node->right;
+        }
+        if (node->right == nullptr) {
+            return node->left;
+        }
+        const Node *minimum = nullptr;
+        const Node *right = removeMinPath(update, node->right, minimum);
+        return balance(update, minimum->value, node->left, right);
+    }
+
+    /**
+     * @brief Cerca un valore a partire da un nodo, senza sincronizzazione.
+     *
+     * @return Il nodo con valore equivalente secondo Compare, nullptr se assente.
+     */
+    const Node *findNode(const Node *node, const T &value) const {
+        while (node != nullptr) {
+            if (compare(value, node->value)) {
+                node = node->left;
+            } else if (compare(node->value, value)) {
+                node = node->right;
+            } else {
+                return node;
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief Pubblica la radice di una modifica e ne ritira i nodi sostituiti.
+     *
+     * Da chiamare con il mutex degli scrittori acquisito.
+     *
+     * @param update Modifica da pubblicare.
+     * @param newRoot Nuova radice.
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    void publish(Update &update, const Node *newRoot) {
+        std::vector<const Node *> &bucket = retiredNodes[epoch.load() & 1];
+        bucket.reserve(bucket.size() + update.retired.size());
+        root.store(newRoot);
+        bucket.insert(bucket.end(), update.retired.begin(), update.retired.end());
+        tryAdvance();
+    }
+
+    /**
+     * @brief Libera i nodi ritirati nell'epoca precedente e avanza, se possibile.
+     *
+     * I nodi ritirati nell'epoca e - 1 sono raggiungibili solo da lettori
+     * registrati in e - 1, perché chi si registra in e legge una radice
+     * pubblicata dopo il loro ritiro. Quando quei lettori sono usciti i nodi
+     * vengono liberati e l'epoca avanza, riusando il contenitore liberato.
+     * Da chiamare con il mutex degli scrittori acquisito.
+     */
+    void tryAdvance() {
+        unsigned e = epoch.load();
+        unsigned previous = (e - 1) & 1;
+        for (unsigned i = 0; i < readerStripes; ++i) {
+            if (slots[i].readers[previous].load() != 0) {
+                return;
+            }
+        }
+        std::vector<const Node *> &bucket = retiredNodes[previous];
+        for (std::size_t i = 0; i < bucket.size(); ++i) {
+            delete bucket[i];
+        }
+        bucket.clear();
+        epoch.store(e + 1);
+    }
+
+    /**
+     * @brief Aggiunge a una lista tutti i nodi di un sottoalbero.
+     *
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    static void collect(const Node *node, std::vector<const Node *> &out) {
+        std::vector<const Node *> stack;
+        if (node != nullptr) {
+            stack.push_back(node);
+        }
+        while (!stack.empty()) {
+            const Node *current = stack.back();
+            stack.pop_back();
+            out.push_back(current);
+            if (current->left != nullptr) {
+                stack.push_back(current->left);
+            }
+            if (current->right != nullptr) {
+                stack.push_back(current->right);
+            }
+        }
+    }
+
+    ConcurrentBinarySearchTree(const ConcurrentBinarySearchTree &);
+    ConcurrentBinarySearchTree &operator=(const ConcurrentBinarySearchTree &);
+
+public:
+    /**
+     * @brief Iteratore costante in ordine crescente su una versione dell'albero.
+     *
+     * L'iteratore fissa la versione pubblicata al momento di begin(): le
+     * modifiche successive non sono visibili e i suoi nodi restano validi
+     * finché l'iteratore (o una sua copia) esiste. Non usa lock.
+     */
+    class const_iterator {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const T *pointer;
+        typedef const T &reference;
+
+        /**
+         * @brief Costruttore di default.
+         */
+        const_iterator() : guard(nullptr) {}
+
+        /**
+         * @brief Dereferenzia l'iteratore.
+         *
+         * @return Il riferimento al valore puntato dall'iteratore.
+         */
+        reference operator*() const {
+            return path.back()->value;
+        }
+
+        /**
+         * @brief Accede al membro puntato dall'iteratore.
+         *
+         * @return Un puntatore al valore puntato dall'iteratore.
+         */
+        pointer operator->() const {
+            return &path.back()->value;
+        }
+
+        /**
+         * @brief Operatore di pre-incremento.
+         *
+         * @return Un riferimento all'iteratore avanzato.
+         */
+        const_iterator &operator++() {
+            const Node *node = path.back();
+            path.pop_back();
+            pushLeft(node->right);
+            return *this;
+        }
+
+        /**
+         * @brief Operatore di post-incremento.
+         *
+         * @return L'iteratore alla posizione precedente.
+         */
+        const_iterator operator++(int) {
+            const_iterator tmp(*this);
+            ++(*this);
+            return tmp;
+        }
+
+        /**
+         * @brief Operatore di uguaglianza.
+         *
+         * @param other L'iteratore da confrontare.
+         * @return true se gli iteratori puntano allo stesso nodo (o sono entrambi alla fine).
+         */
+        bool operator==(const const_iterator &other) const {
+            const Node *a = path.empty() ? nullptr : path.back();
+            const Node *b = other.path.empty() ? nullptr : other.path.back();
+            return a == b;
+        }
+
+        /**
+         * @brief Operatore di disuguaglianza.
+         *
+         * @param other L'iteratore da confrontare.
+         * @return true se gli iteratori sono diversi, false altrimenti.
+         */
+        bool operator!=(const const_iterator &other) const {
+            return !(*this == other);
+        }
+
+    private:
+        Guard guard;                   ///< Registrazione che mantiene valida la versione
+        std::vector<const Node *> path; ///< Antenati ancora da visitare; l'ultimo è il nodo corrente
+
+        /**
+         * @brief Costruttore privato: si registra come lettore e fissa la radice corrente.
+         *
+         * @param tree Albero da visitare.
+         */
+        explicit const_iterator(const ConcurrentBinarySearchTree *tree) : guard(tree) {
+            pushLeft(tree->root.load());
+        }
+
+        /**
+         * @brief Scende a sinistra da un nodo memorizzando il cammino.
+         */
+        void pushLeft(const Node *node) {
+            for (; node != nullptr; node = node->left) {
+                path.push_back(node);
+            }
+        }
+
+        friend class ConcurrentBinarySearchTree;
+    };
+
+    /**
+      @brief Costruttore di default
+
+      Inizializza un albero vuoto.
+     */
+    ConcurrentBinarySearchTree()
+        : root(nullptr), count(0), epoch(0), slotMemory(new char[readerStripes * sizeof(ReaderSlot) + cacheLine]) {
+        std::uintptr_t address = reinterpret_cast<std::uintptr_t>(slotMemory.get());
+        address = (address + cacheLine - 1) & ~static_cast<std::uintptr_t>(cacheLine - 1);
+        slots = reinterpret_cast<ReaderSlot *>(address);
+        for (unsigned i = 0; i < readerStripes; ++i) {
+            new (&slots[i]) ReaderSlot();
+            slots[i].readers[0].store(0);
+            slots[i].readers[1].store(0);
+        }
+    }
+
+    /**
+     * @brief Distruttore
+     *
+     * @pre nessun altro thread usa l'albero o un suo iteratore
+     */
+    ~ConcurrentBinarySearchTree() {
+        std::vector<const Node *> nodes;
+        collect(root.load(), nodes);
+        for (int i = 0; i < 2; ++i) {
+            nodes.insert(nodes.end(), retiredNodes[i].begin(), retiredNodes[i].end());
+        }
+        for (std::size_t i = 0; i < nodes.size(); ++i) {
+            delete nodes[i];
+        }
+    }
+
+    /**
+     * @brief Inserisce un valore, se non è già presente.
+     *
+     * Può essere chiamata da più thread; non blocca i lettori.
+     *
+     * @param value Il valore da inserire.
+     * @return true se il valore è stato inserito, false se era già presente.
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    bool insert(const T &value) {
+        std::lock_guard<std::mutex> lock(writer);
+        const Node *current = root.load();
+        if (findNode(current, value) != nullptr) {
+            return false;
+        }
+        Update update;
+        try {
+            publish(update, insertPath(update, current, value));
+        } catch (...) {
+            if (root.load() == current) {
+                for (std::size_t i = 0; i < update.created.size(); ++i) {
+                    delete update.created[i];
+                }
+            }
+            throw;
+        }
+        count.fetch_add(1);
+        return true;
+    }
+
+    /**
+     * @brief Rimuove un valore, se presente.
+     *
+     * Può essere chiamata da più thread; non blocca i lettori.
+     *
+     * @param value Il valore da rimuovere.
+     * @return true se il valore è stato rimosso, false se non era presente.
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    bool remove(const T &value) {
+        std::lock_guard<std::mutex> lock(writer);
+        const Node *current = root.load();
+        if (findNode(current, value) == nullptr) {
+            return false;
+        }
+        Update update;
+        try {
+            publish(update, removePath(update, current, value));
+        } catch (...) {
+            if (root.load() == current) {
+                for (std::size_t i = 0; i < update.created.size(); ++i) {
+                    delete update.created[i];
+                }
+            }
+            throw;
+        }
+        count.fetch_sub(1);
+        return true;
+    }
+
+    /**
+     * @brief Verifica se un valore è presente nell'albero, senza lock.
+     *
+     * @param value Il valore da cercare.
+     * @return true se il valore è presente, false altrimenti.
+     */
+    bool contains(const T &value) const {
+        Guard guard(this);
+        const Node *node = findNode(root.load(), value);
+        return node != nullptr && equals(node->value, value);
+    }
+
+    /**
+     * @brief Restituisce il numero di valori.
+     *
+     * Con scrittori attivi il valore può riferirsi a una versione appena
+     * precedente o successiva a quella vista da una lettura concorrente.
+     *
+     * @return Il numero di valori presenti nell'albero.
+     */
+    int size() const {
+        return count.load();
+    }
+
+    /**
+     * @brief Cancella tutti i valori dell'albero.
+     *
+     * Non blocca i lettori, che continuano a vedere la versione precedente.
+     *
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    void clear() {
+        std::lock_guard<std::mutex> lock(writer);
+        Update update;
+        collect(root.load(), update.retired);
+        publish(update, nullptr);
+        count.store(0);
+    }
+
+    /**
+     * @brief Restituisce un iteratore costante all'inizio della versione corrente.
+     *
+     * @return Un iteratore costante al primo elemento dell'albero.
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    const_iterator begin() const {
+        return const_iterator(this);
+    }
+
+    /**
+     * @brief Restituisce un iteratore costante alla fine.
+     *
+     * @return Un iteratore costante alla posizione successiva all'ultimo elemento.
+     */
+    const_iterator end() const {
+        return const_iterator();
+    }
+
+    /**
+     * @brief Funzione amica per la stampa della versione corrente dell'albero.
+     *
+     * @param os Stream di output.
+     * @param tree Albero da stampare.
+     * @return Lo stream di output.
+     */
+    friend std::ostream &operator<<(std::ostream &os, const ConcurrentBinarySearchTree &tree) {
+        for (const_iterator it = tree.begin(); it != tree.end(); ++it) {
+            os << *it << " ";
+        }
+        return os;
+    }
+};
+
+#endif // CONCURRENTBINARYSEARCHTREE_HPP
@@ -0,0 +1,456 @@
+/**
+  @file FrozenBinarySearchTree.hpp
+
+  @brief File di dichiarazioni/definizioni della classe FrozenBinarySearchTree templata
+*/
+
+#ifndef FROZENBINARYSEARCHTREE_HPP
+#define FROZENBINARYSEARCHTREE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+  @brief Intestazione dei file scritti da FrozenBinarySearchTree::save()
+
+  Il file contiene l'intestazione seguita dai valori in ordine di Eytzinger,
+  copiati byte per byte. I valori iniziano a dataOffset byte dall'inizio del
+  file, multiplo di 64, per cui sono allineati quando il file viene mappato.
+  Il formato non contiene puntatori e non dipende dall'indirizzo di mappatura.
+*/
+struct frozen_file_header {
+    char magic[8];            ///< "BSTFROZN"
+    std::uint32_t version;    ///< Versione del formato
+    std::uint32_t byteOrder;  ///< 0x01020304 scritto nell'ordine dei byte di chi ha salvato il file
+    std::uint32_t valueSize;  ///< sizeof del tipo dei valori
+    std::uint32_t valueAlign; ///< alignof del tipo dei valori
+    std::uint64_t count;      ///< Numero di valori
+    std::uint64_t dataOffset; ///< Posizione del primo valore
+
+    static const std::uint32_t currentVersion = 1;       ///< Versione scritta da save()
+    static const std::uint32_t byteOrderMark = 0x01020304; ///< Valore di riferimento di byteOrder
+    static const std::uint64_t headerSize = 64;           ///< Spazio riservato all'intestazione
+};
+
+/**
+  @brief classe FrozenBinarySearchTree
+
+  Fotografia immutabile di un albero binario di ricerca, memorizzata in un
+  array contiguo in ordine di Eytzinger (l'ordine di una visita per livelli di
+  un albero completo): i figli dell'elemento di indice k (a partire da 1) sono
+  agli indici 2k e 2k+1, per cui non servono puntatori e i primi livelli
+  condividono poche linee di cache.
+  La discesa esegue un solo confronto per livello, senza salti condizionati
+  sul risultato, e anticipa il caricamento (prefetch) dei discendenti
+  alcuni livelli più in basso.
+
+  I valori sono condivisi tra le copie della fotografia, che non possono
+  modificarli. save() scrive l'array su file e open_mmap() lo rilegge
+  mappandolo in memoria, senza copiare né convertire i valori: l'apertura
+  costa O(1) indipendentemente dal numero di valori e le pagine vengono
+  caricate dal sistema operativo alla prima lettura. open_mmap() è definita
+  in FrozenFileMapping.hpp, per cui questo file non include le intestazioni
+  del sistema operativo.
+
+  L'equivalenza tra valori è derivata dal funtore Compare.
+*/
+template <typename T, typename Compare>
+class FrozenBinarySearchTree {
+
+private:
+    std::shared_ptr<const T> keys; ///< Valori in ordine di Eytzinger: l'indice k è memorizzato in keys[k - 1]
+    std::size_t n;                 ///< Numero di valori
+    Compare compare;               ///< Funtore di confronto
+
+    /**
+     * @brief Costruttore privato per una fotografia su valori già disposti.
+     *
+     * @param keys Valori in ordine di Eytzinger, con il proprietario della memoria.
+     * @param n Numero di valori.
+     * @param comp Funtore di confronto.
+     */
+    FrozenBinarySearchTree(const std::shared_ptr<const T> &keys, std::size_t n, const Compare &comp)
+        : keys(keys), n(n), compare(comp) {}
+
+    /**
+     * @brief Numero di discendenti per linea di cache anticipata durante la discesa.
+     *
+     * È la potenza di due più vicina a 64 / sizeof(T), compresa tra 2 e 16.
+     */
+    static std::size_t prefetchBlock() {
+        std::size_t block = 16;
+        while (block > 2 && block * sizeof(T) > 64) {
+            block /= 2;
+        }
+        return block;
+    }
+
+    /**
+     * @brief Restituisce l'indice del successivo in ordine.
+     *
+     * @param k Indice di partenza (da 1).
+     * @param n Numero di elementi.
+     * @return L'indice del successivo, 0 se k è l'ultimo.
+     */
+    static std::size_t next(std::size_t k, std::size_t n) {
+        if (2 * k + 1 <= n) {
+            k = 2 * k + 1;
+            while (2 * k <= n) {
+                k = 2 * k;
+            }
+            return k;
+        }
+        while (k & 1) {
+            k >>= 1;
+        }
+        return k >> 1;
+    }
+
+    /**
+     * @brief Restituisce l'indice del precedente in ordine.
+     *
+     * @param k Indice di partenza (da 1).
+     * @param n Numero di elementi.
+     * @return L'indice del precedente, 0 se k è il primo.
+     */
+    static std::size_t prev(std::size_t k, std::size_t n) {
+        if (2 * k <= n) {
+            k = 2 * k;
+            while (2 * k + 1 <= n) {
+                k = 2 * k + 1;
+            }
+            return k;
+        }
+        while (k > 1 && !(k & 1)) {
+            k >>= 1;
+        }
+        return k >> 1;
+    }
+
+    /**
+     * @brief Restituisce l'indice del primo elemento in ordine.
+     *
+     * @param n Numero di elementi.
+     * @return L'indice del minimo, 0 se non ci sono elementi.
+     */
+    static std::size_t first(std::size_t n) {
+        std::size_t k = n > 0 ? 1 : 0;
+        while (k != 0 && 2 * k <= n) {
+            k = 2 * k;
+        }
+        return k;
+    }
+
+    /**
+     * @brief Restituisce l'indice del primo valore non minore di value.
+     *
+     * @param value Valore da cercare.
+     * @return L'indice (da 1) del primo valore non minore di value, 0 se non esiste.
+     */
+    std::size_t lowerBoundIndex(const T &value) const {
+        const std::size_t block = prefetchBlock();
+        const T *base = keys.get();
+        std::size_t k = 1;
+        while (k <= n) {
+#if defined(__GNUC__)
+            if (block * k <= n) {
+                __builtin_prefetch(base + block * k - 1);
+            }
+#endif
+            k = 2 * k + (compare(base[k - 1], value) ? 1 : 0);
+        }
+        // risale oltre gli ultimi passi a destra e il primo passo a sinistra
+        while (k & 1) {
+            k >>= 1;
+        }
+        return k >> 1;
+    }
+
+public:
+    /**
+     * @brief Iteratore costante in ordine crescente.
+     */
+    class const_iterator {
+    public:
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const T *pointer;
+        typedef const T &reference;
+
+        /**
+         * @brief Costruttore di default.
+         */
+        const_iterator() : k(0), tree(nullptr) {}
+
+        /**
+         * @brief Dereferenzia l'iteratore.
+         *
+         * @return Il riferimento al valore puntato dall'iteratore.
+         */
+        reference operator*() const {
+            return tree->keys.get()[k - 1];
+        }
+
+        /**
+         * @brief Accede al membro puntato dall'iteratore.
+         *
+         * @return Un puntatore al valore puntato dall'iteratore.
+         */
+        pointer operator->() const {
+            return tree->keys.get() + (k - 1);
+        }
+
+        /**
+         * @brief Operatore di pre-incremento.
+         *
+         * @return Un riferimento all'iteratore avanzato.
+         */
+        const_iterator &operator++() {
+            if (k != 0) {
+                k = next(k, tree->n);
+            }
+            return *this;
+        }
+
+        /**
+         * @brief Operatore di post-incremento.
+         *
+         * @return L'iteratore alla posizione precedente.
+         */
+        const_iterator operator++(int) {
+            const_iterator tmp(*this);
+            ++(*this);
+            return tmp;
+        }
+
+        /**
+         * @brief Operatore di pre-decremento.
+         *
+         * Decrementare end() porta all'ultimo elemento.
+         *
+         * @return Un riferimento all'iteratore spostato.
+         */
+        const_iterator &operator--() {
+            std::size_t n = tree->n;
+            if (k != 0) {
+                k = prev(k, n);
+            } else if (n > 0) {
+                k = 1;
+                while (2 * k + 1 <= n) {
+                    k = 2 * k + 1;
+                }
+            }
+            return *this;
+        }
+
+        /**
+         * @brief Operatore di post-decremento.
+         *
+         * @return L'iteratore alla posizione corrente prima dello spostamento.
+         */
+        const_iterator operator--(int) {
+            const_iterator tmp(*this);
+            --(*this);
+            return tmp;
+        }
+
+        /**
+         * @brief Operatore di uguaglianza.
+         *
+         * @param other L'iteratore da confrontare.
+         * @return true se gli iteratori sono uguali, false altrimenti.
+         */
+        bool operator==(const const_iterator &other) const {
+            return k == other.k;
+        }
+
+        /**
+         * @brief Operatore di disuguaglianza.
+         *
+         * @param other L'iteratore da confrontare.
+         * @return true se gli iteratori sono diversi, false altrimenti.
+         */
+        bool operator!=(const const_iterator &other) const {
+            return k != other.k;
+        }
+
+    private:
+        std::size_t k;                      ///< Indice (da 1) dell'elemento, 0 per la fine
+        const FrozenBinarySearchTree *tree; ///< Fotografia a cui appartiene l'iteratore
+
+        /**
+         * @brief Costruttore privato per inizializzare un iteratore a un indice specifico.
+         *
+         * @param k Indice dell'elemento (0 per la fine).
+         * @param tree La fotografia a cui appartiene l'elemento.
+         */
+        const_iterator(std::size_t k, const FrozenBinarySearchTree *tree) : k(k), tree(tree) {}
+
+        friend class FrozenBinarySearchTree;
+    };
+
+    /**
+     * @brief Costruttore di default
+     *
+     * Inizializza una fotografia vuota.
+     */
+    FrozenBinarySearchTree() : n(0) {}
+
+    /**
+     * @brief Costruttore tramite sequenza ordinata.
+     *
+     * Dispone i valori in ordine di Eytzinger in O(n).
+     *
+     * @tparam Iter tipo dell'iteratore
+     * @param begin iteratore di inizio sequenza
+     * @param end iteratore di fine sequenza
+     * @param comp funtore di confronto
+     *
+     * @pre [begin, end) è strettamente crescente secondo Compare
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    template <typename Iter>
+    FrozenBinarySearchTree(Iter begin, Iter end, const Compare &comp = Compare()) : compare(comp) {
+        std::vector<T> sorted(begin, end);
+        n = sorted.size();
+        std::vector<std::size_t> rank(n + 1);
+        std::size_t i = 0;
+        for (std::size_t k = first(n); k != 0; k = next(k, n)) {
+            rank[k] = i++;
+        }
+        std::shared_ptr<std::vector<T> > values = std::make_shared<std::vector<T> >();
+        values->reserve(n);
+        for (std::size_t k = 1; k <= n; ++k) {
+            values->push_back(std::move(sorted[rank[k]]));
+        }
+        keys = std::shared_ptr<const T>(values, values->data());
+    }
+
+    /**
+     * @brief Apre in sola lettura una fotografia salvata con save().
+     *
+     * Il file viene mappato in memoria e usato direttamente come array dei
+     * valori: non c'è deserializzazione e il costo non dipende dal numero di
+     * valori. La mappatura resta attiva finché esiste una copia della fotografia.
+     *
+     * @param path Percorso del file.
+     * @param comp Funtore di confronto, equivalente a quello usato per salvare.
+     * @return La fotografia letta dal file.
+     * @throw std::runtime_error se il file non esiste, non è leggibile o non è
+     *        una fotografia di valori dello stesso tipo
+     *
+     * @note Definita in FrozenFileMapping.hpp, da includere nelle unità di
+     *       traduzione che la chiamano: solo quel file dipende dalle API del
+     *       sistema operativo.
+     */
+    static FrozenBinarySearchTree open_mmap(const std::string &path, const Compare &comp = Compare());
+
+    /**
+     * @brief Salva la fotografia su file.
+     *
+     * Scrive un'intestazione e i valori così come sono in memoria, in ordine
+     * di Eytzinger; il file può essere riaperto con open_mmap() da un processo
+     * sulla stessa architettura. Il costo è O(n) in scrittura sequenziale.
+     *
+     * @param path Percorso del file, sovrascritto se esiste.
+     * @throw std::runtime_error se il file non può essere scritto
+     */
+    void save(const std::string &path) const {
+        static_assert(std::is_trivially_copyable<T>::value, "save() richiede un tipo T banalmente copiabile");
+        frozen_file_header header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, "BSTFROZN", sizeof(header.magic));
+        header.version = frozen_file_header::currentVersion;
+        header.byteOrder = frozen_file_header::byteOrderMark;
+        header.valueSize = sizeof(T);
+        header.valueAlign = alignof(T);
+        header.count = n;
+        header.dataOffset = (frozen_file_header::headerSize + alignof(T) - 1) / alignof(T) * alignof(T);
+
+        std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+        std::vector<char> padding(static_cast<std::size_t>(header.dataOffset), 0);
+        std::memcpy(padding.data(), &header, sizeof(header));
+        out.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+        if (n > 0) {
+            out.write(reinterpret_cast<const char *>(keys.get()), static_cast<std::streamsize>(n * sizeof(T)));
+        }
+        out.close();
+        if (!out) {
+            throw std::runtime_error("save: impossibile scrivere " + path);
+        }
+    }
+
+    /**
+     * @brief Verifica se un valore è presente.
+     *
+     * @param value Il valore da cercare.
+     * @return true se il valore è presente, false altrimenti.
+     */
+    bool contains(const T &value) const {
+        std::size_t k = lowerBoundIndex(value);
+        return k != 0 && !compare(value, keys.get()[k - 1]);
+    }
+
+    /**
+     * @brief Restituisce un iteratore al primo valore non minore di quello specificato.
+     *
+     * @param value Il valore di riferimento.
+     * @return Un iteratore al primo valore v tale che !(v < value), end() se non esiste.
+     */
+    const_iterator lower_bound(const T &value) const {
+        return const_iterator(lowerBoundIndex(value), this);
+    }
+
+    /**
+     * @brief Restituisce un iteratore al primo valore maggiore di quello specificato.
+     *
+     * @param value Il valore di riferimento.
+     * @return Un iteratore al primo valore v tale che value < v, end() se non esiste.
+     */
+    const_iterator upper_bound(const T &value) const {
+        std::size_t k = lowerBoundIndex(value);
+        if (k != 0 && !compare(value, keys.get()[k - 1])) {
+            k = next(k, n);
+        }
+        return const_iterator(k, this);
+    }
+
+    /**
+     * @brief Restituisce il numero di valori.
+     *
+     * @return Il numero di valori della fotografia.
+     */
+    int size() const {
+        return static_cast<int>(n);
+    }
+
+    /**
+     * @brief Restituisce un iteratore costante al primo valore.
+     *
+     * @return Un iteratore costante al minimo.
+     */
+    const_iterator begin() const {
+        return const_iterator(first(n), this);
+    }
+
+    /**
+     * @brief Restituisce un iteratore costante alla fine.
+     *
+     * @return Un iteratore costante alla posizione successiva all'ultimo valore.
+     */
+    const_iterator end() const {
+        return const_iterator(0, this);
+    }
+};
+
+#endif // FROZENBINARYSEARCHTREE_HPP
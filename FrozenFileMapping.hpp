@@ -0,0 +1,175 @@
+/**
+  @file FrozenFileMapping.hpp
+
+  @brief File di dichiarazioni/definizioni della classe FrozenFileMapping e di FrozenBinarySearchTree::open_mmap()
+
+  È l'unico file che include le intestazioni del sistema operativo: va
+  incluso solo dalle unità di traduzione che chiamano open_mmap().
+*/
+
+#ifndef FROZENFILEMAPPING_HPP
+#define FROZENFILEMAPPING_HPP
+
+#include "FrozenBinarySearchTree.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+  @brief Mappatura in memoria, in sola lettura, di un file
+
+  Il file resta mappato finché l'oggetto esiste. Su sistemi POSIX usa
+  mmap, su Windows CreateFileMapping e MapViewOfFile.
+*/
+class FrozenFileMapping {
+
+private:
+    const char *address; ///< Inizio della mappatura (nullptr per un file vuoto)
+    std::size_t length;  ///< Dimensione del file
+#if defined(_WIN32)
+    HANDLE file;    ///< File aperto
+    HANDLE mapping; ///< Oggetto di mappatura
+#endif
+
+public:
+    FrozenFileMapping(const FrozenFileMapping &) = delete;
+    FrozenFileMapping &operator=(const FrozenFileMapping &) = delete;
+
+    /**
+     * @brief Costruttore: mappa l'intero file in sola lettura.
+     *
+     * @param path Percorso del file.
+     * @throw std::runtime_error se il file non può essere aperto o mappato
+     */
+    explicit FrozenFileMapping(const std::string &path) : address(nullptr), length(0) {
+#if defined(_WIN32)
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error("open_mmap: impossibile aprire " + path);
+        }
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size)) {
+            CloseHandle(file);
+            throw std::runtime_error("open_mmap: impossibile leggere la dimensione di " + path);
+        }
+        length = static_cast<std::size_t>(size.QuadPart);
+        mapping = nullptr;
+        if (length > 0) {
+            mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            address = mapping != nullptr ? static_cast<const char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+            if (address == nullptr) {
+                if (mapping != nullptr) {
+                    CloseHandle(mapping);
+                }
+                CloseHandle(file);
+                throw std::runtime_error("open_mmap: impossibile mappare " + path);
+            }
+        }
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("open_mmap: impossibile aprire " + path);
+        }
+        struct stat info;
+        if (::fstat(fd, &info) != 0) {
+            ::close(fd);
+            throw std::runtime_error("open_mmap: impossibile leggere la dimensione di " + path);
+        }
+        length = static_cast<std::size_t>(info.st_size);
+        if (length > 0) {
+            void *p = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("open_mmap: impossibile mappare " + path);
+            }
+            address = static_cast<const char *>(p);
+        }
+        // la mappatura resta valida anche dopo la chiusura del descrittore
+        ::close(fd);
+#endif
+    }
+
+    /**
+     * @brief Distruttore: rimuove la mappatura.
+     */
+    ~FrozenFileMapping() {
+#if defined(_WIN32)
+        if (address != nullptr) {
+            UnmapViewOfFile(address);
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+#else
+        if (address != nullptr) {
+            ::munmap(const_cast<char *>(address), length);
+        }
+#endif
+    }
+
+    /**
+     * @brief Restituisce l'inizio della mappatura.
+     */
+    const char *data() const {
+        return address;
+    }
+
+    /**
+     * @brief Restituisce la dimensione del file.
+     */
+    std::size_t size() const {
+        return length;
+    }
+};
+
+/**
+ * @brief Apre in sola lettura una fotografia salvata con save().
+ *
+ * Vedi la dichiarazione in FrozenBinarySearchTree.
+ */
+template <typename T, typename Compare>
+FrozenBinarySearchTree<T, Compare> FrozenBinarySearchTree<T, Compare>::open_mmap(const std::string &path, const Compare &comp) {
+    static_assert(std::is_trivially_copyable<T>::value, "open_mmap() richiede un tipo T banalmente copiabile");
+    std::shared_ptr<FrozenFileMapping> file = std::make_shared<FrozenFileMapping>(path);
+    frozen_file_header header;
+    if (file->size() < frozen_file_header::headerSize) {
+        throw std::runtime_error("open_mmap: " + path + " non è una fotografia (file troppo corto)");
+    }
+    std::memcpy(&header, file->data(), sizeof(header));
+    if (std::memcmp(header.magic, "BSTFROZN", sizeof(header.magic)) != 0) {
+        throw std::runtime_error("open_mmap: " + path + " non è una fotografia");
+    }
+    if (header.version != frozen_file_header::currentVersion) {
+        throw std::runtime_error("open_mmap: versione del formato non supportata in " + path);
+    }
+    if (header.byteOrder != frozen_file_header::byteOrderMark) {
+        throw std::runtime_error("open_mmap: " + path + " è stato scritto con un ordine dei byte diverso");
+    }
+    if (header.valueSize != sizeof(T) || header.valueAlign != alignof(T)) {
+        throw std::runtime_error("open_mmap: il tipo dei valori in " + path + " non corrisponde");
+    }
+    if (header.dataOffset % alignof(T) != 0 || header.dataOffset > file->size() ||
+        header.count != (file->size() - header.dataOffset) / sizeof(T) ||
+        (file->size() - header.dataOffset) % sizeof(T) != 0) {
+        throw std::runtime_error("open_mmap: " + path + " è troncato o danneggiato");
+    }
+    const T *values = reinterpret_cast<const T *>(file->data() + header.dataOffset);
+    return FrozenBinarySearchTree(std::shared_ptr<const T>(file, values), static_cast<std::size_t>(header.count), comp);
+}
+
+#endif // FROZENFILEMAPPING_HPP
@@ -0,0 +1,693 @@
+/**
+  @file PersistentBinarySearchTree.hpp
+
+  @brief File di dichiarazioni/definizioni della classe PersistentBinarySearchTree templata
+*/
+
+#ifndef PERSISTENTBINARYSEARCHTREE_HPP
+#define PERSISTENTBINARYSEARCHTREE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+/**
+  @brief classe PersistentBinarySearchTree
+
+  Albero AVL persistente: i nodi sono immutabili e condivisi tra tutte le
+  copie dell'albero tramite un conteggio dei riferimenti.
+  Inserimento e rimozione copiano solo il cammino dalla radice al punto
+  modificato (O(log n) nodi) lasciando intatte le altre versioni, per cui la
+  copia, l'assegnamento e snapshot() costano O(1) e subtree(value) costa
+  O(log n), condividendo la struttura con l'albero di partenza.
+
+  Il conteggio dei riferimenti è atomico: alberi diversi che condividono nodi
+  possono essere usati e distrutti da thread diversi. Un singolo oggetto
+  PersistentBinarySearchTree non è invece protetto da accessi concorrenti in
+  scrittura.
+
+  L'equivalenza usata da insert e remove è derivata da Compare; Equal è usato
+  per la verifica finale di contains, come in BinarySearchTree.
+*/
+template <typename T, typename Compare, typename Equal>
+class PersistentBinarySearchTree {
+
+private:
+    /**
+      @brief Nodo immutabile condiviso
+    */
+    struct Node {
+        const T value;                 ///< Valore del nodo
+        const Node *const left;        ///< Figlio sinistro (un riferimento posseduto)
+        const Node *const right;       ///< Figlio destro (un riferimento posseduto)
+        const int height;              ///< Altezza del sottoalbero (una foglia ha altezza 1)
+        const int size;                ///< Numero di nodi del sottoalbero
+        mutable std::atomic<int> refs; ///< Numero di riferimenti al nodo
+
+        /**
+         * @brief Costruttore: acquisisce un riferimento ai figli.
+         *
+         * @param v Valore del nodo.
+         * @param l Figlio sinistro.
+         * @param r Figlio destro.
+         */
+        Node(const T &v, const Node *l, const Node *r)
+            : value(v), left(acquire(l)), right(acquire(r)), height(1 + std::max(heightOf(l), heightOf(r))),
+              size(1 + sizeOf(l) + sizeOf(r)), refs(1) {}
+    };
+
+    /**
+      @brief Riferimento posseduto a un nodo, rilasciato alla distruzione
+    */
+    class NodeRef {
+    public:
+        /**
+         * @brief Costruttore: assume un riferimento già acquisito.
+         *
+         * @param node Nodo (può essere nullptr).
+         */
+        explicit NodeRef(const Node *node = nullptr) : node(node) {}
+
+        /**
+         * @brief Move constructor
+         *
+         * @param other Riferimento da spostare.
+         */
+        NodeRef(NodeRef &&other) : node(other.node) {
+            other.node = nullptr;
+        }
+
+        /**
+         * @brief Distruttore: rilascia il riferimento.
+         */
+        ~NodeRef() {
+            release(node);
+        }
+
+        /**
+         * @brief Restituisce il nodo senza cederne la proprietà.
+         */
+        const Node *get() const {
+            return node;
+        }
+
+        /**
+         * @brief Cede la proprietà del riferimento al chiamante.
+         */
+        const Node *take() {
+            const Node *result = node;
+            node = nullptr;
+            return result;
+        }
+
+    private:
+        const Node *node; ///< Nodo riferito
+
+        NodeRef(const NodeRef &);
+        NodeRef &operator=(const NodeRef &);
+    };
+
+    const Node *root; ///< Radice (un riferimento posseduto)
+    Compare compare;  ///< Funtore di confronto
+    Equal equals;     ///< Funtore di uguaglianza
+
+    /**
+     * @brief Restituisce l'altezza di un sottoalbero.
+     */
+    static int heightOf(const Node *node) {
+        return node == nullptr ? 0 : node->height;
+    }
+
+    /**
+     * @brief Restituisce il numero di nodi di un sottoalbero.
+     */
+    static int sizeOf(const Node *node) {
+        return node == nullptr ? 0 : node->size;
+    }
+
+    /**
+     * @brief Acquisisce un riferimento a un nodo.
+     *
+     * @return Il nodo stesso.
+     */
+    static const Node *acquire(const Node *node) {
+        if (node != nullptr) {
+            node->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+        return node;
+    }
+
+    /**
+     * @brief Rilascia un riferimento a un nodo, liberando i nodi non più riferiti.
+     *
+     * Iterativa: il rilascio di un albero profondo non consuma stack.
+     */
+    static void release(const Node *node) {
+        std::vector<const Node *> pending;
+        while (node != nullptr) {
+            if (node->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                if (node->left != nullptr) {
+                    pending.push_back(node->left);
+                }
+                if (node->right != nullptr) {
+                    pending.push_back(node->right);
+                }
+                delete node;
+            }
+            if (pending.empty()) {
+                break;
+            }
+            node = pending.back();
+            pending.pop_back();
+        }
+    }
+
+    /**
+     * @brief Crea un nodo che riferisce i figli dati.
+     *
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    static NodeRef make(const T &value, const Node *left, const Node *right) {
+        return NodeRef(new Node(value, left, right));
+    }
+
+    /**
+     * @brief Crea un nodo con i figli dati, ruotando se i figli sono sbilanciati.
+     *
+     * I figli differiscono in altezza al più di 2; i nodi ruotati vengono
+     * ricreati, quelli originali restano validi per le altre versioni.
+     *
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    static NodeRef balance(const T &value, const Node *left, const Node *right) {
+        int hl = heightOf(left);
+        int hr = heightOf(right);
+        if (hl > hr + 1) {
+            if (heightOf(left->left) >= heightOf(left->right)) {
+                return make(left->value, left->left, make(value, left->right, right).get());
+            }
+            const Node *lr = left->right;
+            return make(lr->value, make(left->value, left->left, lr->left).get(),
+                        make(value, lr->right, right).get());
+        }
+        if (hr > hl + 1) {
+            if (heightOf(right->right) >= heightOf(right->left)) {
+                return make(right->value, make(value, left, right->left).get(), right->right);
+            }
+            const Node *rl = right->left;
+            return make(rl->value, make(value, left, rl->left).get(),
+                        make(right->value, rl->right, right->right).get());
+        }
+        return make(value, left, right);
+    }
+
+    /**
+     * @brief Inserisce un valore assente copiando il cammino (profondità O(log n)).
+     *
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    NodeRef insertPath(const Node *node, const T &value) const {
+        if (node == nullptr) {
+            return make(value, nullptr, nullptr);
+        }
+        if (compare(value, node->value)) {
+            return balance(node->value, insertPath(node->left, value).get(), node->right);
+        }
+        return balance(node->value, node->left, insertPath(node->right, value).get());
+    }
+
+    /**
+     * @brief Rimuove il minimo di un sottoalbero non vuoto copiando il cammino.
+     *
+     * @param minimum Impostato al nodo del minimo.
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    static NodeRef removeMinPath(const Node *node, const Node *&minimum) {
+        if (node->left == nullptr) {
+            minimum = node;
+            return NodeRef(acquire(node->right));
+        }
+        return balance(node->value, removeMinPath(node->left, minimum).get(), node->right);
+    }
+
+    /**
+     * @brief Rimuove un valore presente copiando il cammino (profondità O(log n)).
+     *
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    NodeRef removePath(const Node *node, const T &value) const {
+        if (compare(value, node->value)) {
+            return balance(node->value, removePath(node->left, value).get(), node->right);
+        }
+        if (compare(node->value, value)) {
+            return balance(node->value, node->left, removePath(node->right, value).get());
+        }
+        if (node->left == nullptr) {
+            return NodeRef(acquire(node->right));
+        }
+        if (node->right == nullptr) {
+            return NodeRef(acquire(node->left));
+        }
+        const Node *minimum = nullptr;
+        NodeRef right = removeMinPath(node->right, minimum);
+        return balance(minimum->value, node->left, right.get());
+    }
+
+    /**
+     * @brief Cerca il nodo con valore equivalente secondo Compare.
+     *
+     * @return Il nodo trovato, nullptr se assente.
+     */
+    const Node *findNode(const T &value) const {
+        const Node *node = root;
+        while (node != nullptr) {
+            if (compare(value, node->value)) {
+                node = node->left;
+            } else if (compare(node->value, value)) {
+                node = node->right;
+            } else {
+                return node;
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief Sostituisce la radice con un nuovo riferimento posseduto.
+     */
+    void replaceRoot(NodeRef &newRoot) {
+        const Node *old = root;
+        root = newRoot.take();
+        release(old);
+    }
+
+    /**
+     * @brief Costruttore privato: albero che condivide il sottoalbero dato.
+     *
+     * @param node Radice condivisa (ne viene acquisito un riferimento).
+     * @param comp Funtore di confronto.
+     * @param eq Funtore di uguaglianza.
+     */
+    PersistentBinarySearchTree(const Node *node, const Compare &comp, const Equal &eq)
+        : root(acquire(node)), compare(comp), equals(eq) {}
+
+public:
+    /**
+     * @brief Iteratore costante bidirezionale.
+     *
+     * Memorizza il cammino dalla radice al nodo corrente e non possiede
+     * riferimenti ai nodi: resta valido finché la versione da cui è stato
+     * ottenuto è riferita da qualche albero (ad esempio una snapshot()), anche
+     * se l'albero di partenza viene modificato.
+     */
+    class const_iterator {
+    public:
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const T *pointer;
+        typedef const T &reference;
+
+        /**
+         * @brief Costruttore di default.
+         */
+        const_iterator() : root(nullptr) {}
+
+        /**
+         * @brief Dereferenzia l'iteratore.
+         *
+         * @return Il riferimento al valore puntato dall'iteratore.
+         */
+        reference operator*() const {
+            return path.back()->value;
+        }
+
+        /**
+         * @brief Accede al membro puntato dall'iteratore.
+         *
+         * @return Un puntatore al valore puntato dall'iteratore.
+         */
+        pointer operator->() const {
+            return &path.back()->value;
+        }
+
+        /**
+         * @brief Operatore di pre-incremento.
+         *
+         * @return Un riferimento all'iteratore avanzato.
+         */
+        const_iterator &operator++() {
+            const Node *node = path.back();
+            if (node->right != nullptr) {
+                for (node = node->right; node != nullptr; node = node->left) {
+                    path.push_back(node);
+                }
+                return *this;
+            }
+            path.pop_back();
+            while (!path.empty() && path.back()->right == node) {
+                node = path.back();
+                path.pop_back();
+            }
+            return *this;
+        }
+
+        /**
+         * @brief Operatore di post-incremento.
+         *
+         * @return L'iteratore alla posizione precedente.
+         */
+        const_iterator operator++(int) {
+            const_iterator tmp(*this);
+            ++(*this);
+            return tmp;
+        }
+
+        /**
+         * @brief Operatore di pre-decremento.
+         *
+         * Decrementare end() porta all'ultimo elemento.
+         *
+         * @return Un riferimento all'iteratore spostato.
+         */
+        const_iterator &operator--() {
+            if (path.empty()) {
+                for (const Node *node = root; node != nullptr; node = node->right) {
+                    path.push_back(node);
+                }
+                return *this;
+            }
+            const Node *node = path.back();
+            if (node->left != nullptr) {
+                for (node = node->left; node != nullptr; node = node->right) {
+                    path.push_back(node);
+                }
+                return *this;
+            }
+            path.pop_back();
+            while (!path.empty() && path.back()->left == node) {
+                node = path.back();
+                path.pop_back();
+            }
+            return *this;
+        }
+
+        /**
+         * @brief Operatore di post-decremento.
+         *
+         * @return L'iteratore alla posizione corrente prima dello spostamento.
+         */
+        const_iterator operator--(int) {
+            const_iterator tmp(*this);
+            --(*this);
+            return tmp;
+        }
+
+        /**
+         * @brief Operatore di uguaglianza.
+         *
+         * @param other L'iteratore da confrontare.
+         * @return true se gli iteratori puntano allo stesso nodo (o sono entrambi alla fine).
+         */
+        bool operator==(const const_iterator &other) const {
+            const Node *a = path.empty() ? nullptr : path.back();
+            const Node *b = other.path.empty() ? nullptr : other.path.back();
+            return a == b;
+        }
+
+        /**
+         * @brief Operatore di disuguaglianza.
+         *
+         * @param other L'iteratore da confrontare.
+         * @return true se gli iteratori sono diversi, false altrimenti.
+         */
+        bool operator!=(const const_iterator &other) const {
+            return !(*this == other);
+        }
+
+    private:
+        const Node *root;               ///< Radice della versione visitata
+        std::vector<const Node *> path; ///< Cammino dalla radice al nodo corrente, vuoto per la fine
+
+        /**
+         * @brief Costruttore privato per un iteratore alla fine della versione data.
+         *
+         * @param root Radice della versione.
+         */
+        explicit const_iterator(const Node *root) : root(root) {}
+
+        friend class PersistentBinarySearchTree;
+    };
+
+    /**
+      @brief Costruttore di default
+
+      Inizializza un albero vuoto.
+     */
+    PersistentBinarySearchTree() : root(nullptr) {}
+
+    /**
+     * @brief Costruttore tramite iteratori.
+     *
+     * @tparam Iter tipo dell'iteratore
+     * @param begin iteratore di inizio sequenza
+     * @param end iteratore di fine sequenza
+     *
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    template <typename Iter>
+    PersistentBinarySearchTree(Iter begin, Iter end) : root(nullptr) {
+        try {
+            for (Iter it = begin; it != end; ++it) {
+                insert(*it);
+            }
+        } catch (...) {
+            clear();
+            throw;
+        }
+    }
+
+    /**
+     * @brief Copy constructor in O(1): condivide tutti i nodi.
+     *
+     * @param other Albero da copiare
+     */
+    PersistentBinarySearchTree(const PersistentBinarySearchTree &other)
+        : root(acquire(other.root)), compare(other.compare), equals(other.equals) {}
+
+    /**
+     * @brief Move constructor
+     *
+     * @param other Albero da spostare
+     *
+     * @post other è vuoto
+     */
+    PersistentBinarySearchTree(PersistentBinarySearchTree &&other)
+        : root(other.root), compare(other.compare), equals(other.equals) {
+        other.root = nullptr;
+    }
+
+    /**
+     * @brief Distruttore: rilascia i nodi non condivisi con altre versioni.
+     */
+    ~PersistentBinarySearchTree() {
+        release(root);
+    }
+
+    /**
+     * @brief Operatore di assegnamento in O(1)
+     *
+     * @param other Albero da copiare (o spostare)
+     * @return reference all'albero this
+     */
+    PersistentBinarySearchTree &operator=(PersistentBinarySearchTree other) {
+        swap(other);
+        return *this;
+    }
+
+    /**
+     * @brief Scambia il contenuto di due alberi in O(1).
+     *
+     * @param other Albero con cui scambiare il contenuto.
+     */
+    void swap(PersistentBinarySearchTree &other) {
+        std::swap(root, other.root);
+        std::swap(compare, other.compare);
+        std::swap(equals, other.equals);
+    }
+
+    /**
+     * @brief Restituisce una versione immutabile dell'albero in O(1).
+     *
+     * Le modifiche successive a this non sono visibili nella fotografia e
+     * viceversa.
+     *
+     * @return Un albero che condivide tutti i nodi con this.
+     */
+    PersistentBinarySearchTree snapshot() const {
+        return *this;
+    }
+
+    /**
+     * @brief Inserisce un valore, se non è già presente.
+     *
+     * Le copie e i sottoalberi già estratti non vengono modificati.
+     *
+     * @param value Il valore da inserire.
+     * @return Una coppia con l'iteratore al valore equivalente nell'albero e
+     *         true se il valore è stato inserito, false se era già presente.
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    std::pair<const_iterator, bool> insert(const T &value) {
+        bool inserted = findNode(value) == nullptr;
+        if (inserted) {
+            NodeRef newRoot = insertPath(root, value);
+            replaceRoot(newRoot);
+        }
+        return std::make_pair(find(value), inserted);
+    }
+
+    /**
+     * @brief Rimuove un valore dall'albero, se presente.
+     *
+     * Le copie e i sottoalberi già estratti non vengono modificati.
+     *
+     * @param value Il valore da rimuovere.
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    void remove(const T &value) {
+        if (findNode(value) != nullptr) {
+            NodeRef newRoot = removePath(root, value);
+            replaceRoot(newRoot);
+        }
+    }
+
+    /**
+     * @brief Verifica se un valore è presente nell'albero.
+     *
+     * @param value Il valore da cercare.
+     * @return true se il valore è presente, false altrimenti.
+     */
+    bool contains(const T &value) const {
+        const Node *node = findNode(value);
+        return node != nullptr && equals(node->value, value);
+    }
+
+    /**
+     * @brief Restituisce un iteratore al valore equivalente a quello dato.
+     *
+     * @param value Il valore da cercare.
+     * @return Un iteratore al valore, end() se non è presente.
+     */
+    const_iterator find(const T &value) const {
+        const_iterator it(root);
+        const Node *node = root;
+        while (node != nullptr) {
+            it.path.push_back(node);
+            if (compare(value, node->value)) {
+                node = node->left;
+            } else if (compare(node->value, value)) {
+                node = node->right;
+            } else {
+                return it;
+            }
+        }
+        return end();
+    }
+
+    /**
+     * @brief Restituisce il numero di valori in O(1).
+     *
+     * @return Il numero di valori presenti nell'albero.
+     */
+    int size() const {
+        return sizeOf(root);
+    }
+
+    /**
+     * @brief Cancella tutti i valori dell'albero.
+     *
+     * Le copie e i sottoalberi già estratti non vengono modificati.
+     */
+    void clear() {
+        release(root);
+        root = nullptr;
+    }
+
+    /**
+     * @brief Restituisce il sottoalbero radicato nel valore dato, in O(log n).
+     *
+     * Il sottoalbero condivide i nodi con this.
+     *
+     * @param value Il valore della radice del sottoalbero.
+     * @return Il sottoalbero, vuoto se il valore non è presente.
+     */
+    PersistentBinarySearchTree subtree(const T &value) const {
+        return PersistentBinarySearchTree(findNode(value), compare, equals);
+    }
+
+    /**
+     * @brief Restituisce un iteratore costante all'inizio dell'albero.
+     *
+     * @return Un iteratore costante al primo elemento dell'albero.
+     */
+    const_iterator begin() const {
+        const_iterator it(root);
+        for (const Node *node = root; node != nullptr; node = node->left) {
+            it.path.push_back(node);
+        }
+        return it;
+    }
+
+    /**
+     * @brief Restituisce un iteratore costante alla fine dell'albero.
+     *
+     * @return Un iteratore costante alla posizione successiva all'ultimo elemento.
+     */
+    const_iterator end() const {
+        return const_iterator(root);
+    }
+
+    /**
+     * @brief Iteratore inverso costante.
+     */
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    /**
+     * @brief Restituisce un iteratore inverso costante all'ultimo elemento dell'albero.
+     *
+     * @return Un iteratore inverso costante all'ultimo elemento dell'albero.
+     */
+    const_reverse_iterator rbegin() const {
+        return const_reverse_iterator(end());
+    }
+
+    /**
+     * @brief Restituisce un iteratore inverso costante alla posizione precedente al primo elemento.
+     *
+     * @return Un iteratore inverso costante alla posizione precedente al primo elemento.
+     */
+    const_reverse_iterator rend() const {
+        return const_reverse_iterator(begin());
+    }
+
+    /**
+     * @brief Funzione amica per la stampa dell'albero.
+     *
+     * @param os Stream di output.
+     * @param tree Albero da stampare.
+     * @return Lo stream di output.
+     */
+    friend std::ostream &operator<<(std::ostream &os, const PersistentBinarySearchTree &tree) {
+        for (const_iterator it = tree.begin(); it != tree.end(); ++it) {
+            os << *it << " ";
+        }
+        return os;
+    }
+};
+
+#endif // PERSISTENTBINARYSEARCHTREE_HPP
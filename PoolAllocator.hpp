@@ -0,0 +1,425 @@
+/**
+  @file PoolAllocator.hpp
+
+  @brief File di dichiarazioni/definizioni dell'allocatore a blocchi PoolAllocator
+*/
+
+#ifndef POOLALLOCATOR_HPP
+#define POOLALLOCATOR_HPP
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+/**
+  @brief classe PoolArena
+
+  Arena condivisa da tutte le copie di un PoolAllocator. Ricava oggetti di
+  dimensione fissa (slot) da blocchi contigui allocati in un'unica volta.
+  Gli slot restituiti vengono riutilizzati tramite una free list; i blocchi
+  vengono restituiti al sistema solo da release() o dal distruttore.
+  La dimensione degli slot viene fissata alla prima allocazione.
+
+  L'arena non è thread-safe.
+*/
+class PoolArena {
+
+private:
+    /**
+      @brief Slot libero, collegato nella free list
+    */
+    struct FreeSlot {
+        FreeSlot *next; ///< Prossimo slot libero
+    };
+
+    std::size_t slotSize;      ///< Dimensione in byte di uno slot (0 se non ancora fissata)
+    std::size_t blockSlots;    ///< Numero di slot per blocco
+    std::vector<void *> blocks; ///< Blocchi allocati
+    FreeSlot *freeList;        ///< Slot restituiti e riutilizzabili
+    char *cursor;              ///< Prossimo slot mai usato del blocco corrente
+    std::size_t remaining;     ///< Slot mai usati rimasti nel blocco corrente
+
+    PoolArena(const PoolArena &);
+    PoolArena &operator=(const PoolArena &);
+
+    /**
+     * @brief Alloca un nuovo blocco e lo rende blocco corrente.
+     *
+     * @param slots Numero di slot del blocco.
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    void grow(std::size_t slots) {
+        blocks.reserve(blocks.size() + 1);
+        cursor = static_cast<char *>(::operator new(slots * slotSize));
+        blocks.push_back(cursor);
+        remaining = slots;
+    }
+
+public:
+    /**
+     * @brief Costruttore
+     *
+     * @param slots Numero di slot per blocco.
+     */
+    explicit PoolArena(std::size_t slots)
+        : slotSize(0), blockSlots(slots > 0 ? slots : 1), freeList(nullptr), cursor(nullptr), remaining(0) {}
+
+    /**
+     * @brief Distruttore
+     *
+     * Restituisce al sistema tutti i blocchi.
+     */
+    ~PoolArena() {
+        release();
+    }
+
+    /**
+     * @brief Calcola la dimensione dello slot per un tipo.
+     *
+     * @param size sizeof del tipo.
+     * @param align alignof del tipo.
+     * @return La dimensione dello slot, multipla dell'allineamento e almeno pari a un puntatore.
+     */
+    static std::size_t slotFor(std::size_t size, std::size_t align) {
+        if (align < alignof(FreeSlot)) {
+            align = alignof(FreeSlot);
+        }
+        if (size < sizeof(FreeSlot)) {
+            size = sizeof(FreeSlot);
+        }
+        return (size + align - 1) / align * align;
+    }
+
+    /**
+     * @brief Verifica se l'arena può servire slot della dimensione specificata.
+     *
+     * Fissa la dimensione degli slot se l'arena non è ancora stata usata.
+     *
+     * @param size Dimensione dello slot richiesto.
+     * @return true se l'arena gestisce slot di quella dimensione.
+     */
+    bool accepts(std::size_t size) {
+        if (slotSize == 0) {
+            slotSize = size;
+        }
+        return slotSize == size;
+    }
+
+    /**
+     * @brief Alloca uno slot.
+     *
+     * @return Puntatore allo slot allocato.
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    void *allocate() {
+        if (freeList != nullptr) {
+            FreeSlot *slot = freeList;
+            freeList = slot->next;
+            return slot;
+        }
+        if (remaining == 0) {
+            grow(blockSlots);
+        }
+        void *slot = cursor;
+        cursor += slotSize;
+        --remaining;
+        return slot;
+    }
+
+    /**
+     * @brief Restituisce uno slot all'arena.
+     *
+     * @param p Slot da restituire.
+     */
+    void deallocate(void *p) {
+        FreeSlot *slot = static_cast<FreeSlot *>(p);
+        slot->next = freeList;
+        freeList = slot;
+    }
+
+    /**
+     * @brief Garantisce che le prossime n allocazioni non richiedano nuovi blocchi.
+     *
+     * Se gli slot disponibili nel blocco corrente non bastano viene allocato
+     * un unico blocco contiguo abbastanza grande per tutti gli n slot.
+     *
+     * @param n Numero di slot da riservare.
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    void reserve(std::size_t n) {
+        if (slotSize == 0 || n <= remaining) {
+            return;
+        }
+        std::size_t available = remaining;
+        for (FreeSlot *slot = freeList; slot != nullptr && available < n; slot = slot->next) {
+            ++available;
+        }
+        if (available >= n) {
+            return;
+        }
+        if (remaining > 0) {
+            // gli slot non usati del blocco corrente vengono spostati nella free list
+            for (; remaining > 0; --remaining, cursor += slotSize) {
+                deallocate(cursor);
+            }
+        }
+        grow(n - available > blockSlots ? n - available : blockSlots);
+    }
+
+    /**
+     * @brief Restituisce al sistema tutti i blocchi in O(numero di blocchi).
+     *
+     * Tutti gli slot allocati diventano non validi.
+     */
+    void release() {
+        for (std::size_t i = 0; i < blocks.size(); ++i) {
+            ::operator delete(blocks[i]);
+        }
+        blocks.clear();
+        freeList = nullptr;
+        cursor = nullptr;
+        remaining = 0;
+    }
+};
+
+/**
+  @brief classe PoolAllocator
+
+  Allocatore compatibile con std::allocator che ricava gli oggetti da blocchi
+  contigui di BlockSlots elementi tramite una PoolArena condivisa tra tutte le
+  copie (anche di tipo diverso ottenute con rebind).
+  Le allocazioni di più di un oggetto, o di oggetti di dimensione diversa da
+  quella fissata dall'arena, vengono servite da ::operator new.
+
+  La copia di un contenitore ottiene un'arena nuova
+  (select_on_container_copy_construction); l'arena segue il contenitore nello
+  spostamento e nello scambio.
+
+  @tparam T tipo degli oggetti allocati
+  @tparam BlockSlots numero di oggetti per blocco
+*/
+template <typename T, std::size_t BlockSlots = 4096>
+class PoolAllocator {
+
+public:
+    typedef T value_type;                                    ///< Tipo degli oggetti allocati
+    typedef T *pointer;                                      ///< Puntatore a oggetto
+    typedef const T *const_pointer;                          ///< Puntatore costante a oggetto
+    typedef T &reference;                                    ///< Reference a oggetto
+    typedef const T &const_reference;                        ///< Reference costante a oggetto
+    typedef std::size_t size_type;                           ///< Tipo delle dimensioni
+    typedef std::ptrdiff_t difference_type;                  ///< Tipo delle differenze tra puntatori
+    typedef std::true_type propagate_on_container_move_assignment; ///< L'arena segue lo spostamento
+    typedef std::true_type propagate_on_container_swap;      ///< L'arena segue lo scambio
+
+    /**
+      @brief Allocatore dello stesso tipo per oggetti di tipo U
+    */
+    template <typename U>
+    struct rebind {
+        typedef PoolAllocator<U, BlockSlots> other; ///< Tipo dell'allocatore per U
+    };
+
+    /**
+     * @brief Costruttore di default
+     *
+     * Crea un allocatore con un'arena nuova.
+     *
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    PoolAllocator() : arena(std::make_shared<PoolArena>(BlockSlots)) {}
+
+    /**
+     * @brief Copy constructor
+     *
+     * Crea un allocatore che condivide l'arena di un altro. Viene usato anche
+     * al posto dello spostamento, così che l'allocatore di origine resti valido.
+     *
+     * @param other Allocatore da cui condividere l'arena.
+     */
+    PoolAllocator(const PoolAllocator &other) : arena(other.arena) {}
+
+    /**
+     * @brief Costruttore di conversione
+     *
+     * Crea un allocatore che condivide l'arena di un allocatore per un altro tipo.
+     *
+     * @param other Allocatore da cui condividere l'arena.
+     */
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U, BlockSlots> &other) : arena(other.arena) {}
+
+    /**
+     * @brief Alloca spazio per n oggetti di tipo T.
+     *
+     * @param n Numero di oggetti.
+     * @return Puntatore alla memoria allocata.
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    T *allocate(std::size_t n) {
+        if (n == 1 && arena->accepts(slot())) {
+            return static_cast<T *>(arena->allocate());
+        }
+        return static_cast<T *>(::operator new(n * sizeof(T)));
+    }
+
+    /**
+     * @brief Dealloca spazio per n oggetti di tipo T.
+     *
+     * @param p Puntatore restituito da allocate(n).
+     * @param n Numero di oggetti.
+     */
+    void deallocate(T *p, std::size_t n) {
+        if (n == 1 && arena->accepts(slot())) {
+            arena->deallocate(p);
+        } else {
+            ::operator delete(p);
+        }
+    }
+
+    /**
+     * @brief Garantisce che le prossime n allocazioni singole non richiedano nuovi blocchi.
+     *
+     * @param n Numero di oggetti da riservare.
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    void reserve(std::size_t n) {
+        if (arena->accepts(slot())) {
+            arena->reserve(n);
+        }
+    }
+
+    /**
+     * @brief Verifica se questo allocatore è l'unico a usare la propria arena.
+     *
+     * @return true se nessun'altra copia condivide l'arena.
+     */
+    bool exclusive() const {
+        return arena.use_count() == 1;
+    }
+
+    /**
+     * @brief Restituisce al sistema tutti i blocchi dell'arena.
+     *
+     * Tutti gli oggetti allocati dall'arena diventano non validi; i loro
+     * distruttori non vengono invocati.
+     */
+    void release() {
+        arena->release();
+    }
+
+    /**
+     * @brief Allocatore da usare per la copia di un contenitore.
+     *
+     * @return Un allocatore con un'arena nuova.
+     */
+    PoolAllocator select_on_container_copy_construction() const {
+        return PoolAllocator();
+    }
+
+    /**
+     * @brief Operatore di uguaglianza.
+     *
+     * @param other Allocatore da confrontare.
+     * @return true se i due allocatori condividono l'arena.
+     */
+    template <typename U>
+    bool operator==(const PoolAllocator<U, BlockSlots> &other) const {
+        return arena == other.arena;
+    }
+
+    /**
+     * @brief Operatore di disuguaglianza.
+     *
+     * @param other Allocatore da confrontare.
+     * @return true se i due allocatori non condividono l'arena.
+     */
+    template <typename U>
+    bool operator!=(const PoolAllocator<U, BlockSlots> &other) const {
+        return arena != other.arena;
+    }
+
+private:
+    std::shared_ptr<PoolArena> arena; ///< Arena condivisa
+
+    /**
+     * @brief Dimensione dello slot per il tipo T.
+     */
+    static std::size_t slot() {
+        return PoolArena::slotFor(sizeof(T), alignof(T));
+    }
+
+    template <typename U, std::size_t B>
+    friend class PoolAllocator;
+};
+
+/**
+  @brief Tratti per il rilascio in blocco della memoria di un allocatore
+
+  Un contenitore può usare release() per liberare tutti i propri nodi in una
+  volta sola quando exclusive() indica che nessun altro usa la stessa memoria.
+  Di default il rilascio in blocco non è disponibile.
+*/
+template <typename Alloc>
+struct allocator_release_traits {
+    static const bool enabled = false; ///< Rilascio in blocco non disponibile
+
+    /**
+     * @brief Verifica se l'allocatore possiede in esclusiva la propria memoria.
+     */
+    static bool exclusive(const Alloc &) {
+        return false;
+    }
+
+    /**
+     * @brief Rilascia in blocco la memoria (nessuna operazione).
+     */
+    static void release(Alloc &) {}
+
+    /**
+     * @brief Riserva spazio per n allocazioni singole (nessuna operazione).
+     */
+    static void reserve(Alloc &, std::size_t) {}
+};
+
+/**
+  @brief Tratti per il rilascio in blocco della memoria di un PoolAllocator
+*/
+template <typename T, std::size_t BlockSlots>
+struct allocator_release_traits<PoolAllocator<T, BlockSlots> > {
+    static const bool enabled = true; ///< Rilascio in blocco disponibile
+
+    /**
+     * @brief Verifica se l'allocatore possiede in esclusiva la propria arena.
+     *
+     * @param a Allocatore da verificare.
+     * @return true se nessun'altra copia condivide l'arena.
+     */
+    static bool exclusive(const PoolAllocator<T, BlockSlots> &a) {
+        return a.exclusive();
+    }
+
+    /**
+     * @brief Rilascia in blocco tutta la memoria dell'arena.
+     *
+     * @param a Allocatore da rilasciare.
+     */
+    static void release(PoolAllocator<T, BlockSlots> &a) {
+        a.release();
+    }
+
+    /**
+     * @brief Riserva spazio per n allocazioni singole.
+     *
+     * @param a Allocatore.
+     * @param n Numero di allocazioni da riservare.
+     * @throw std::bad_alloc possibile eccezione di allocazione
+     */
+    static void reserve(PoolAllocator<T, BlockSlots> &a, std::size_t n) {
+        a.reserve(n);
+    }
+};
+
+#endif // POOLALLOCATOR_HPP
@@ -0,0 +1,460 @@
+#include "BinarySearchTree.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+/**
+ * @brief Record usato per i benchmark, analogo alla Person dei test.
+ */
+class Person {
+public:
+    int id;           ///< ID della persona.
+    std::string name; ///< Nome della persona.
+
+    /**
+     * @brief Costruttore della classe Person.
+     *
+     * @param id ID della persona.
+     * @param name Nome della persona.
+     */
+    Person(int id, const std::string &name) : id(id), name(name) {}
+};
+
+/**
+ * @brief Funtore per confrontare due oggetti di tipo Person in base all'ID.
+ */
+struct compare_person {
+    bool operator()(const Person &a, const Person &b) const {
+        return a.id < b.id;
+    }
+};
+
+/**
+ * @brief Funtore per determinare l'uguaglianza tra due oggetti di tipo Person in base all'ID.
+ */
+struct equal_person {
+    bool operator()(const Person &a, const Person &b) const {
+        return a.id == b.id;
+    }
+};
+
+/**
+ * @brief Byte allocati e non ancora liberati tramite counting_allocator.
+ */
+long long liveBytes = 0;
+
+/**
+ * @brief Allocatore che conta i byte allocati, per misurare la memoria occupata dagli alberi.
+ */
+template <typename T>
+struct counting_allocator {
+    typedef T value_type;
+
+    counting_allocator() {}
+
+    template <typename U>
+    counting_allocator(const counting_allocator<U> &) {}
+
+    T *allocate(std::size_t n) {
+        liveBytes += static_cast<long long>(n * sizeof(T));
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T *p, std::size_t n) {
+        liveBytes -= static_cast<long long>(n * sizeof(T));
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    template <typename U>
+    bool operator==(const counting_allocator<U> &) const {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const counting_allocator<U> &) const {
+        return false;
+    }
+};
+
+typedef BinarySearchTree<int, std::less<int>, std::equal_to<int>, avl_balance, no_augment, counting_allocator<int> >
+    int_tree;
+typedef BinarySearchTree<Person, compare_person, equal_person, avl_balance, no_augment, counting_allocator<Person> >
+    person_tree;
+
+/**
+ * @brief Opzioni della riga di comando.
+ */
+struct Options {
+    long long minSize;        ///< Dimensione minima
+    long long maxSize;        ///< Dimensione massima
+    std::string json;         ///< File JSON dei risultati, vuoto per non scriverlo
+    std::string type;         ///< Tipo da misurare: int, person o all
+    std::string distribution; ///< Distribuzione da misurare o all
+
+    Options() : minSize(1000), maxSize(1000000), type("all"), distribution("all") {}
+};
+
+/**
+ * @brief Risultato di un'operazione misurata.
+ */
+struct Result {
+    std::string type;         ///< Tipo dei valori
+    std::string distribution; ///< Distribuzione delle chiavi
+    long long size;           ///< Numero di chiavi generate
+    std::string operation;    ///< Operazione misurata
+    long long ops;            ///< Operazioni eseguite in totale
+    double seconds;           ///< Tempo totale
+    long long treeBytes;      ///< Byte allocati per i nodi dell'albero
+    long long distinct;       ///< Valori distinti nell'albero
+};
+
+/**
+ * @brief Valore in cui accumulare i risultati perché il compilatore non elimini il lavoro misurato.
+ */
+volatile long long sink = 0;
+
+/**
+ * @brief Picco di memoria residente dell'intero processo in KiB, 0 se non disponibile.
+ *
+ * ru_maxrss non si azzera tra un caso e l'altro: il valore copre tutti i casi eseguiti fino a quel
+ * momento e va riportato una sola volta, non attribuito al singolo caso (per quello c'è tree_bytes).
+ */
+long long peakRssKiB() {
+#if defined(__unix__) || defined(__APPLE__)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#if defined(__APPLE__)
+        return usage.ru_maxrss / 1024;
+#else
+        return usage.ru_maxrss;
+#endif
+    }
+#endif
+    return 0;
+}
+
+/**
+ * @brief Permutazione pseudocasuale degli interi a 32 bit.
+ */
+std::uint32_t scramble(std::uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+/**
+ * @brief Generatore di ranghi con distribuzione di Zipf (metodo di Gray et al.).
+ *
+ * Il rango 0 è il più frequente; il costo di inizializzazione è O(n), quello
+ * di ogni estrazione O(1).
+ */
+class ZipfGenerator {
+public:
+    /**
+     * @brief Costruttore
+     *
+     * @param n Numero di ranghi.
+     * @param theta Esponente della distribuzione, in (0, 1).
+     * @param seed Seme del generatore uniforme.
+     */
+    ZipfGenerator(long long n, double theta, std::uint64_t seed) : n(n), theta(theta), state(seed) {
+        double zeta2 = 1.0 + std::pow(0.5, theta);
+        zetan = 0;
+        for (long long i = 1; i <= n; ++i) {
+            zetan += std::pow(static_cast<double>(i), -theta);
+        }
+        alpha = 1.0 / (1.0 - theta);
+        eta = (1.0 - std::pow(2.0 / n, 1.0 - theta)) / (1.0 - zeta2 / zetan);
+    }
+
+    /**
+     * @brief Estrae un rango.
+     */
+    long long next() {
+        double u = uniform();
+        double uz = u * zetan;
+        if (uz < 1.0) {
+            return 0;
+        }
+        if (uz < 1.0 + std::pow(0.5, theta)) {
+            return 1;
+        }
+        long long rank = static_cast<long long>(n * std::pow(eta * u - eta + 1.0, alpha));
+        return std::min(rank, n - 1);
+    }
+
+private:
+    long long n;         ///< Numero di ranghi
+    double theta;        ///< Esponente
+    double zetan;        ///< Somma di 1 / i^theta per i in [1, n]
+    double alpha;        ///< 1 / (1 - theta)
+    double eta;          ///< Costante del metodo
+    std::uint64_t state; ///< Stato del generatore uniforme
+
+    /**
+     * @brief Numero uniforme in [0, 1) (splitmix64).
+     */
+    double uniform() {
+        std::uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        z ^= z >> 31;
+        return static_cast<double>(z >> 11) / 9007199254740992.0;
+    }
+};
+
+/**
+ * @brief Genera n chiavi con la distribuzione richiesta.
+ *
+ * random: chiavi distinte in ordine pseudocasuale; sorted e reverse: 0, ..., n - 1
+ * in ordine crescente o decrescente; zipf: chiavi ripetute con frequenze di Zipf
+ * (theta = 0.99), le più frequenti sparse nell'intervallo delle chiavi.
+ */
+std::vector<int> makeKeys(const std::string &distribution, long long n) {
+    std::vector<int> keys;
+    keys.reserve(static_cast<std::size_t>(n));
+    if (distribution == "random") {
+        for (long long i = 0; i < n; ++i) {
+            keys.push_back(static_cast<int>(scramble(static_cast<std::uint32_t>(i))));
+        }
+    } else if (distribution == "sorted") {
+        for (long long i = 0; i < n; ++i) {
+            keys.push_back(static_cast<int>(i));
+        }
+    } else if (distribution == "reverse") {
+        for (long long i = n - 1; i >= 0; --i) {
+            keys.push_back(static_cast<int>(i));
+        }
+    } else {
+        ZipfGenerator zipf(n, 0.99, 42);
+        for (long long i = 0; i < n; ++i) {
+            keys.push_back(static_cast<int>(scramble(static_cast<std::uint32_t>(zipf.next()))));
+        }
+    }
+    return keys;
+}
+
+/**
+ * @brief Converte le chiavi nei valori del tipo misurato.
+ */
+void makeValues(const std::vector<int> &keys, std::vector<int> &values) {
+    values = keys;
+}
+
+void makeValues(const std::vector<int> &keys, std::vector<Person> &values) {
+    values.reserve(keys.size());
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        values.push_back(Person(keys[i], "persona-" + std::to_string(keys[i])));
+    }
+}
+
+long long valueKey(int value) {
+    return value;
+}
+
+long long valueKey(const Person &value) {
+    return value.id;
+}
+
+/**
+ * @brief Secondi trascorsi da un istante.
+ */
+double elapsed(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief Misura tutte le operazioni su un tipo di albero, una distribuzione e una dimensione.
+ *
+ * Per le dimensioni piccole la misura è ripetuta finché le operazioni eseguite
+ * non sono almeno un milione, ricostruendo ogni volta l'albero.
+ */
+template <typename Tree, typename V>
+void runCase(const std::string &type, const std::string &distribution, long long n, std::vector<Result> &results) {
+    std::vector<V> values;
+    makeValues(makeKeys(distribution, n), values);
+    std::vector<V> probes;
+
+    const char *names[] = {"insert", "contains", "contains_batch", "iterate", "copy", "subtree", "remove"};
+    const int operations = sizeof(names) / sizeof(names[0]);
+    double seconds[operations] = {};
+    long long ops[operations] = {};
+    long long treeBytes = 0;
+    long long distinct = 0;
+    int repetitions = static_cast<int>(std::max(1LL, 1000000 / n));
+    std::vector<char> hits(values.size());
+    for (int r = 0; r < repetitions; ++r) {
+        long long before = liveBytes;
+        Tree tree;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            tree.insert(values[i]);
+        }
+        seconds[0] += elapsed(start);
+        ops[0] += n;
+        treeBytes = liveBytes - before;
+        distinct = tree.size();
+        if (probes.empty()) {
+            // radici dei sottoalberi scelte in modo uniforme tra i nodi, non tra le chiavi generate
+            int step = std::max(1, tree.size() / 1000);
+            int index = 0;
+            for (typename Tree::const_iterator it = tree.begin(); it != tree.end(); ++it, ++index) {
+                if (index % step == 0) {
+                    probes.push_back(*it);
+                }
+            }
+        }
+
+        start = std::chrono::steady_clock::now();
+        long long found = 0;
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            found += tree.contains(values[i]);
+        }
+        seconds[1] += elapsed(start);
+        ops[1] += n;
+
+        start = std::chrono::steady_clock::now();
+        tree.contains_batch(values.begin(), values.end(), hits.begin());
+        seconds[2] += elapsed(start);
+        ops[2] += n;
+        found += std::count(hits.begin(), hits.end(), 1);
+
+        start = std::chrono::steady_clock::now();
+        long long sum = 0;
+        for (typename Tree::const_iterator it = tree.begin(); it != tree.end(); ++it) {
+            sum += valueKey(*it);
+        }
+        seconds[3] += elapsed(start);
+        ops[3] += tree.size();
+
+        start = std::chrono::steady_clock::now();
+        {
+            Tree copy(tree);
+            seconds[4] += elapsed(start);
+            ops[4] += copy.size();
+        }
+
+        start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < probes.size(); ++i) {
+            sum += tree.subtree(probes[i]).size();
+        }
+        seconds[5] += elapsed(start);
+        ops[5] += static_cast<long long>(probes.size());
+
+        start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            tree.remove(values[i]);
+        }
+        seconds[6] += elapsed(start);
+        ops[6] += n;
+        sink = sink + found + sum + tree.size();
+    }
+
+    for (int i = 0; i < operations; ++i) {
+        Result result = {type, distribution, n, names[i], ops[i], seconds[i], treeBytes, distinct};
+        results.push_back(result);
+        double ns = seconds[i] * 1e9 / std::max(1LL, ops[i]);
+        std::printf("%-7s %-8s %10lld %-15s %10.1f ns/op %9.2f Mop/s %6.1f B/node\n", type.c_str(),
+                    distribution.c_str(), n, names[i], ns, ns > 0 ? 1e3 / ns : 0.0,
+                    static_cast<double>(treeBytes) / std::max(1LL, distinct));
+    }
+    std::fflush(stdout);
+}
+
+/**
+ * @brief Scrive i risultati in formato JSON, con il picco di memoria dell'intero processo.
+ */
+bool writeJson(const std::string &path, const std::vector<Result> &results, long long processPeakKiB) {
+    std::ofstream out(path.c_str());
+    out << "{\n  \"benchmark\": \"BinarySearchTree\",\n  \"tree\": \"avl_balance\",\n  \"results\": [\n";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const Result &r = results[i];
+        double ns = r.seconds * 1e9 / std::max(1LL, r.ops);
+        out << "    {\"type\": \"" << r.type << "\", \"distribution\": \"" << r.distribution << "\", \"size\": " << r.size
+            << ", \"operation\": \"" << r.operation << "\", \"ops\": " << r.ops << ", \"ns_per_op\": " << ns
+            << ", \"ops_per_second\": " << (ns > 0 ? 1e9 / ns : 0.0) << ", \"distinct\": " << r.distinct
+            << ", \"tree_bytes\": " << r.treeBytes << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ],\n  \"process_peak_rss_kib\": " << processPeakKiB << "\n}\n";
+    return static_cast<bool>(out);
+}
+
+/**
+ * @brief Legge una dimensione, anche in notazione esponenziale (1e8).
+ */
+long long parseSize(const char *text) {
+    double value = std::atof(text);
+    if (!(value >= 1 && value <= 2147483647.0)) {
+        std::fprintf(stderr, "dimensione non valida: %s\n", text);
+        std::exit(2);
+    }
+    return static_cast<long long>(value);
+}
+
+void usage() {
+    std::fprintf(stderr, "uso: bench.exe [--min-size N] [--max-size N] [--type int|person|all]\n"
+                         "                [--distribution random|sorted|reverse|zipf|all] [--json file]\n");
+    std::exit(2);
+}
+
+int main(int argc, char *argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        if (i + 1 >= argc) {
+            usage();
+        }
+        if (std::strcmp(argv[i], "--min-size") == 0) {
+            options.minSize = parseSize(argv[++i]);
+        } else if (std::strcmp(argv[i], "--max-size") == 0) {
+            options.maxSize = parseSize(argv[++i]);
+        } else if (std::strcmp(argv[i], "--type") == 0) {
+            options.type = argv[++i];
+        } else if (std::strcmp(argv[i], "--distribution") == 0) {
+            options.distribution = argv[++i];
+        } else if (std::strcmp(argv[i], "--json") == 0) {
+            options.json = argv[++i];
+        } else {
+            usage();
+        }
+    }
+
+    const char *distributions[] = {"random", "sorted", "reverse", "zipf"};
+    std::vector<Result> results;
+    for (long long n = options.minSize; n <= options.maxSize; n *= 10) {
+        for (int d = 0; d < 4; ++d) {
+            if (options.distribution != "all" && options.distribution != distributions[d]) {
+                continue;
+            }
+            if (options.type == "all" || options.type == "int") {
+                runCase<int_tree, int>("int", distributions[d], n, results);
+            }
+            if (options.type == "all" || options.type == "person") {
+                runCase<person_tree, Person>("person", distributions[d], n, results);
+            }
+        }
+    }
+
+    long long processPeakKiB = peakRssKiB();
+    std::printf("process peak RSS (all cases): %lld KiB\n", processPeakKiB);
+    if (!options.json.empty() && !writeJson(options.json, results, processPeakKiB)) {
+        std::fprintf(stderr, "impossibile scrivere %s\n", options.json.c_str());
+        return 1;
+    }
+    return 0;
+}
@@ -1,5 +1,22 @@
+#include "BPlusTree.hpp"
 #include "BinarySearchTree.hpp"
+#include "CompactBinarySearchTree.hpp"
+#include "ConcurrentBinarySearchTree.hpp"
+#include "FrozenFileMapping.hpp"
+#include "PersistentBinarySearchTree.hpp"
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iterator>
+#include <limits>
+#include <set>
+#include <stdexcept>
+#include <sstream>
+#include <thread>
 #include <vector>
 
 /**
@@ -34,6 +51,39 @@ struct equal_int {
     }
 };
 
+/**
+ * @brief compare_int coincide con l'operatore <: abilita la ricerca SIMD nei nodi di BPlusTree.
+ */
+template <>
+struct natural_order<compare_int> : std::true_type {};
+
+/**
+ * @brief Funtore di confronto per il tipo int con confronto a tre vie.
+ */
+struct compare_int_three_way {
+    /**
+     * @brief Confronta due interi.
+     *
+     * @param a Primo intero da confrontare.
+     * @param b Secondo intero da confrontare.
+     * @return true se il primo intero è minore del secondo, false altrimenti.
+     */
+    bool operator()(int a, int b) const {
+        return a < b;
+    }
+
+    /**
+     * @brief Confronta due interi a tre vie.
+     *
+     * @param a Primo intero da confrontare.
+     * @param b Secondo intero da confrontare.
+     * @return Negativo se a < b, positivo se a > b, 0 se sono uguali.
+     */
+    int three_way(int a, int b) const {
+        return a < b ? -1 : (b < a ? 1 : 0);
+    }
+};
+
 /**
  * @brief Classe rappresentante una persona con ID e nome.
  *
@@ -127,6 +177,41 @@ struct starts_with_a {
     }
 };
 
+/**
+ * @brief Confronta un BPlusTree con un std::set su inserimenti e rimozioni pseudo-casuali.
+ */
+template <typename Tree>
+void checkBPlusTreeAgainstSet() {
+    Tree tree;
+    std::set<int> reference;
+    unsigned seed = 12345;
+    for (int step = 0; step < 20000; ++step) {
+        seed = seed * 1103515245u + 12345u;
+        int value = static_cast<int>((seed >> 8) % 2000) - 1000;
+        if (step % 3 == 2) {
+            tree.remove(value);
+            reference.erase(value);
+        } else {
+            std::pair<typename Tree::const_iterator, bool> res = tree.insert(value);
+            assert(*res.first == value);
+            assert(res.second == reference.insert(value).second);
+        }
+        assert(tree.size() == static_cast<int>(reference.size()));
+    }
+    assert(std::vector<int>(tree.begin(), tree.end()) == std::vector<int>(reference.begin(), reference.end()));
+    for (int v = -1001; v <= 1001; ++v) {
+        assert(tree.contains(v) == (reference.count(v) == 1));
+    }
+
+    Tree copy(tree);
+    for (std::set<int>::const_iterator it = reference.begin(); it != reference.end(); ++it) {
+        tree.remove(*it);
+    }
+    assert(tree.size() == 0);
+    assert(tree.begin() == tree.end());
+    assert(std::vector<int>(copy.rbegin(), copy.rend()) == std::vector<int>(reference.rbegin(), reference.rend()));
+}
+
 void testDuplicateInsertAsRoot() {
     BinarySearchTree<int, compare_int, equal_int> bst;
     bst.insert(10);
@@ -240,6 +325,40 @@ void testDuplicatePersonIdInsert() {
               << std::endl;
 }
 
+void testInsertReturnValue() {
+    BinarySearchTree<int, compare_int, equal_int, avl_balance> bst;
+    std::pair<BinarySearchTree<int, compare_int, equal_int, avl_balance>::const_iterator, bool> result = bst.insert(10);
+    assert(result.second);
+    assert(*result.first == 10);
+
+    bst.insert(5);
+    bst.insert(20);
+    result = bst.insert(5);
+    assert(!result.second);
+    assert(*result.first == 5);
+    ++result.first;
+    assert(*result.first == 10);
+
+    std::cout << "Test testInsertReturnValue: passed" << std::endl
+              << std::endl;
+}
+
+void testInsertDuplicateKeepsRvaluePerson() {
+    BinarySearchTree<Person, compare_person, equal_person> bst;
+    bst.insert(Person(1, "Alice"));
+
+    Person duplicate(1, "Anna");
+    std::pair<BinarySearchTree<Person, compare_person, equal_person>::const_iterator, bool> result = bst.insert(std::move(duplicate));
+
+    assert(!result.second);
+    assert(result.first->name == "Alice");
+    assert(duplicate.name == "Anna");
+    assert(bst.size() == 1);
+
+    std::cout << "Test testInsertDuplicateKeepsRvaluePerson: passed" << std::endl
+              << std::endl;
+}
+
 void testContainsPerson() {
     BinarySearchTree<Person, compare_person, equal_person> bst;
     bst.insert(Person(1, "Alice"));
@@ -258,6 +377,29 @@ void testContainsPerson() {
               << std::endl;
 }
 
+void testCompareEquivalence() {
+    BinarySearchTree<int, compare_int, compare_equivalence, avl_balance> bst;
+    BinarySearchTree<int, compare_int_three_way, compare_equivalence> bst3;
+    for (int i = 0; i < 200; i += 2) {
+        bst.insert(i);
+        bst3.insert(199 - i);
+    }
+
+    for (int i = -1; i <= 200; ++i) {
+        assert(bst.contains(i) == (i >= 0 && i < 200 && i % 2 == 0));
+        assert(bst3.contains(i) == (i >= 0 && i < 200 && i % 2 == 1));
+    }
+    assert(bst.subtree(*bst.begin()).size() == 1);
+
+    bst.remove(100);
+    bst3.remove(101);
+    assert(!bst.contains(100) && bst.size() == 99);
+    assert(!bst3.contains(101) && bst3.size() == 99);
+
+    std::cout << "Test testCompareEquivalence: passed" << std::endl
+              << std::endl;
+}
+
 void testSizePerson() {
     BinarySearchTree<Person, compare_person, equal_person> bst;
 
@@ -457,6 +599,85 @@ void testAssignmentPopulatedToEmptyPerson() {
               << std::endl;
 }
 
+void testMoveConstructorPerson() {
+    BinarySearchTree<Person, compare_person, equal_person> bst1;
+    bst1.insert(Person(1, "Alice"));
+    bst1.insert(Person(2, "Bob"));
+
+    BinarySearchTree<Person, compare_person, equal_person> bst2(std::move(bst1));
+
+    assert(bst2.size() == 2);
+    assert(bst2.contains(Person(1, "Alice")));
+    assert(bst1.size() == 0);
+    assert(bst1.begin() == bst1.end());
+
+    bst1.insert(Person(3, "Charlie"));
+    assert(bst1.size() == 1);
+
+    std::cout << bst2 << std::endl;
+    std::cout << "Test testMoveConstructorPerson: passed" << std::endl
+              << std::endl;
+}
+
+void testMoveAssignmentPerson() {
+    typedef BinarySearchTree<Person, compare_person, equal_person, avl_balance, no_augment, PoolAllocator<Person> > pool_tree;
+    pool_tree bst1;
+    bst1.insert(Person(1, "Alice"));
+    bst1.insert(Person(2, "Bob"));
+    pool_tree bst2;
+    bst2.insert(Person(3, "Charlie"));
+
+    bst2 = std::move(bst1);
+
+    assert(bst2.size() == 2);
+    assert(!bst2.contains(Person(3, "Charlie")));
+    assert(bst1.size() == 0);
+    bst1.insert(Person(4, "Diana"));
+    assert(bst1.contains(Person(4, "Diana")));
+
+    std::cout << "Test testMoveAssignmentPerson: passed" << std::endl
+              << std::endl;
+}
+
+void testMoveNoexcept() {
+    typedef BinarySearchTree<Person, compare_person, equal_person, avl_balance> person_tree;
+    static_assert(std::is_nothrow_move_constructible<person_tree>::value, "move constructor must be noexcept");
+    static_assert(std::is_nothrow_move_assignable<person_tree>::value, "move assignment must be noexcept");
+
+    // la riallocazione del vector sposta gli alberi: i nodi restano gli stessi
+    std::vector<person_tree> trees(1);
+    trees[0].insert(Person(1, "Alice"));
+    const Person *first = &*trees[0].begin();
+    trees.reserve(trees.capacity() * 4 + 1);
+    assert(&*trees[0].begin() == first);
+    for (int i = 0; i < 100; ++i) {
+        trees.push_back(person_tree());
+    }
+    assert(&*trees[0].begin() == first && trees[0].size() == 1);
+
+    std::cout << "Test testMoveNoexcept: passed" << std::endl
+              << std::endl;
+}
+
+void testEmplacePerson() {
+    BinarySearchTree<Person, compare_person, equal_person> bst;
+
+    assert(bst.emplace(2, "Bob").second);
+    assert(bst.emplace(1, std::string(1000, 'A')).second);
+    assert(!bst.emplace(2, "Bobby").second);
+
+    std::string name("Charlie");
+    Person p(3, name);
+    bst.insert(std::move(p));
+
+    assert(bst.size() == 3);
+    assert(bst.begin()->name.size() == 1000);
+    assert(bst.subtree(Person(3, "")).size() == 1);
+
+    std::cout << "Test testEmplacePerson: passed" << std::endl
+              << std::endl;
+}
+
 void testEmptyTreeIterator() {
     BinarySearchTree<Person, compare_person, equal_person> bst;
 
@@ -509,6 +730,34 @@ void testMultiElementTreeIterator() {
               << std::endl;
 }
 
+void testReverseIterator() {
+    int dati[7] = {10, 5, 15, 7, 2, 4, 9};
+    BinarySearchTree<int, compare_int, equal_int> bst(dati, dati + 7);
+
+    std::vector<int> reversed(bst.rbegin(), bst.rend());
+    int expected[7] = {15, 10, 9, 7, 5, 4, 2};
+    assert(reversed.size() == 7);
+    for (int i = 0; i < 7; ++i) {
+        assert(reversed[i] == expected[i]);
+    }
+
+    BinarySearchTree<int, compare_int, equal_int>::const_iterator it = bst.end();
+    --it;
+    assert(*it == 15);
+    it--;
+    assert(*it == 10);
+    ++it;
+    assert(*it == 15);
+    ++it;
+    assert(it == bst.end());
+
+    BinarySearchTree<int, compare_int, equal_int> empty;
+    assert(empty.rbegin() == empty.rend());
+
+    std::cout << "Test testReverseIterator: passed" << std::endl
+              << std::endl;
+}
+
 void testConstructorWithIterators() {
     std::vector<Person> persons = {Person(2, "Bob"), Person(1, "Alice"), Person(3, "Charlie")};
     BinarySearchTree<Person, compare_person, equal_person> bst(persons.begin(), persons.end());
@@ -523,6 +772,51 @@ void testConstructorWithIterators() {
               << std::endl;
 }
 
+void testConstructorSortedUnique() {
+    std::vector<int> sorted;
+    for (int i = 0; i < 1023; ++i) {
+        sorted.push_back(i);
+    }
+    BinarySearchTree<int, compare_int, equal_int> bst(sorted_unique, sorted.begin(), sorted.end());
+
+    assert(bst.size() == 1023);
+    assert(bst.height() == 10);
+    assert(std::vector<int>(bst.begin(), bst.end()) == sorted);
+
+    BinarySearchTree<int, compare_int, equal_int, avl_balance, size_augment> avl(sorted.begin(), sorted.end());
+    assert(avl.height() == 10);
+    assert(*avl.select(500) == 500);
+    avl.insert(2000);
+    avl.remove(0);
+    assert(avl.size() == 1023);
+    assert(avl.rank(2000) == 1022);
+
+    std::cout << "Test testConstructorSortedUnique: passed" << std::endl
+              << std::endl;
+}
+
+void testConstructorUnsortedDuplicatesPerson() {
+    std::vector<Person> persons = {Person(3, "Charlie"), Person(1, "Alice"), Person(3, "Carl"), Person(2, "Bob"), Person(1, "Anna")};
+    BinarySearchTree<Person, compare_person, equal_person> bst(persons.begin(), persons.end());
+
+    assert(bst.size() == 3);
+    assert(bst.height() == 2);
+    BinarySearchTree<Person, compare_person, equal_person>::const_iterator it = bst.begin();
+    assert(it->name == "Alice");
+    ++it;
+    assert(it->name == "Bob");
+    ++it;
+    assert(it->name == "Charlie");
+
+    bst.assign_sorted(persons.begin() + 3, persons.begin() + 4);
+    assert(bst.size() == 1);
+    assert(bst.contains(Person(2, "")));
+
+    std::cout << bst << std::endl;
+    std::cout << "Test testConstructorUnsortedDuplicatesPerson: passed" << std::endl
+              << std::endl;
+}
+
 void testPrintIF() {
     int dati[6] = {1, 2, 4, 8, 3, 17};
 
@@ -614,6 +908,1554 @@ void testSubtreeLeaf() {
               << std::endl;
 }
 
+void testAvlSortedInsert() {
+    BinarySearchTree<int, compare_int, equal_int, avl_balance> bst;
+    for (int i = 0; i < 1000; ++i) {
+        bst.insert(i);
+    }
+
+    assert(bst.size() == 1000);
+    assert(bst.height() <= 11);
+    for (int i = 0; i < 1000; ++i) {
+        assert(bst.contains(i));
+    }
+
+    int expected = 0;
+    for (BinarySearchTree<int, compare_int, equal_int, avl_balance>::const_iterator it = bst.begin(); it != bst.end(); ++it) {
+        assert(*it == expected);
+        ++expected;
+    }
+    assert(expected == 1000);
+
+    std::cout << "Test testAvlSortedInsert: passed" << std::endl
+              << std::endl;
+}
+
+void testAvlRemove() {
+    BinarySearchTree<int, compare_int, equal_int, avl_balance> bst;
+    for (int i = 1000; i > 0; --i) {
+        bst.insert(i);
+    }
+    for (int i = 1; i <= 1000; i += 2) {
+        bst.remove(i);
+    }
+
+    assert(bst.size() == 500);
+    assert(bst.height() <= 10);
+    for (int i = 1; i <= 1000; ++i) {
+        assert(bst.contains(i) == (i % 2 == 0));
+    }
+
+    std::cout << "Test testAvlRemove: passed" << std::endl
+              << std::endl;
+}
+
+void testAvlSubtreePerson() {
+    BinarySearchTree<Person, compare_person, equal_person, avl_balance> bst;
+    bst.insert(Person(1, "Alice"));
+    bst.insert(Person(2, "Bob"));
+    bst.insert(Person(3, "Charlie"));
+    bst.insert(Person(4, "Diana"));
+    bst.insert(Person(5, "Emma"));
+
+    BinarySearchTree<Person, compare_person, equal_person, avl_balance> subtree = bst.subtree(Person(4, "Diana"));
+
+    std::cout << bst << std::endl;
+    std::cout << subtree << std::endl;
+
+    assert(bst.height() == 3);
+    assert(subtree.size() == 3);
+    assert(subtree.contains(Person(3, "Charlie")));
+    assert(subtree.contains(Person(5, "Emma")));
+    std::cout << "Test testAvlSubtreePerson: passed" << std::endl
+              << std::endl;
+}
+
+void testOrderStatistics() {
+    BinarySearchTree<int, compare_int, equal_int, avl_balance, size_augment> bst;
+    for (int i = 0; i < 100; ++i) {
+        bst.insert(i * 2);
+    }
+
+    assert(bst.size() == 100);
+    assert(bst.rank(0) == 0);
+    assert(bst.rank(7) == 4);
+    assert(bst.rank(1000) == 100);
+    assert(*bst.select(0) == 0);
+    assert(*bst.select(37) == 74);
+    assert(bst.select(100) == bst.end());
+    assert(bst.count_range(10, 20) == 6);
+    assert(bst.count_range(11, 11) == 0);
+    assert(bst.count_range(20, 10) == 0);
+
+    for (int i = 0; i < 50; ++i) {
+        bst.remove(i * 4);
+    }
+    assert(bst.size() == 50);
+    assert(*bst.select(0) == 2);
+    assert(bst.rank(10) == 2);
+    assert(bst.count_range(0, 198) == 50);
+
+    std::cout << "Test testOrderStatistics: passed" << std::endl
+              << std::endl;
+}
+
+void testOrderStatisticsUnbalancedPerson() {
+    BinarySearchTree<Person, compare_person, equal_person, no_balance, size_augment> bst;
+    bst.insert(Person(3, "Charlie"));
+    bst.insert(Person(1, "Alice"));
+    bst.insert(Person(4, "Diana"));
+    bst.insert(Person(2, "Bob"));
+    bst.remove(Person(3, "Charlie"));
+
+    assert(bst.size() == 3);
+    assert(bst.rank(Person(4, "Diana")) == 2);
+    assert(bst.select(1)->name == "Bob");
+    assert(bst.count_range(Person(2, ""), Person(4, "")) == 2);
+
+    BinarySearchTree<Person, compare_person, equal_person, no_balance, size_augment> subtree = bst.subtree(Person(1, "Alice"));
+    assert(subtree.size() == 2);
+    assert(subtree.select(1)->name == "Bob");
+
+    std::cout << "Test testOrderStatisticsUnbalancedPerson: passed" << std::endl
+              << std::endl;
+}
+
+void testPoolAllocator() {
+    typedef BinarySearchTree<int, compare_int, equal_int, avl_balance, no_augment, PoolAllocator<int, 64> > pool_tree;
+    pool_tree bst;
+    for (int i = 0; i < 1000; ++i) {
+        bst.insert(i);
+    }
+    for (int i = 0; i < 1000; i += 3) {
+        bst.remove(i);
+    }
+    assert(bst.size() == 666);
+
+    pool_tree copy(bst);
+    assert(copy.get_allocator() != bst.get_allocator());
+    assert(copy.size() == 666);
+
+    bst.clear();
+    assert(bst.size() == 0);
+    assert(bst.begin() == bst.end());
+    bst.insert(42);
+    assert(bst.size() == 1 && bst.contains(42));
+
+    assert(copy.contains(1) && !copy.contains(3));
+    pool_tree subtree = copy.subtree(*copy.begin());
+    assert(subtree.size() >= 1);
+
+    std::cout << "Test testPoolAllocator: passed" << std::endl
+              << std::endl;
+}
+
+void testPoolAllocatorPerson() {
+    typedef BinarySearchTree<Person, compare_person, equal_person, no_balance, no_augment, PoolAllocator<Person> > pool_tree;
+    PoolAllocator<Person> pool;
+    pool_tree bst(pool);
+    bst.insert(Person(2, "Bob"));
+    bst.insert(Person(1, "Alice"));
+    bst.insert(Person(3, "Charlie"));
+    assert(bst.get_allocator() == pool);
+
+    bst.clear();
+    assert(bst.size() == 0);
+    bst.insert(Person(4, "Diana"));
+
+    pool_tree other;
+    other = bst;
+    assert(other.size() == 1);
+    assert(other.contains(Person(4, "Diana")));
+
+    std::cout << other << std::endl;
+    std::cout << "Test testPoolAllocatorPerson: passed" << std::endl
+              << std::endl;
+}
+
+void testInsertHint() {
+    BinarySearchTree<int, compare_int, equal_int, avl_balance, size_augment> bst;
+    for (int i = 0; i < 100; i += 2) {
+        bst.insert(bst.end(), i);
+    }
+    BinarySearchTree<int, compare_int, equal_int, avl_balance, size_augment>::const_iterator it = bst.select(10);
+    assert(*bst.insert(it, 19) == 19);
+    assert(*bst.insert(it, 50) == 50);
+    assert(*bst.insert(bst.begin(), -1) == -1);
+    assert(*bst.insert(bst.begin(), 7) == 7);
+
+    assert(bst.size() == 53);
+    assert(bst.height() <= 7);
+    assert(*bst.begin() == -1);
+    assert(*bst.rbegin() == 98);
+    assert(bst.rank(19) == 12);
+
+    std::cout << "Test testInsertHint: passed" << std::endl
+              << std::endl;
+}
+
+void testDeepSkewedTree() {
+    const int n = 10000000;
+    BinarySearchTree<int, compare_int, equal_int> bst;
+    for (int i = 0; i < n; ++i) {
+        bst.insert(bst.end(), i);
+    }
+    assert(bst.size() == n);
+    assert(*bst.begin() == 0);
+    assert(*bst.rbegin() == n - 1);
+
+    BinarySearchTree<int, compare_int, equal_int> tail = bst.subtree(n - 100000);
+    assert(tail.size() == 100000);
+    std::ostringstream os;
+    os << tail;
+    assert(os.str().size() == 100000 * 8);
+    tail.remove(n - 100000);
+    tail.remove(n - 1);
+    assert(tail.size() == 99998);
+
+    BinarySearchTree<int, compare_int, equal_int> copy(bst);
+    assert(copy.size() == n);
+    assert(*copy.rbegin() == n - 1);
+    copy.clear();
+
+    std::cout << "Test testDeepSkewedTree: passed" << std::endl
+              << std::endl;
+}
+
+void testFreeze() {
+    for (int n = 0; n <= 70; ++n) {
+        BinarySearchTree<int, compare_int, equal_int> bst;
+        for (int i = 0; i < n; ++i) {
+            bst.insert(bst.end(), i * 2);
+        }
+        FrozenBinarySearchTree<int, compare_int> frozen = bst.freeze();
+
+        assert(frozen.size() == n);
+        assert(std::vector<int>(frozen.begin(), frozen.end()) == std::vector<int>(bst.begin(), bst.end()));
+        for (int v = -1; v <= n * 2; ++v) {
+            assert(frozen.contains(v) == bst.contains(v));
+            FrozenBinarySearchTree<int, compare_int>::const_iterator it = frozen.lower_bound(v);
+            if (v > (n - 1) * 2) {
+                assert(it == frozen.end());
+            } else {
+                assert(*it == (v < 0 ? 0 : (v + 1) / 2 * 2));
+            }
+        }
+        if (n > 0) {
+            FrozenBinarySearchTree<int, compare_int>::const_iterator last = frozen.end();
+            --last;
+            assert(*last == (n - 1) * 2);
+        }
+    }
+
+    std::cout << "Test testFreeze: passed" << std::endl
+              << std::endl;
+}
+
+void testFreezePerson() {
+    BinarySearchTree<Person, compare_person, equal_person> bst;
+    bst.insert(Person(3, "Charlie"));
+    bst.insert(Person(1, "Alice"));
+    bst.insert(Person(2, "Bob"));
+
+    FrozenBinarySearchTree<Person, compare_person> frozen = bst.freeze();
+    bst.clear();
+
+    assert(frozen.size() == 3);
+    assert(frozen.contains(Person(2, "")));
+    assert(!frozen.contains(Person(4, "")));
+    assert(frozen.lower_bound(Person(2, ""))->name == "Bob");
+    assert(frozen.begin()->name == "Alice");
+
+    std::cout << "Test testFreezePerson: passed" << std::endl
+              << std::endl;
+}
+
+void testRangeQueries() {
+    BinarySearchTree<int, compare_int, equal_int, avl_balance> bst;
+    for (int i = 0; i < 100; ++i) {
+        bst.insert(i * 10);
+    }
+
+    assert(*bst.lower_bound(35) == 40 && *bst.lower_bound(40) == 40);
+    assert(*bst.upper_bound(40) == 50 && *bst.upper_bound(-5) == 0);
+    assert(bst.lower_bound(991) == bst.end() && bst.upper_bound(990) == bst.end());
+    assert(*bst.find(70) == 70 && bst.find(75) == bst.end());
+
+    std::pair<BinarySearchTree<int, compare_int, equal_int, avl_balance>::const_iterator,
+              BinarySearchTree<int, compare_int, equal_int, avl_balance>::const_iterator>
+        eq = bst.equal_range(70);
+    assert(*eq.first == 70 && *eq.second == 80);
+    eq = bst.equal_range(75);
+    assert(eq.first == eq.second && *eq.first == 80);
+
+    std::vector<int> values;
+    BinarySearchTree<int, compare_int, equal_int, avl_balance>::const_range r = bst.range(25, 70);
+    for (BinarySearchTree<int, compare_int, equal_int, avl_balance>::const_iterator it = r.begin(); it != r.end(); ++it) {
+        values.push_back(*it);
+    }
+    int expected[] = {30, 40, 50, 60, 70};
+    assert(values == std::vector<int>(expected, expected + 5));
+    assert(bst.range(71, 79).empty() && bst.range(70, 10).empty());
+    assert(std::vector<int>(bst.range(-100, 5000).begin(), bst.range(-100, 5000).end()) ==
+           std::vector<int>(bst.begin(), bst.end()));
+
+    std::cout << "Test testRangeQueries: passed" << std::endl
+              << std::endl;
+}
+
+void testRangeQueriesPerson() {
+    BinarySearchTree<Person, compare_person, equal_person> bst;
+    bst.insert(Person(5, "Eve"));
+    bst.insert(Person(2, "Bob"));
+    bst.insert(Person(8, "Heidi"));
+    bst.insert(Person(1, "Alice"));
+
+    assert(bst.find(Person(8, ""))->name == "Heidi");
+    assert(bst.lower_bound(Person(3, ""))->name == "Eve");
+    std::string names;
+    BinarySearchTree<Person, compare_person, equal_person>::const_range r = bst.range(Person(2, ""), Person(7, ""));
+    for (BinarySearchTree<Person, compare_person, equal_person>::const_iterator it = r.begin(); it != r.end(); ++it) {
+        names += it->name;
+    }
+    assert(names == "BobEve");
+
+    std::cout << "Test testRangeQueriesPerson: passed" << std::endl
+              << std::endl;
+}
+
+/**
+ * @brief Verifica le visite parallele su un albero confrontandole con quelle seriali.
+ */
+template <typename Tree>
+void checkParallelScan(const Tree &bst) {
+    is_even ie;
+    std::vector<int> expected;
+    for (typename Tree::const_iterator it = bst.begin(); it != bst.end(); ++it) {
+        if (ie(*it)) {
+            expected.push_back(*it);
+        }
+    }
+    std::vector<typename Tree::const_iterator> points = bst.partition_points(7);
+    assert(points.front() == bst.begin() && points.back() == bst.end() && points.size() <= 8);
+
+    for (unsigned threads = 1; threads <= 4; ++threads) {
+        assert(parallel_count_if(bst, ie, threads) == static_cast<long long>(expected.size()));
+        assert(parallel_copy_if(bst, ie, threads) == expected);
+
+        std::atomic<long long> sum(0);
+        parallel_for_each_if(bst, ie, [&sum](int v) { sum += v; }, threads);
+        long long serialSum = 0;
+        for (std::size_t i = 0; i < expected.size(); ++i) {
+            serialSum += expected[i];
+        }
+        assert(sum.load() == serialSum);
+
+        std::ostringstream serial, parallel;
+        std::streambuf *old = std::cout.rdbuf(serial.rdbuf());
+        printIF(bst, ie);
+        std::cout.rdbuf(parallel.rdbuf());
+        parallel_printIF(bst, ie, threads);
+        std::cout.rdbuf(old);
+        assert(serial.str() == parallel.str());
+
+        // con larghezza e formato non predefinito la larghezza vale solo per il primo valore stampato
+        auto format = [](std::ostream &out) -> std::ostream & {
+            return out << std::hex << std::showbase << std::uppercase << std::setfill('*') << std::setw(12);
+        };
+        std::ostringstream sequential, parallelAll;
+        format(sequential) << bst;
+        parallel_dump(bst, format(parallelAll), threads);
+        assert(sequential.str() == parallelAll.str() && parallelAll.width() == 0);
+
+        // il primo valore stampato cade in un segmento successivo al primo
+        int middle = expected.empty() ? 0 : expected[expected.size() / 2];
+        auto upper = [middle](int v) { return v > middle; };
+        std::ostringstream serialUpper, parallelUpper;
+        std::ios saved(nullptr);
+        saved.copyfmt(std::cout);
+        old = std::cout.rdbuf(serialUpper.rdbuf());
+        format(std::cout);
+        printIF(bst, upper);
+        std::cout.rdbuf(parallelUpper.rdbuf());
+        format(std::cout);
+        parallel_printIF(bst, upper, threads);
+        std::cout.rdbuf(old);
+        std::cout.copyfmt(saved);
+        std::ostringstream reference;
+        bst.dump(format(reference), bst.upper_bound(middle), bst.end());
+        assert(serialUpper.str() == reference.str() && parallelUpper.str() == reference.str());
+    }
+}
+
+void testParallelScan() {
+    BinarySearchTree<int, compare_int, equal_int, avl_balance, size_augment> balanced;
+    BinarySearchTree<int, compare_int, equal_int> skewed;
+    unsigned seed = 42;
+    for (int i = 0; i < 20000; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        balanced.insert(static_cast<int>(seed >> 8));
+        skewed.insert(skewed.end(), i);
+    }
+    checkParallelScan(balanced);
+    checkParallelScan(skewed);
+    checkParallelScan(BinarySearchTree<int, compare_int, equal_int>());
+
+    bool thrown = false;
+    try {
+        parallel_for_each_if(balanced, is_even(), [](int v) {
+            if (v % 3 == 0) {
+                throw std::runtime_error("visitor");
+            }
+        }, 3);
+    } catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    assert(thrown);
+
+    std::cout << "Test testParallelScan: passed" << std::endl
+              << std::endl;
+}
+
+/**
+ * @brief Verifica unione, intersezione, differenza e merge confrontandole con gli algoritmi di std.
+ */
+template <typename Tree>
+void checkSetAlgebra(int na, int nb, unsigned threads) {
+    std::set<int> a, b;
+    unsigned seed = static_cast<unsigned>(na * 31 + nb);
+    for (int i = 0; i < na; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        a.insert(static_cast<int>((seed >> 8) % 50000));
+    }
+    for (int i = 0; i < nb; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        b.insert(static_cast<int>((seed >> 8) % 50000));
+    }
+    std::vector<int> va(a.begin(), a.end()), vb(b.begin(), b.end());
+    std::vector<int> expected;
+
+    Tree tree(va.begin(), va.end());
+    tree.set_union(Tree(vb.begin(), vb.end()), threads);
+    std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expected));
+    assert(std::vector<int>(tree.begin(), tree.end()) == expected);
+    assert(tree.size() == static_cast<int>(expected.size()));
+    assert(std::vector<int>(tree.rbegin(), tree.rend()) == std::vector<int>(expected.rbegin(), expected.rend()));
+
+    expected.clear();
+    tree = Tree(va.begin(), va.end());
+    tree.set_intersection(Tree(vb.begin(), vb.end()), threads);
+    std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expected));
+    assert(std::vector<int>(tree.begin(), tree.end()) == expected);
+    assert(tree.size() == static_cast<int>(expected.size()));
+
+    expected.clear();
+    tree = Tree(va.begin(), va.end());
+    tree.set_difference(Tree(vb.begin(), vb.end()), threads);
+    std::set_difference(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expected));
+    assert(std::vector<int>(tree.begin(), tree.end()) == expected);
+    assert(tree.size() == static_cast<int>(expected.size()));
+
+    expected.clear();
+    tree = Tree(va.begin(), va.end());
+    Tree other(vb.begin(), vb.end());
+    tree.merge(other, threads);
+    std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expected));
+    assert(std::vector<int>(other.begin(), other.end()) == expected);
+    assert(other.size() == static_cast<int>(expected.size()));
+    assert(tree.size() + other.size() == static_cast<int>(a.size() + b.size()));
+    for (std::set<int>::const_iterator it = b.begin(); it != b.end(); ++it) {
+        assert(tree.contains(*it));
+    }
+}
+
+void testSetAlgebra() {
+    typedef BinarySearchTree<int, compare_int, equal_int, avl_balance, size_augment> AvlTree;
+    typedef BinarySearchTree<int, compare_int, equal_int> PlainTree;
+    int sizes[][2] = {{0, 0}, {0, 100}, {100, 0}, {1, 20000}, {20000, 30}, {5000, 5000}, {30000, 20000}};
+    for (int i = 0; i < 7; ++i) {
+        checkSetAlgebra<AvlTree>(sizes[i][0], sizes[i][1], 1);
+        checkSetAlgebra<AvlTree>(sizes[i][0], sizes[i][1], 4);
+        checkSetAlgebra<PlainTree>(sizes[i][0], sizes[i][1], 1);
+    }
+
+    // l'albero risultante resta AVL e le dimensioni dei sottoalberi sono corrette
+    AvlTree big, delta;
+    for (int i = 0; i < 100000; ++i) {
+        big.insert(big.end(), i * 2);
+    }
+    for (int i = 0; i < 1000; ++i) {
+        delta.insert(i * 200 + 1);
+    }
+    big.set_union(std::move(delta));
+    assert(big.size() == 101000 && delta.size() == 0);
+    assert(big.height() <= 25);
+    assert(*big.select(3) == 4 && big.rank(201) == 102 && big.count_range(0, 401) == 204);
+
+    std::cout << "Test testSetAlgebra: passed" << std::endl
+              << std::endl;
+}
+
+void testSetAlgebraPerson() {
+    BinarySearchTree<Person, compare_person, equal_person, avl_balance> a, b;
+    a.insert(Person(1, "Alice"));
+    a.insert(Person(2, "Bob"));
+    b.insert(Person(2, "Robert"));
+    b.insert(Person(3, "Charlie"));
+
+    BinarySearchTree<Person, compare_person, equal_person, avl_balance> u(a);
+    u.set_union(b);
+    assert(u.size() == 3 && b.size() == 2);
+    assert(u.find(Person(2, ""))->name == "Bob" && u.find(Person(3, ""))->name == "Charlie");
+
+    BinarySearchTree<Person, compare_person, equal_person, avl_balance> i(b);
+    i.set_intersection(a);
+    assert(i.size() == 1 && i.begin()->name == "Robert");
+
+    a.merge(b);
+    assert(a.size() == 3 && b.size() == 1 && b.begin()->name == "Robert");
+
+    std::cout << "Test testSetAlgebraPerson: passed" << std::endl
+              << std::endl;
+}
+
+/**
+ * @brief Verifica split e join su un albero con i valori 0, 2, ..., 2 * (n - 1).
+ */
+template <typename Tree>
+void checkSplitJoin(Tree tree, int n) {
+    int keys[] = {-1, 0, 1, n / 2, n / 2 * 2, n * 2 - 2, n * 2};
+    for (int k = 0; k < 7; ++k) {
+        std::pair<Tree, Tree> parts = tree.split(keys[k]);
+        assert(tree.size() == 0 && tree.begin() == tree.end());
+        int below = keys[k] <= 0 ? 0 : std::min(n, (keys[k] + 1) / 2);
+        assert(parts.first.size() == below && parts.second.size() == n - below);
+        if (below > 0) {
+            assert(*parts.first.begin() == 0 && *parts.first.rbegin() == (below - 1) * 2);
+        }
+        if (below < n) {
+            assert(*parts.second.begin() == below * 2 && *parts.second.rbegin() == (n - 1) * 2);
+            assert(parts.second.contains(below * 2) && !parts.first.contains(below * 2));
+        }
+        tree = Tree::join(std::move(parts.first), std::move(parts.second));
+        assert(tree.size() == n);
+    }
+    std::vector<int> values(tree.begin(), tree.end());
+    for (int i = 0; i < n; ++i) {
+        assert(values[i] == i * 2);
+    }
+
+    std::pair<Tree, Tree> parts = tree.split(n);
+    bool thrown = false;
+    try {
+        Tree::join(parts.second, parts.first);
+    } catch (const std::invalid_argument &) {
+        thrown = true;
+    }
+    assert(thrown == (n > 0 && parts.first.size() > 0 && parts.second.size() > 0));
+}
+
+void testSplitJoin() {
+    typedef BinarySearchTree<int, compare_int, equal_int, avl_balance, size_augment> AvlTree;
+    typedef BinarySearchTree<int, compare_int, equal_int> PlainTree;
+    for (int n = 0; n <= 40; n += 5) {
+        AvlTree avl;
+        PlainTree plain;
+        for (int i = 0; i < n; ++i) {
+            avl.insert((i * 11 % n) * 2);
+            plain.insert((i * 11 % n) * 2);
+        }
+        checkSplitJoin(avl, n);
+        checkSplitJoin(plain, n);
+    }
+
+    // i due alberi restano AVL e le dimensioni dei sottoalberi restano corrette
+    AvlTree avl;
+    for (int i = 0; i < 100000; ++i) {
+        avl.insert(avl.end(), i);
+    }
+    std::pair<AvlTree, AvlTree> halves = avl.split(30000);
+    assert(halves.first.height() <= 24 && halves.second.height() <= 24);
+    assert(halves.first.rank(29999) == 29999 && *halves.second.select(5) == 30005);
+    halves.first.insert(-1);
+    halves.second.remove(30000);
+    AvlTree joined = AvlTree::join(std::move(halves.first), std::move(halves.second));
+    assert(joined.size() == 100000 && joined.height() <= 24 && *joined.select(30001) == 30001);
+
+    // senza bilanciamento split e join non usano ricorsione
+    PlainTree deep;
+    for (int i = 0; i < 200000; ++i) {
+        deep.insert(deep.end(), i);
+    }
+    std::pair<PlainTree, PlainTree> cut = deep.split(150000);
+    // size() è una lettura pura anche dopo split: più thread possono chiamarla sullo stesso albero
+    const PlainTree &shared = cut.first;
+    std::atomic<int> wrong(0);
+    std::thread other([&shared, &wrong]() { wrong += shared.size() != 150000; });
+    wrong += shared.size() != 150000;
+    other.join();
+    assert(wrong.load() == 0);
+    assert(cut.first.size() == 150000 && cut.second.size() == 50000);
+    cut.first.insert(200000);
+    assert(cut.first.size() == 150001);
+    cut.first.remove(200000);
+    PlainTree whole = PlainTree::join(std::move(cut.first), std::move(cut.second));
+    assert(whole.size() == 200000 && *whole.rbegin() == 199999);
+
+    std::cout << "Test testSplitJoin: passed" << std::endl
+              << std::endl;
+}
+
+void testSplitJoinPerson() {
+    BinarySearchTree<Person, compare_person, equal_person, avl_balance> people;
+    people.insert(Person(1, "Alice"));
+    people.insert(Person(2, "Bob"));
+    people.insert(Person(3, "Charlie"));
+
+    std::pair<BinarySearchTree<Person, compare_person, equal_person, avl_balance>,
+              BinarySearchTree<Person, compare_person, equal_person, avl_balance> >
+        parts = people.split(Person(2, ""));
+    assert(parts.first.size() == 1 && parts.first.begin()->name == "Alice");
+    assert(parts.second.size() == 2 && parts.second.begin()->name == "Bob");
+
+    people = BinarySearchTree<Person, compare_person, equal_person, avl_balance>::join(parts.first, parts.second);
+    assert(people.size() == 3 && people.find(Person(3, ""))->name == "Charlie");
+
+    std::cout << "Test testSplitJoinPerson: passed" << std::endl
+              << std::endl;
+}
+
+/**
+ * @brief Confronta contains_batch e find_batch con contains e find.
+ */
+template <typename Tree>
+void checkBatchLookup() {
+    Tree tree;
+    for (int i = 0; i < 1000; ++i) {
+        tree.insert(i * 37 % 1000 * 3);
+    }
+    std::vector<int> keys;
+    for (int i = -5; i < 3005; ++i) {
+        keys.push_back(i * 7 % 3005);
+    }
+    std::vector<bool> present;
+    tree.contains_batch(keys.begin(), keys.end(), std::back_inserter(present));
+    std::vector<typename Tree::const_iterator> found(keys.size());
+    assert(tree.find_batch(keys.begin(), keys.end(), found.begin()) == found.end());
+    assert(present.size() == keys.size());
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        assert(present[i] == tree.contains(keys[i]));
+        assert(found[i] == tree.find(keys[i]));
+    }
+
+    bool none[1];
+    assert(tree.contains_batch(keys.begin(), keys.begin(), none) == none);
+    Tree empty;
+    empty.contains_batch(keys.begin(), keys.begin() + 20, present.begin());
+    assert(std::count(present.begin(), present.begin() + 20, true) == 0);
+}
+
+void testBatchLookup() {
+    checkBatchLookup<BinarySearchTree<int, compare_int, equal_int> >();
+    checkBatchLookup<BinarySearchTree<int, compare_int, equal_int, avl_balance, size_augment> >();
+    checkBatchLookup<BinarySearchTree<int, compare_int, compare_equivalence, avl_balance> >();
+    checkBatchLookup<BinarySearchTree<int, compare_int_three_way, compare_equivalence> >();
+
+    BinarySearchTree<Person, compare_person, equal_person> people;
+    people.insert(Person(1, "Alice"));
+    people.insert(Person(2, "Bob"));
+    std::vector<Person> wanted;
+    wanted.push_back(Person(2, "Bob"));
+    wanted.push_back(Person(3, "Charlie"));
+    std::vector<BinarySearchTree<Person, compare_person, equal_person>::const_iterator> found;
+    people.find_batch(wanted.begin(), wanted.end(), std::back_inserter(found));
+    assert(found.size() == 2 && found[0]->name == "Bob" && found[1] == people.end());
+
+    std::cout << "Test testBatchLookup: passed" << std::endl
+              << std::endl;
+}
+
+/**
+ * @brief Confronta insert_batch ed erase_batch con un std::set.
+ */
+template <typename Tree>
+void checkBatchUpdate() {
+    Tree tree;
+    std::set<int> expected;
+    for (int i = 0; i < 2000; i += 3) {
+        tree.insert(i);
+        expected.insert(i);
+    }
+
+    std::vector<int> sorted;
+    for (int i = -10; i < 2100; i += 2) {
+        sorted.push_back(i);
+    }
+    int before = tree.size();
+    int inserted = tree.insert_batch(sorted.begin(), sorted.end());
+    expected.insert(sorted.begin(), sorted.end());
+    assert(tree.size() == static_cast<int>(expected.size()) && inserted == tree.size() - before);
+    assert(std::equal(tree.begin(), tree.end(), expected.begin()));
+
+    // sequenza ordinata con duplicati e sequenza non ordinata
+    std::vector<int> repeated;
+    for (int i = 2100; i < 2200; ++i) {
+        repeated.push_back(i / 2 * 2 + 1);
+    }
+    assert(tree.insert_batch(repeated.begin(), repeated.end()) == 50);
+    std::vector<int> shuffled;
+    for (int i = 0; i < 500; ++i) {
+        shuffled.push_back(i * 263 % 500 + 2500);
+    }
+    assert(tree.insert_batch(shuffled.begin(), shuffled.end()) == 500);
+    expected.insert(repeated.begin(), repeated.end());
+    expected.insert(shuffled.begin(), shuffled.end());
+    assert(std::equal(tree.begin(), tree.end(), expected.begin()));
+
+    std::vector<int> erased;
+    for (int i = -20; i < 3100; i += 5) {
+        erased.push_back(i);
+    }
+    int removed = tree.erase_batch(erased.begin(), erased.end());
+    int expectedRemoved = 0;
+    for (std::size_t i = 0; i < erased.size(); ++i) {
+        expectedRemoved += static_cast<int>(expected.erase(erased[i]));
+    }
+    assert(removed == expectedRemoved);
+    assert(tree.erase_batch(shuffled.rbegin(), shuffled.rend()) == 400);
+    for (std::size_t i = 0; i < shuffled.size(); ++i) {
+        expected.erase(shuffled[i]);
+    }
+    assert(tree.size() == static_cast<int>(expected.size()));
+    assert(std::equal(tree.begin(), tree.end(), expected.begin()));
+    assert(*tree.begin() == *expected.begin() && *tree.rbegin() == *expected.rbegin());
+
+    std::istringstream input("7 1 4 1");
+    assert(tree.erase_batch(std::istream_iterator<int>(input), std::istream_iterator<int>()) ==
+           static_cast<int>(expected.count(7) + expected.count(1) + expected.count(4)));
+    expected.erase(7);
+    expected.erase(1);
+    expected.erase(4);
+    assert(tree.erase_batch(erased.begin(), erased.end()) == 0);
+    assert(tree.insert_batch(sorted.begin(), sorted.begin()) == 0);
+    std::vector<int> rest(expected.begin(), expected.end());
+    assert(tree.erase_batch(rest.begin(), rest.end()) == static_cast<int>(rest.size()));
+    assert(tree.size() == 0 && tree.begin() == tree.end());
+}
+
+void testBatchUpdate() {
+    checkBatchUpdate<BinarySearchTree<int, compare_int, equal_int> >();
+    checkBatchUpdate<BinarySearchTree<int, compare_int, equal_int, no_balance, size_augment> >();
+    checkBatchUpdate<BinarySearchTree<int, compare_int, equal_int, avl_balance> >();
+    checkBatchUpdate<BinarySearchTree<int, compare_int, equal_int, avl_balance, size_augment, PoolAllocator<int> > >();
+
+    // l'unione di una sequenza ordinata mantiene l'albero AVL e le dimensioni
+    BinarySearchTree<int, compare_int, equal_int, avl_balance, size_augment> avl;
+    std::vector<int> values;
+    for (int i = 0; i < 100000; ++i) {
+        values.push_back(i * 2);
+    }
+    avl.insert_batch(values.begin(), values.begin() + 10);
+    avl.insert_batch(values.begin() + 10, values.end());
+    assert(avl.size() == 100000 && avl.height() <= 24 && avl.rank(1001) == 501);
+    avl.erase_batch(values.begin(), values.begin() + 50000);
+    assert(avl.size() == 50000 && avl.height() <= 24 && *avl.select(0) == 100000);
+
+    std::vector<Person> people;
+    people.push_back(Person(1, "Alice"));
+    people.push_back(Person(2, "Bob"));
+    BinarySearchTree<Person, compare_person, equal_person, avl_balance> persons;
+    assert(persons.insert_batch(people.begin(), people.end()) == 2);
+    assert(persons.erase_batch(people.begin(), people.begin() + 1) == 1);
+    assert(persons.size() == 1 && persons.begin()->name == "Bob");
+
+    std::cout << "Test testBatchUpdate: passed" << std::endl
+              << std::endl;
+}
+
+/**
+ * @brief Verifica erase, extract e il reinserimento dei nodi estratti.
+ */
+template <typename Tree>
+void checkNodeHandles() {
+    Tree tree;
+    tree.insert(50);
+    for (int i = 0; i < 100; ++i) {
+        tree.insert(i * 37 % 100);
+    }
+
+    // con due figli il successore viene ricollegato, non copiato
+    typename Tree::const_iterator middle = tree.find(50);
+    typename Tree::const_iterator next = tree.find(51);
+    const int *address = &*next;
+    assert(tree.erase(middle) == next && &*next == address && *next == 51);
+    assert(tree.size() == 99 && !tree.contains(50));
+
+    typename Tree::const_iterator last = tree.find(99);
+    assert(tree.erase(last) == tree.end() && *tree.rbegin() == 98);
+    assert(tree.erase(tree.begin()) == tree.find(1) && *tree.begin() == 1);
+
+    typename Tree::node_type handle = tree.extract(40);
+    assert(!handle.empty() && handle && handle.value() == 40 && tree.size() == 96);
+    assert(tree.extract(40).empty() && tree.extract(1000).empty());
+    const int *moved = &handle.value();
+    handle.value() = 150;
+    typename Tree::insert_return_type result = tree.insert(std::move(handle));
+    assert(result.inserted && result.node.empty() && handle.empty());
+    assert(*result.position == 150 && &*result.position == moved && *tree.rbegin() == 150);
+
+    typename Tree::node_type duplicate = tree.extract(tree.find(20));
+    tree.insert(20);
+    result = tree.insert(std::move(duplicate));
+    assert(!result.inserted && *result.position == 20 && result.node.value() == 20);
+    assert(tree.size() == 97);
+
+    typename Tree::insert_return_type none = tree.insert(typename Tree::node_type());
+    assert(!none.inserted && none.position == tree.end() && none.node.empty());
+
+    std::vector<int> values(tree.begin(), tree.end());
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        assert(i == 0 || values[i - 1] < values[i]);
+    }
+    while (tree.size() > 0) {
+        tree.erase(tree.find(values[values.size() / 2]));
+        values.erase(values.begin() + values.size() / 2);
+        assert(std::equal(tree.begin(), tree.end(), values.begin()));
+    }
+    assert(tree.begin() == tree.end());
+}
+
+void testNodeHandles() {
+    checkNodeHandles<BinarySearchTree<int, compare_int, equal_int> >();
+    checkNodeHandles<BinarySearchTree<int, compare_int, equal_int, avl_balance, size_augment> >();
+    checkNodeHandles<BinarySearchTree<int, compare_int, equal_int, avl_balance, no_augment, PoolAllocator<int> > >();
+
+    // con allocatori diversi il valore viene spostato in un nuovo nodo
+    typedef BinarySearchTree<Person, compare_person, equal_person, avl_balance, size_augment, PoolAllocator<Person> > pool_tree;
+    pool_tree first, second;
+    first.insert(Person(1, "Alice"));
+    first.insert(Person(2, "Bob"));
+    pool_tree::node_type bob = first.extract(Person(2, ""));
+    bob.value().name = "Roberto";
+    pool_tree::insert_return_type result = second.insert(std::move(bob));
+    assert(result.inserted && result.position->name == "Roberto" && bob.empty());
+    assert(first.size() == 1 && second.size() == 1 && second.rank(Person(2, "")) == 0);
+
+    pool_tree::node_type alice = first.extract(first.begin()), other;
+    alice.swap(other);
+    assert(alice.empty() && other.value().name == "Alice" && first.size() == 0);
+
+    std::cout << "Test testNodeHandles: passed" << std::endl
+              << std::endl;
+}
+
+void testCompactBinarySearchTree() {
+    typedef CompactBinarySearchTree<int, compare_int, equal_int> compact_tree;
+    compact_tree tree;
+    std::set<int> expected;
+    unsigned seed = 12345;
+    for (int i = 0; i < 20000; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        int value = static_cast<int>((seed >> 8) % 3000);
+        if ((seed >> 4) % 3 != 0) {
+            assert(tree.insert(value) == expected.insert(value).second);
+        } else {
+            assert(tree.remove(value) == (expected.erase(value) == 1));
+        }
+        if (i % 5000 == 4999) {
+            tree.compact(i % 10000 == 4999 ? compact_in_order : compact_breadth_first);
+            assert(tree.capacity() >= static_cast<std::size_t>(tree.size()));
+        }
+    }
+    assert(tree.size() == static_cast<int>(expected.size()));
+    assert(std::equal(tree.begin(), tree.end(), expected.begin()));
+
+    int levels = 0;
+    for (int n = tree.size(); n > 0; n /= 2) {
+        ++levels;
+    }
+    assert(tree.height() <= levels * 3 / 2 + 1);
+
+    for (int value = -1; value <= 3001; value += 7) {
+        assert(tree.contains(value) == (expected.count(value) == 1));
+        compact_tree::const_iterator it = tree.lower_bound(value);
+        std::set<int>::const_iterator bound = expected.lower_bound(value);
+        assert(bound == expected.end() ? it == tree.end() : *it == *bound);
+        if (bound != expected.end() && ++bound != expected.end()) {
+            assert(*++it == *bound);
+        }
+        assert(tree.find(value) == (expected.count(value) == 1 ? tree.lower_bound(value) : tree.end()));
+    }
+
+    // dopo compact() in ordine crescente i nodi sono contigui e gli slot liberi spariscono
+    compact_tree copy(tree);
+    for (int value = 0; value < 3000; value += 2) {
+        copy.remove(value);
+    }
+    copy.compact();
+    for (int value = 1; value < 3000; value += 2) {
+        assert(copy.contains(value) == (expected.count(value) == 1));
+    }
+    compact_tree moved(std::move(copy));
+    assert(copy.size() == 0 && copy.begin() == copy.end() && !moved.empty());
+    copy = moved;
+    assert(std::equal(copy.begin(), copy.end(), moved.begin()) && copy.size() == moved.size());
+    copy.clear();
+    assert(copy.empty() && !copy.contains(1) && copy.insert(1) && copy.size() == 1);
+
+    std::vector<int> sorted(expected.begin(), expected.end());
+    compact_tree built(sorted.begin(), sorted.end());
+    assert(built.size() == tree.size() && built.height() <= levels + 1);
+    std::ostringstream a, b;
+    a << built;
+    b << tree;
+    assert(a.str() == b.str());
+
+    CompactBinarySearchTree<Person, compare_person, equal_person> people;
+    people.insert(Person(2, "Bob"));
+    people.insert(Person(1, "Alice"));
+    people.insert(Person(3, "Charlie"));
+    assert(people.remove(Person(2, "")) && !people.remove(Person(2, "")));
+    people.insert(Person(4, "Dave"));
+    people.compact(compact_breadth_first);
+    assert(people.size() == 3 && people.begin()->name == "Alice" && people.find(Person(4, ""))->name == "Dave");
+
+    std::cout << "Test testCompactBinarySearchTree: passed" << std::endl
+              << std::endl;
+}
+
+/**
+ * @brief Verifica che open_mmap fallisca con std::runtime_error.
+ */
+template <typename Tree>
+bool openFails(const std::string &path) {
+    try {
+        Tree::open_mmap(path);
+    } catch (const std::runtime_error &) {
+        return true;
+    }
+    return false;
+}
+
+void testMappedFile() {
+    typedef BinarySearchTree<int, compare_int, equal_int, avl_balance> int_tree;
+    const std::string path = "test_mapped_tree.bin";
+    int_tree bst;
+    for (int i = 0; i < 5000; ++i) {
+        bst.insert(i * 7919 % 5000 * 2);
+    }
+    bst.save(path);
+
+    FrozenBinarySearchTree<int, compare_int> mapped = int_tree::open_mmap(path);
+    assert(mapped.size() == bst.size());
+    assert(std::equal(mapped.begin(), mapped.end(), bst.begin()));
+    for (int v = -3; v < 10003; v += 3) {
+        assert(mapped.contains(v) == bst.contains(v));
+        FrozenBinarySearchTree<int, compare_int>::const_iterator lower = mapped.lower_bound(v);
+        FrozenBinarySearchTree<int, compare_int>::const_iterator upper = mapped.upper_bound(v);
+        assert(lower == mapped.end() ? bst.lower_bound(v) == bst.end() : *lower == *bst.lower_bound(v));
+        assert(upper == mapped.end() ? bst.upper_bound(v) == bst.end() : *upper == *bst.upper_bound(v));
+    }
+
+    // la copia condivide la mappatura, che resta valida dopo la distruzione dell'originale
+    FrozenBinarySearchTree<int, compare_int> copy = mapped;
+    mapped = FrozenBinarySearchTree<int, compare_int>();
+    assert(mapped.size() == 0 && mapped.begin() == mapped.end() && !mapped.contains(0));
+    assert(copy.contains(9998) && !copy.contains(9999) && *--copy.end() == 9998);
+
+    int_tree().save(path);
+    assert(int_tree::open_mmap(path).size() == 0);
+
+    typedef BinarySearchTree<long long, std::less<long long>, std::equal_to<long long> > long_tree;
+    assert(openFails<long_tree>(path));
+    assert(openFails<int_tree>("missing_mapped_tree.bin"));
+    {
+        std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+        out << "not a tree";
+    }
+    assert(openFails<int_tree>(path));
+    bst.save(path);
+    {
+        std::ofstream out(path.c_str(), std::ios::binary | std::ios::app);
+        out << 'x';
+    }
+    assert(openFails<int_tree>(path));
+    std::remove(path.c_str());
+
+    std::cout << "Test testMappedFile: passed" << std::endl
+              << std::endl;
+}
+
+/**
+ * @brief Codec binario di Person per serialize e deserialize.
+ *
+ * Scrive l'ID come varint con segno a zigzag e il nome come lunghezza e caratteri.
+ */
+template <>
+struct bst_codec<Person> {
+    /**
+     * @brief Codifica una persona.
+     *
+     * @param p Persona da codificare.
+     * @param out Stringa a cui aggiungere i byte.
+     */
+    void encode(const Person &p, std::string &out) {
+        std::uint64_t id = static_cast<std::uint32_t>(p.id);
+        bst_varint::put((id << 1) ^ (p.id < 0 ? 0xFFFFFFFFFFFFFFFFULL : 0), out);
+        names.encode(p.name, out);
+    }
+
+    /**
+     * @brief Decodifica una persona.
+     *
+     * @param pos Posizione di lettura, viene avanzata.
+     * @param end Fine dei byte disponibili.
+     * @return La persona letta.
+     */
+    Person decode(const char *&pos, const char *end) {
+        std::uint64_t z = bst_varint::get(pos, end);
+        int id = static_cast<int>(static_cast<std::int64_t>((z >> 1) ^ (0 - (z & 1))));
+        return Person(id, names.decode(pos, end));
+    }
+
+private:
+    bst_codec<std::string> names; ///< Codec dei nomi
+};
+
+/**
+ * @brief Verifica che deserialize rifiuti un flusso lasciando l'albero invariato.
+ *
+ * @param bytes Contenuto del flusso.
+ * @return true se deserialize lancia std::runtime_error.
+ */
+template <typename Tree>
+bool deserializeFails(const std::string &bytes) {
+    Tree tree;
+    tree.insert(42);
+    std::istringstream in(bytes);
+    try {
+        tree.deserialize(in);
+    } catch (const std::runtime_error &) {
+        return tree.size() == 1 && tree.contains(42);
+    }
+    return false;
+}
+
+/**
+ * @brief Serializza un albero e lo rilegge in un albero di tipo Target.
+ */
+template <typename Target, typename Tree>
+Target roundTrip(const Tree &tree) {
+    std::ostringstream out;
+    tree.serialize(out);
+    Target copy;
+    std::istringstream in(out.str());
+    copy.deserialize(in);
+    return copy;
+}
+
+void testSerialize() {
+    typedef BinarySearchTree<int, compare_int, equal_int, avl_balance> int_tree;
+    typedef BinarySearchTree<int, compare_int, equal_int> plain_tree;
+    int_tree bst;
+    for (int i = 0; i < 50000; ++i) {
+        bst.insert((i * 7919 % 50000 - 25000) * 3);
+    }
+    plain_tree plain = roundTrip<plain_tree>(bst);
+    assert(plain.size() == bst.size());
+    assert(std::equal(plain.begin(), plain.end(), bst.begin()));
+    // la ricostruzione da valori ordinati produce un albero bilanciato anche senza AVL
+    assert(plain.height() == 16);
+    int_tree avl = roundTrip<int_tree>(plain);
+    assert(std::equal(avl.begin(), avl.end(), bst.begin()));
+    avl.insert(1);
+    avl.remove(-75000);
+    assert(avl.contains(1) && !avl.contains(-75000) && avl.size() == 50000);
+
+    assert(roundTrip<int_tree>(int_tree()).size() == 0);
+    int_tree extremes;
+    extremes.insert(std::numeric_limits<int>::min());
+    extremes.insert(std::numeric_limits<int>::max());
+    extremes.insert(0);
+    int_tree extremesCopy = roundTrip<int_tree>(extremes);
+    assert(std::equal(extremesCopy.begin(), extremesCopy.end(), extremes.begin()) && extremesCopy.size() == 3);
+
+    // con la codifica delta degli interi il formato binario è più compatto del testo
+    std::ostringstream binary, text;
+    bst.serialize(binary);
+    for (int_tree::const_iterator it = bst.begin(); it != bst.end(); ++it) {
+        text << *it << ' ';
+    }
+    assert(binary.str().size() * 2 < text.str().size());
+
+    typedef BinarySearchTree<std::string, std::less<std::string>, std::equal_to<std::string> > string_tree;
+    string_tree words;
+    for (int i = 0; i < 3000; ++i) {
+        words.insert(std::string(i % 7, 'x') + std::to_string(i));
+    }
+    string_tree wordsCopy = roundTrip<string_tree>(words);
+    assert(wordsCopy.size() == words.size() && std::equal(wordsCopy.begin(), wordsCopy.end(), words.begin()));
+
+    // il criterio di ordinamento del flusso deve essere quello dell'albero
+    std::ostringstream descending;
+    typedef BinarySearchTree<int, std::greater<int>, std::equal_to<int> > reversed_tree;
+    reversed_tree reversed;
+    reversed.insert(1);
+    reversed.insert(2);
+    reversed.serialize(descending);
+    assert(!deserializeFails<reversed_tree>(descending.str()));
+    assert(deserializeFails<int_tree>(descending.str()));
+
+    const std::string valid = binary.str();
+    assert(deserializeFails<int_tree>(""));
+    assert(deserializeFails<int_tree>("not a tree"));
+    assert(deserializeFails<int_tree>(valid.substr(0, valid.size() / 2)));
+    assert(deserializeFails<int_tree>(valid.substr(0, valid.size() - 1)));
+    // deserialize si ferma dopo il blocco finale: più alberi possono seguirsi nello stesso flusso
+    std::istringstream twice(valid + descending.str());
+    int_tree first;
+    reversed_tree second;
+    first.deserialize(twice);
+    second.deserialize(twice);
+    assert(first.size() == bst.size() && second.size() == 2 && *second.begin() == 2);
+    std::string wrongCount = valid;
+    wrongCount[5] = static_cast<char>(wrongCount[5] ^ 1);
+    assert(deserializeFails<int_tree>(wrongCount));
+
+    BinarySearchTree<Person, compare_person, equal_person, avl_balance> people;
+    for (int i = 0; i < 200; ++i) {
+        people.insert(Person(i * 37 % 200 - 100, "Persona " + std::to_string(i)));
+    }
+    std::ostringstream peopleOut;
+    people.serialize(peopleOut);
+    BinarySearchTree<Person, compare_person, equal_person, avl_balance> peopleCopy;
+    std::istringstream peopleIn(peopleOut.str());
+    peopleCopy.deserialize(peopleIn);
+    assert(peopleCopy.size() == 200);
+    BinarySearchTree<Person, compare_person, equal_person, avl_balance>::const_iterator a = people.begin(), b = peopleCopy.begin();
+    for (; a != people.end(); ++a, ++b) {
+        assert(a->id == b->id && a->name == b->name);
+    }
+
+    std::cout << "Test testSerialize: passed" << std::endl
+              << std::endl;
+}
+
+/**
+ * @brief Stampa i valori uno alla volta con operator<< dei valori, come riferimento per dump.
+ */
+template <typename Iter>
+std::string printEach(const std::ostream &format, Iter first, Iter last) {
+    std::ostringstream out;
+    out.copyfmt(format);
+    for (; first != last; ++first) {
+        out << *first << " ";
+    }
+    return out.str();
+}
+
+void testDump() {
+    typedef BinarySearchTree<int, compare_int, equal_int, avl_balance> int_tree;
+    int_tree bst;
+    for (int i = 0; i < 300000; ++i) {
+        bst.insert(static_cast<int>(i * 7919LL % 300000) - 150000);
+    }
+    bst.insert(std::numeric_limits<int>::min());
+    bst.insert(std::numeric_limits<int>::max());
+    std::ostringstream all;
+    all << bst;
+    assert(all.str() == printEach(all, bst.begin(), bst.end()));
+
+    // limite e intervallo di chiavi
+    std::ostringstream first;
+    assert(bst.dump(first, 5) == 5);
+    assert(first.str() == "-2147483648 -150000 -149999 -149998 -149997 ");
+    std::ostringstream range;
+    assert(bst.dump(range, bst.lower_bound(-3), bst.upper_bound(2)) == 6);
+    assert(range.str() == "-3 -2 -1 0 1 2 ");
+    std::ostringstream limited;
+    assert(bst.dump(limited, bst.lower_bound(10), bst.end(), 2) == 2 && limited.str() == "10 11 ");
+    std::ostringstream none;
+    assert(bst.dump(none, bst.lower_bound(150000), bst.upper_bound(500000)) == 0 && none.str().empty());
+
+    // il formato dello stream si applica a tutti i valori, la larghezza solo al primo
+    std::ostringstream formatted;
+    formatted << std::hex << std::showbase << std::uppercase;
+    bst.dump(formatted, bst.lower_bound(-20), bst.upper_bound(20));
+    assert(formatted.str() == printEach(formatted, bst.lower_bound(-20), bst.upper_bound(20)));
+    std::ostringstream signs;
+    signs << std::showpos << std::setw(8);
+    bst.dump(signs, 3);
+    assert(signs.str() == "-2147483648 -150000 -149999 " && signs.width() == 0);
+    std::ostringstream padded;
+    padded << std::setw(8) << std::setfill('*');
+    bst.dump(padded, bst.lower_bound(7), bst.end(), 2);
+    assert(padded.str() == "*******7 8 ");
+
+    std::ostringstream failed;
+    failed.setstate(std::ios_base::badbit);
+    assert(bst.dump(failed) == 0);
+
+    BinarySearchTree<unsigned long long, std::less<unsigned long long>, std::equal_to<unsigned long long> > wide;
+    wide.insert(std::numeric_limits<unsigned long long>::max());
+    wide.insert(0);
+    std::ostringstream wideOut;
+    wideOut << wide;
+    assert(wideOut.str() == "0 18446744073709551615 ");
+    BinarySearchTree<short, std::less<short>, std::equal_to<short> > shorts;
+    shorts.insert(-32768);
+    shorts.insert(7);
+    std::ostringstream shortOut;
+    shortOut << shorts;
+    assert(shortOut.str() == "-32768 7 ");
+    BinarySearchTree<char, std::less<char>, std::equal_to<char> > chars;
+    chars.insert('b');
+    chars.insert('a');
+    std::ostringstream charOut;
+    charOut << chars;
+    assert(charOut.str() == "a b ");
+    BinarySearchTree<double, std::less<double>, std::equal_to<double> > reals;
+    reals.insert(0.5);
+    reals.insert(-1.25);
+    std::ostringstream realOut;
+    realOut << std::fixed << std::setprecision(1) << reals;
+    assert(realOut.str() == "-1.2 0.5 ");
+
+    BinarySearchTree<Person, compare_person, equal_person, avl_balance> people;
+    for (int i = 0; i < 5000; ++i) {
+        people.insert(Person(i * 37 % 5000, "Persona " + std::to_string(i)));
+    }
+    std::ostringstream peopleOut;
+    peopleOut << people;
+    assert(peopleOut.str() == printEach(peopleOut, people.begin(), people.end()));
+
+    // stampa parallela: stesso output della sequenziale, anche con più gruppi di segmenti
+    for (unsigned threads = 1; threads <= 4; threads += 3) {
+        std::ostringstream parallel;
+        parallel_dump(bst, parallel, threads);
+        assert(parallel.str() == all.str());
+        std::ostringstream parallelPeople;
+        parallel_dump(people, parallelPeople, threads);
+        assert(parallelPeople.str() == peopleOut.str());
+        std::ostringstream even, serialEven;
+        parallel_dump_if(bst, even, [](int v) { return v % 2 == 0; }, threads);
+        std::streambuf *old = std::cout.rdbuf(serialEven.rdbuf());
+        printIF(bst, [](int v) { return v % 2 == 0; });
+        std::cout.rdbuf(old);
+        assert(even.str() == serialEven.str());
+    }
+
+    // printIF si comporta come operator<<: azzera la larghezza e non scrive se lo stream è in errore
+    std::ostringstream widthOut, failOut;
+    std::streambuf *old = std::cout.rdbuf(widthOut.rdbuf());
+    std::cout.width(5);
+    printIF(bst, [](int v) { return v >= 0 && v < 2; });
+    std::cout << "|";
+    std::cout.rdbuf(failOut.rdbuf());
+    std::cout.setstate(std::ios_base::failbit);
+    printIF(bst, [](int v) { return v >= 0 && v < 2; });
+    std::cout.clear();
+    std::cout.rdbuf(old);
+    assert(widthOut.str() == "    0 1 |" && failOut.str().empty());
+
+    std::ostringstream empty;
+    parallel_dump(int_tree(), empty);
+    empty << int_tree();
+    assert(empty.str().empty());
+
+    std::cout << "Test testDump: passed" << std::endl
+              << std::endl;
+}
+
+void testBPlusTreeSimd() {
+    checkBPlusTreeAgainstSet<BPlusTree<int, compare_int, equal_int> >();
+    checkBPlusTreeAgainstSet<BPlusTree<int, compare_int, equal_int, 4> >();
+
+    BPlusTree<int, compare_int, equal_int> tree;
+    for (int i = 0; i < 1000; ++i) {
+        tree.insert(i);
+    }
+    BPlusTree<int, compare_int, equal_int>::const_iterator last = tree.end();
+    --last;
+    assert(*last == 999);
+    assert(tree.contains(2147483647) == false);
+    tree.insert(2147483647);
+    tree.insert(-2147483647 - 1);
+    assert(tree.contains(2147483647) && tree.contains(-2147483647 - 1));
+    assert(*tree.begin() == -2147483647 - 1);
+
+    std::cout << "Test testBPlusTreeSimd: passed" << std::endl
+              << std::endl;
+}
+
+void testBPlusTreeScalar() {
+    checkBPlusTreeAgainstSet<BPlusTree<int, compare_int_three_way, compare_equivalence, 6> >();
+
+    BPlusTree<std::string, std::less<std::string>, std::equal_to<std::string> > names;
+    names.insert("Charlie");
+    names.insert("Alice");
+    names.insert("Bob");
+    assert(!names.insert("Alice").second);
+    assert(names.size() == 3);
+    assert(*names.begin() == "Alice");
+    names.remove("Alice");
+    assert(!names.contains("Alice") && names.contains("Bob"));
+
+    std::cout << "Test testBPlusTreeScalar: passed" << std::endl
+              << std::endl;
+}
+
+/**
+ * @brief Chiave il cui costruttore di default lancia un'eccezione dopo un numero stabilito di costruzioni.
+ *
+ * I nodi del BPlusTree costruiscono di default tutte le chiavi, per cui
+ * l'eccezione simula un'allocazione fallita durante una divisione.
+ */
+struct fragile_key {
+    static int budget; ///< Costruzioni di default consentite prima dell'eccezione, -1 per nessun limite
+    int value;         ///< Valore della chiave
+
+    fragile_key() : value(0) {
+        if (budget == 0) {
+            throw std::runtime_error("fragile_key");
+        }
+        if (budget > 0) {
+            --budget;
+        }
+    }
+
+    fragile_key(int value) : value(value) {}
+};
+
+int fragile_key::budget = -1;
+
+/**
+ * @brief Funtore di confronto per fragile_key.
+ */
+struct compare_fragile_key {
+    bool operator()(const fragile_key &a, const fragile_key &b) const {
+        return a.value < b.value;
+    }
+};
+
+void testBPlusTreeExceptionSafety() {
+    BPlusTree<fragile_key, compare_fragile_key, compare_equivalence, 4> tree;
+    std::set<int> reference;
+    int failures = 0;
+    for (int i = 0; i < 3000; ++i) {
+        int value = i * 7919 % 3001;
+        // ogni nodo costruisce 5 chiavi: un budget piccolo fa fallire la nuova foglia o uno dei nuovi nodi interni
+        fragile_key::budget = i % 23;
+        try {
+            bool inserted = tree.insert(fragile_key(value)).second;
+            assert(inserted == reference.insert(value).second);
+        } catch (const std::runtime_error &) {
+            ++failures;
+        }
+        fragile_key::budget = -1;
+        assert(tree.size() == static_cast<int>(reference.size()));
+    }
+    assert(failures > 0);
+    std::vector<int> values;
+    for (BPlusTree<fragile_key, compare_fragile_key, compare_equivalence, 4>::const_iterator it = tree.begin();
+         it != tree.end(); ++it) {
+        values.push_back(it->value);
+    }
+    assert(values == std::vector<int>(reference.begin(), reference.end()));
+    for (int v = 0; v < 3001; ++v) {
+        assert(tree.contains(fragile_key(v)) == (reference.count(v) == 1));
+        tree.insert(fragile_key(v));
+    }
+    assert(tree.size() == 3001);
+
+    std::cout << "Test testBPlusTreeExceptionSafety: passed" << std::endl
+              << std::endl;
+}
+
+void testConcurrentBinarySearchTree() {
+    typedef ConcurrentBinarySearchTree<int, compare_int, equal_int> Tree;
+    Tree tree;
+    const int writers = 2;
+    const int readers = 4;
+    const int keys = 2000;
+    // i multipli di 4 restano sempre presenti, gli altri valori vanno e vengono
+    for (int v = 0; v < keys; v += 4) {
+        tree.insert(v);
+    }
+
+    std::atomic<bool> done(false);
+    std::atomic<int> failures(0);
+    std::vector<std::thread> threads;
+    for (int r = 0; r < readers; ++r) {
+        threads.push_back(std::thread([&tree, &done, &failures, r]() {
+            unsigned seed = 17u + r;
+            while (!done.load()) {
+                seed = seed * 1103515245u + 12345u;
+                int v = static_cast<int>((seed >> 8) % keys) / 4 * 4;
+                if (!tree.contains(v)) {
+                    ++failures;
+                }
+                int previous = -1;
+                int stable = 0;
+                for (Tree::const_iterator it = tree.begin(); it != tree.end(); ++it) {
+                    if (*it <= previous) {
+                        ++failures;
+                    }
+                    previous = *it;
+                    stable += *it % 4 == 0;
+                }
+                if (stable != keys / 4) {
+                    ++failures;
+                }
+            }
+        }));
+    }
+    for (int w = 0; w < writers; ++w) {
+        threads.push_back(std::thread([&tree, w]() {
+            // ogni scrittore gestisce i valori v % 4 == 2 * w + 1
+            for (int round = 0; round < 6; ++round) {
+                for (int v = 2 * w + 1; v < keys; v += 4) {
+                    tree.insert(v);
+                }
+                for (int v = 2 * w + 1; v < keys; v += 8) {
+                    tree.remove(v);
+                }
+            }
+        }));
+    }
+    for (int w = 0; w < writers; ++w) {
+        threads[readers + w].join();
+    }
+    done.store(true);
+    for (int r = 0; r < readers; ++r) {
+        threads[r].join();
+    }
+
+    assert(failures.load() == 0);
+    std::vector<int> expected;
+    for (int v = 0; v < keys; ++v) {
+        if (v % 4 == 0 || ((v % 4 == 1 || v % 4 == 3) && (v - v % 4) % 8 != 0)) {
+            expected.push_back(v);
+        }
+    }
+    assert(std::vector<int>(tree.begin(), tree.end()) == expected);
+    assert(tree.size() == static_cast<int>(expected.size()));
+    assert(!tree.insert(0) && tree.remove(0) && !tree.contains(0));
+
+    std::cout << "Test testConcurrentBinarySearchTree: passed" << std::endl
+              << std::endl;
+}
+
+void testConcurrentManyReaders() {
+    typedef ConcurrentBinarySearchTree<int, compare_int, equal_int> Tree;
+    Tree tree;
+    const int readers = 72; // più degli slot dei lettori: alcuni thread condividono uno slot
+    const int keys = 512;
+    for (int v = 0; v < keys; v += 2) {
+        tree.insert(v);
+    }
+
+    std::atomic<bool> done(false);
+    std::atomic<int> started(0);
+    std::atomic<int> failures(0);
+    std::vector<std::thread> threads;
+    for (int r = 0; r < readers; ++r) {
+        threads.push_back(std::thread([&tree, &done, &started, &failures, r]() {
+            ++started;
+            unsigned seed = 31u + r;
+            int rounds = 0;
+            while (!done.load() || rounds < 5) {
+                seed = seed * 1103515245u + 12345u;
+                int v = static_cast<int>((seed >> 8) % keys) / 2 * 2;
+                failures += !tree.contains(v);
+                // un iteratore tenuto durante le modifiche vede una versione stabile
+                Tree::const_iterator it = tree.begin();
+                int previous = -1;
+                for (int step = 0; step < 16 && it != tree.end(); ++step, ++it) {
+                    failures += *it <= previous;
+                    previous = *it;
+                }
+                ++rounds;
+            }
+        }));
+    }
+    while (started.load() < readers) {
+        std::this_thread::yield();
+    }
+    for (int round = 0; round < 4; ++round) {
+        for (int v = 1; v < keys; v += 2) {
+            tree.insert(v);
+        }
+        for (int v = 1; v < keys; v += 2) {
+            tree.remove(v);
+        }
+    }
+    done.store(true);
+    for (int r = 0; r < readers; ++r) {
+        threads[r].join();
+    }
+
+    assert(failures.load() == 0);
+    assert(tree.size() == keys / 2);
+    std::cout << "Test testConcurrentManyReaders: passed" << std::endl
+              << std::endl;
+}
+
+void testPersistentSnapshots() {
+    typedef PersistentBinarySearchTree<int, compare_int, equal_int> Tree;
+    Tree tree;
+    for (int i = 0; i < 1000; ++i) {
+        assert(tree.insert(i).second);
+    }
+    assert(!tree.insert(10).second && *tree.insert(10).first == 10);
+
+    Tree snapshot = tree.snapshot();
+    Tree copy(tree);
+    for (int i = 0; i < 1000; i += 2) {
+        tree.remove(i);
+    }
+    tree.insert(5000);
+    copy.insert(-1);
+
+    assert(tree.size() == 501 && snapshot.size() == 1000 && copy.size() == 1001);
+    assert(snapshot.contains(0) && !tree.contains(0) && !snapshot.contains(5000));
+    assert(*copy.begin() == -1 && *snapshot.begin() == 0 && *tree.begin() == 1);
+
+    std::vector<int> expected;
+    for (int i = 0; i < 1000; ++i) {
+        expected.push_back(i);
+    }
+    assert(std::vector<int>(snapshot.begin(), snapshot.end()) == expected);
+    assert(std::vector<int>(snapshot.rbegin(), snapshot.rend()) == std::vector<int>(expected.rbegin(), expected.rend()));
+
+    Tree sub = snapshot.subtree(255);
+    assert(sub.contains(255) && sub.size() > 1);
+    snapshot.clear();
+    assert(sub.contains(255) && snapshot.size() == 0);
+    std::vector<int> values(sub.begin(), sub.end());
+    assert(std::is_sorted(values.begin(), values.end()) && static_cast<int>(values.size()) == sub.size());
+    assert(tree.subtree(0).size() == 0);
+
+    std::cout << "Test testPersistentSnapshots: passed" << std::endl
+              << std::endl;
+}
+
+void testPersistentPerson() {
+    PersistentBinarySearchTree<Person, compare_person, equal_person> people;
+    people.insert(Person(2, "Bob"));
+    people.insert(Person(1, "Alice"));
+    PersistentBinarySearchTree<Person, compare_person, equal_person> before = people;
+    people.insert(Person(3, "Charlie"));
+    people.remove(Person(1, ""));
+
+    assert(before.size() == 2 && before.find(Person(1, ""))->name == "Alice");
+    assert(people.size() == 2 && people.find(Person(1, "")) == people.end());
+    assert(people.contains(Person(3, "Charlie")) && !before.contains(Person(3, "Charlie")));
+
+    std::cout << "Test testPersistentPerson: passed" << std::endl
+              << std::endl;
+}
+
 int main() {
     testDuplicateInsertAsRoot();
     testDuplicateInsertInsideTree();
@@ -622,8 +2464,11 @@ int main() {
     testDuplicateInsertInsideTreePerson();
     testDuplicateInsertAsLeafPerson();
     testDuplicatePersonIdInsert();
+    testInsertReturnValue();
+    testInsertDuplicateKeepsRvaluePerson();
 
     testContainsPerson();
+    testCompareEquivalence();
     testSizePerson();
 
     testRemoveRootPerson();
@@ -637,10 +2482,18 @@ int main() {
     testAssignmentEmptyToPopulatedPerson();
     testAssignmentPopulatedToEmptyPerson();
 
+    testMoveConstructorPerson();
+    testMoveAssignmentPerson();
+    testMoveNoexcept();
+    testEmplacePerson();
+
     testEmptyTreeIterator();
     testSingleElementTreeIterator();
     testMultiElementTreeIterator();
+    testReverseIterator();
     testConstructorWithIterators();
+    testConstructorSortedUnique();
+    testConstructorUnsortedDuplicatesPerson();
 
     testPrintIF();
     testPrintIFPerson();
@@ -650,5 +2503,52 @@ int main() {
     testSubtreeLeaf();
     testSubtreeNotFound();
 
+    testAvlSortedInsert();
+    testAvlRemove();
+    testAvlSubtreePerson();
+
+    testOrderStatistics();
+    testOrderStatisticsUnbalancedPerson();
+
+    testPoolAllocator();
+    testPoolAllocatorPerson();
+
+    testInsertHint();
+    testDeepSkewedTree();
+
+    testFreeze();
+    testFreezePerson();
+
+    testRangeQueries();
+    testRangeQueriesPerson();
+
+    testParallelScan();
+
+    testSetAlgebra();
+    testSetAlgebraPerson();
+
+    testSplitJoin();
+    testSplitJoinPerson();
+
+    testBatchLookup();
+    testBatchUpdate();
+    testNodeHandles();
+
+    testCompactBinarySearchTree();
+
+    testMappedFile();
+    testSerialize();
+    testDump();
+
+    testBPlusTreeSimd();
+    testBPlusTreeScalar();
+    testBPlusTreeExceptionSafety();
+
+    testConcurrentBinarySearchTree();
+    testConcurrentManyReaders();
+
+    testPersistentSnapshots();
+    testPersistentPerson();
+
     return 0;
 }
\ No newline at end of file